@@ -0,0 +1,227 @@
+#!/usr/bin/env python3
+#
+# Headless boot time benchmark for L5, run by `make bench'.
+#
+# For each kernel size a synthetic kernel (kernel.c) is linked
+# with padding, put on a FAT disk image next to the loader and
+# an l5.cfg that boots at once with logging on COM1. Every run
+# boots QEMU+OVMF without a display and waits for the kernel's
+# serial sentinel. The wall clock from QEMU start to the sentinel
+# and the phase table L5 prints before handoff are collected, and
+# percentiles over all runs are written out as JSON.
+#
+
+import argparse
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SENTINEL = b"L5-BENCH-ENTRY"
+PHASES_HDR = "** boot phases (us):"
+
+L5_CFG = """\
+timeout = 0
+serial = com1
+log = info
+"""
+
+
+def parse_size(s):
+    units = {"K": 1 << 10, "M": 1 << 20, "G": 1 << 30}
+    s = s.strip().upper()
+    if s[-1] in units:
+        return int(s[:-1]) * units[s[-1]]
+    return int(s)
+
+
+def size_name(n):
+    for unit, shift in (("G", 30), ("M", 20), ("K", 10)):
+        if n >= 1 << shift and n % (1 << shift) == 0:
+            return "%d%s" % (n >> shift, unit)
+    return str(n)
+
+
+def run(cmd, **kw):
+    subprocess.run(cmd, check=True, **kw)
+
+
+def build_kernel(cc, size, out):
+    pad = max(size - 0x2000, 0)
+    run([cc, "-target", "x86_64-unknown-none-elf", "-ffreestanding",
+         "-fno-pic", "-fno-pie", "-mcmodel=kernel", "-mno-red-zone",
+         "-mgeneral-regs-only", "-nostdlib", "-static", "-O2",
+         "-fuse-ld=lld", "-Wl,-T," + os.path.join(HERE, "kernel.ld"),
+         "-Wl,--defsym=PAD_SIZE=%d" % pad, "-Wl,-z,max-page-size=4096",
+         "-o", out, os.path.join(HERE, "kernel.c")])
+
+
+def build_disk(loader, kernel, workdir, out):
+    cfg = os.path.join(workdir, "l5.cfg")
+    with open(cfg, "w") as f:
+        f.write(L5_CFG)
+
+    # FAT32 wants at least 32 MiB, leave some slack on top
+    ksize = os.path.getsize(kernel)
+    mib = (ksize >> 20) + 64
+    with open(out, "wb") as f:
+        f.truncate(mib << 20)
+
+    run(["mformat", "-i", out, "-F", "-T", str((mib << 20) // 512),
+         "-h", "64", "-s", "32", "::"])
+    run(["mmd", "-i", out, "::/EFI", "::/EFI/BOOT"])
+    run(["mcopy", "-i", out, loader, "::/EFI/BOOT/BOOTX64.EFI"])
+    run(["mcopy", "-i", out, kernel, "::/l5"])
+    run(["mcopy", "-i", out, cfg, "::/l5.cfg"])
+
+
+def parse_phases(text):
+    phases = {}
+    lines = text.splitlines()
+    for i, line in enumerate(lines):
+        if line.strip() != PHASES_HDR:
+            continue
+        for row in lines[i + 1:]:
+            # Names may have spaces, the time is the first number
+            fields = row.split()
+            num = [j for j, f in enumerate(fields) if f.rstrip(",").isdigit()]
+            if not num or num[0] == 0:
+                break
+            name = " ".join(fields[:num[0]])
+            phases[name] = int(fields[num[0]].rstrip(","))
+            if name == "total":
+                break
+    return phases
+
+
+def boot(args, disk):
+    cmd = [args.qemu, "-m", args.mem, "-no-reboot", "-display", "none",
+           "-monitor", "none", "-serial", "stdio",
+           "-device", "isa-debug-exit,iobase=0xf4,iosize=0x04",
+           "-drive", "if=pflash,format=raw,unit=0,readonly=on,file=" +
+           args.ovmf,
+           "-drive", "format=raw,file=" + disk]
+    if args.accel:
+        cmd += ["-accel", args.accel]
+
+    start = time.monotonic()
+    proc = subprocess.Popen(cmd, stdout=subprocess.PIPE,
+                            stderr=subprocess.DEVNULL)
+    out = b""
+    wall = None
+    os.set_blocking(proc.stdout.fileno(), False)
+    while time.monotonic() - start < args.timeout:
+        chunk = proc.stdout.read()
+        if chunk:
+            out += chunk
+            if wall is None and SENTINEL in out:
+                wall = time.monotonic() - start
+        elif proc.poll() is not None:
+            break
+        else:
+            time.sleep(0.001)
+
+    if proc.poll() is None:
+        proc.kill()
+    proc.wait()
+
+    text = out.decode("ascii", "replace").replace("\r", "")
+    return wall, parse_phases(text)
+
+
+def percentiles(vals):
+    vals = sorted(vals)
+    if not vals:
+        return None
+
+    def pct(p):
+        # Nearest rank
+        k = max(0, min(len(vals) - 1, -(-p * len(vals) // 100) - 1))
+        return vals[k]
+
+    return {"n": len(vals), "min": vals[0], "p50": pct(50), "p90": pct(90),
+            "p99": pct(99), "max": vals[-1]}
+
+
+def git_rev():
+    try:
+        return subprocess.run(["git", "rev-parse", "HEAD"], cwd=HERE,
+                              capture_output=True, text=True,
+                              check=True).stdout.strip()
+    except (OSError, subprocess.CalledProcessError):
+        return None
+
+
+def main():
+    ap = argparse.ArgumentParser(description="L5 headless boot benchmark")
+    ap.add_argument("--loader", required=True, help="BOOTX64.EFI to test")
+    ap.add_argument("--ovmf", required=True, help="OVMF firmware image")
+    ap.add_argument("--sizes", default="1M,16M,128M,1G",
+                    help="comma separated kernel sizes")
+    ap.add_argument("--runs", type=int, default=10)
+    ap.add_argument("--qemu", default="qemu-system-x86_64")
+    ap.add_argument("--accel", default=os.environ.get("BENCH_ACCEL"),
+                    help="QEMU accelerator, e.g. kvm")
+    ap.add_argument("--mem", default="4G")
+    ap.add_argument("--cc", default="clang")
+    ap.add_argument("--timeout", type=float, default=120.0,
+                    help="seconds before a run counts as failed")
+    ap.add_argument("--out", help="write JSON here instead of stdout")
+    args = ap.parse_args()
+
+    for tool in (args.qemu, args.cc, "mformat", "mcopy", "mmd"):
+        if shutil.which(tool) is None:
+            sys.exit("bench: %s not found" % tool)
+
+    results = []
+    with tempfile.TemporaryDirectory(prefix="l5bench.") as work:
+        for size in map(parse_size, args.sizes.split(",")):
+            name = size_name(size)
+            kernel = os.path.join(work, "kernel-%s.elf" % name)
+            disk = os.path.join(work, "disk-%s.img" % name)
+            build_kernel(args.cc, size, kernel)
+            build_disk(args.loader, kernel, work, disk)
+
+            walls, phases, failed = [], {}, 0
+            for i in range(args.runs):
+                wall, ph = boot(args, disk)
+                if wall is None:
+                    failed += 1
+                    print("bench: %s run %d: no kernel entry" % (name, i),
+                          file=sys.stderr)
+                    continue
+                walls.append(wall * 1000.0)
+                for k, v in ph.items():
+                    phases.setdefault(k, []).append(v)
+                print("bench: %s run %d: %.1f ms" % (name, i, wall * 1000.0),
+                      file=sys.stderr)
+
+            results.append({
+                "size": size,
+                "name": name,
+                "failed": failed,
+                "wall_ms": percentiles(walls),
+                "phases_us": {k: percentiles(v) for k, v in phases.items()},
+            })
+            os.unlink(disk)
+
+    report = {"rev": git_rev(), "runs": args.runs, "accel": args.accel,
+              "results": results}
+    if args.out:
+        with open(args.out, "w") as f:
+            json.dump(report, f, indent=2)
+            f.write("\n")
+    else:
+        json.dump(report, sys.stdout, indent=2)
+        print()
+
+    if any(r["failed"] for r in results):
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,52 @@
+/*
+ * Synthetic kernel for `make bench'. It does nothing but
+ * tell the host it was entered, over COM1 which L5 has
+ * already set up, and then shut QEMU down through the
+ * isa-debug-exit device. Its size comes from padding
+ * added at link time, see kernel.ld.
+ */
+
+#include <stdint.h>
+
+#define COM1            0x3F8
+#define COM1_LSR        (COM1 + 5)
+#define DEBUG_EXIT      0xF4
+
+#define SENTINEL        "\r\nL5-BENCH-ENTRY\r\n"
+
+static inline uint8_t
+inb(uint16_t port)
+{
+    uint8_t v;
+
+    __asm__ __volatile__("inb %1, %0" : "=a" (v) : "Nd" (port));
+    return v;
+}
+
+static inline void
+outb(uint16_t port, uint8_t v)
+{
+    __asm__ __volatile__("outb %0, %1" : : "a" (v), "Nd" (port));
+}
+
+static void
+serial_puts(const char *s)
+{
+    for (; *s != '\0'; ++s) {
+        while ((inb(COM1_LSR) & 0x20) == 0);
+        outb(COM1, *s);
+    }
+}
+
+void
+_start(void *proto)
+{
+    (void)proto;
+
+    serial_puts(SENTINEL);
+    outb(DEBUG_EXIT, 0x00);
+
+    for (;;) {
+        __asm__ __volatile__("cli; hlt");
+    }
+}
@@ -0,0 +1,332 @@
+/*
+ * Host benchmark for the loader's memcpy(), memset() and
+ * memcmp(), run by `make bench-string'. It links the very
+ * same variants the loader uses (platform/amd64/string.c)
+ * and compares every one this CPU can run with the host
+ * libc over a range of sizes and alignments:
+ *
+ *   bench-string [-m max] [-t ms]
+ *
+ * Every variant is checked against libc before it is
+ * timed, a mismatch makes the benchmark fail. Results
+ * are the best of a few runs in GB/s.
+ */
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <string.h>
+#include <cdefs.h>
+#include <machine/string.h>
+
+#define BENCH_MAX       (64UL * 1024 * 1024)
+#define BENCH_MS        20
+#define BENCH_RUNS      3
+
+/* Buffers are at least this big for check() */
+#define BENCH_CHECK_MAX (128 * 1024)
+
+/* Room for the misalignment on both buffers */
+#define BENCH_SLACK     64
+
+typedef void *(*copy_fn_t)(void *, const void *, size_t);
+typedef void *(*fill_fn_t)(void *, int, size_t);
+typedef int (*cmp_fn_t)(const void *, const void *, size_t);
+
+/*
+ * A pair of misalignments
+ *
+ * @dst: Offset of the destination from a page
+ * @src: Offset of the source from a page
+ */
+struct bench_align {
+    size_t dst;
+    size_t src;
+};
+
+/* Sizes each variant is checked at, around every edge it has */
+static const size_t check_sizes[] = {
+    0, 1, 3, 7, 8, 15, 16, 31, 32, 63, 64, 65, 100, 127, 128, 255, 511,
+    512, 513, 4095, 4096, 65537
+};
+
+static const struct bench_align aligns[] = {
+    { 0, 0 },
+    { 1, 0 },
+    { 0, 7 },
+    { 13, 29 }
+};
+
+static copy_fn_t libc_memcpy;
+static copy_fn_t libc_memmove;
+static fill_fn_t libc_memset;
+static cmp_fn_t libc_memcmp;
+
+static uint8_t *buf_dst, *buf_src, *buf_ref;
+static size_t max_size = BENCH_MAX;
+static double min_ns = BENCH_MS * 1e6;
+static int failed = 0;
+
+static double
+now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void
+usage(void)
+{
+    fprintf(stderr, "usage: bench-string [-m max] [-t ms]\n");
+    exit(2);
+}
+
+static void
+fail(const char *what, const char *variant, size_t n, size_t dst,
+    size_t src)
+{
+    fprintf(stderr, "bench-string: %s %s wrong, %zu bytes at +%zu/+%zu\n",
+        what, variant, n, dst, src);
+    failed = 1;
+}
+
+static const char *
+size_name(size_t n, char *buf, size_t len)
+{
+    if (n >= (1 << 20) && n % (1 << 20) == 0) {
+        snprintf(buf, len, "%zuM", n >> 20);
+    } else if (n >= (1 << 10) && n % (1 << 10) == 0) {
+        snprintf(buf, len, "%zuK", n >> 10);
+    } else {
+        snprintf(buf, len, "%zu", n);
+    }
+    return buf;
+}
+
+/*
+ * Fill a buffer with a pattern that differs from
+ * one call to the next.
+ */
+static void
+scribble(uint8_t *p, size_t n, unsigned int seed)
+{
+    for (size_t i = 0; i < n; ++i) {
+        p[i] = (uint8_t)(i * 131 + seed);
+    }
+}
+
+/*
+ * Check one variant against libc
+ *
+ * @name: Variant name, for the errors
+ * @n: Size to check
+ * @ap: Misalignment to check at
+ */
+static void
+check(const char *name, size_t n, const struct bench_align *ap)
+{
+    uint8_t *d = buf_dst + ap->dst, *s = buf_src + ap->src;
+    size_t span = n + BENCH_SLACK;
+    int r1, r2;
+
+    /* The bytes around the destination must not change either */
+    scribble(buf_src, span, 1);
+    scribble(buf_dst, span, 2);
+    libc_memcpy(buf_ref, buf_dst, span);
+    libc_memcpy(buf_ref + ap->dst, s, n);
+    memcpy(d, s, n);
+    if (libc_memcmp(buf_dst, buf_ref, span) != 0) {
+        fail("memcpy", name, n, ap->dst, ap->src);
+    }
+
+    scribble(buf_dst, span, 3);
+    libc_memcpy(buf_ref, buf_dst, span);
+    libc_memset(buf_ref + ap->dst, 0xA5, n);
+    memset(d, 0xA5, n);
+    if (libc_memcmp(buf_dst, buf_ref, span) != 0) {
+        fail("memset", name, n, ap->dst, ap->src);
+    }
+
+    /* Overlapping both ways, a few bytes apart */
+    scribble(buf_dst, span, 4);
+    libc_memcpy(buf_ref, buf_dst, span);
+    libc_memmove(buf_ref + ap->dst, buf_ref + ap->src, n);
+    memmove(buf_dst + ap->dst, buf_dst + ap->src, n);
+    if (libc_memcmp(buf_dst, buf_ref, span) != 0) {
+        fail("memmove", name, n, ap->dst, ap->src);
+    }
+
+    /* Equal, then a difference in the last byte */
+    libc_memcpy(d, s, n);
+    if (n == 0) {
+        return;
+    }
+    if (memcmp(d, s, n) != 0) {
+        fail("memcmp", name, n, ap->dst, ap->src);
+    }
+    d[n - 1] ^= 0x80;
+    r1 = memcmp(d, s, n);
+    r2 = libc_memcmp(d, s, n);
+    if ((r1 < 0) != (r2 < 0) || (r1 == 0) != (r2 == 0)) {
+        fail("memcmp", name, n, ap->dst, ap->src);
+    }
+}
+
+/*
+ * Time one operation, returns GB/s
+ *
+ * @op: 'c' for memcpy, 's' for memset, 'm' for memcmp
+ * @libc: Use libc instead of the loader
+ * @n: Bytes per call
+ * @ap: Misalignment
+ */
+static double
+bench(int op, int libc, size_t n, const struct bench_align *ap)
+{
+    uint8_t *d = buf_dst + ap->dst, *s = buf_src + ap->src;
+    copy_fn_t cpy = libc ? libc_memcpy : memcpy;
+    fill_fn_t set = libc ? libc_memset : memset;
+    cmp_fn_t cmp = libc ? libc_memcmp : memcmp;
+    double start, elapsed, best = 0;
+    size_t iters = 1;
+    volatile int sink;
+
+    libc_memcpy(d, s, n);
+    for (int run = 0; run < BENCH_RUNS; ++run) {
+        for (;;) {
+            start = now_ns();
+            for (size_t i = 0; i < iters; ++i) {
+                switch (op) {
+                case 'c':
+                    cpy(d, s, n);
+                    break;
+                case 's':
+                    set(d, (int)i, n);
+                    break;
+                case 'm':
+                    sink = cmp(d, s, n);
+                    break;
+                }
+            }
+            elapsed = now_ns() - start;
+            if (elapsed >= min_ns / BENCH_RUNS) {
+                break;
+            }
+            iters *= 2;
+        }
+
+        if (best == 0 || n * iters / elapsed > best) {
+            best = n * iters / elapsed;
+        }
+    }
+
+    (void)sink;
+    return best;
+}
+
+static void
+bench_op(int op, const char *name)
+{
+    char sbuf[16];
+    size_t nt_min;
+    int variant;
+
+    printf("\n%s (GB/s)\n%-6s %-7s", name, "size", "align");
+    for (int v = 0; v < STRING_NVARIANT; ++v) {
+        if (string_usable(v)) {
+            printf(" %8s", string_variants[v].name);
+        }
+    }
+    printf(" %8s\n", "libc");
+
+    variant = string_current(&nt_min);
+    for (size_t n = 16; n <= max_size; n *= 4) {
+        for (size_t a = 0; a < ARRAY_SIZE(aligns); ++a) {
+            printf("%-6s %2zu/%-4zu", size_name(n, sbuf, sizeof(sbuf)),
+                aligns[a].dst, aligns[a].src);
+            for (int v = 0; v < STRING_NVARIANT; ++v) {
+                if (string_select(v, nt_min) == 0) {
+                    printf(" %8.2f", bench(op, 0, n, &aligns[a]));
+                }
+            }
+            printf(" %8.2f\n", bench(op, 1, n, &aligns[a]));
+            fflush(stdout);
+        }
+    }
+
+    string_select(variant, nt_min);
+}
+
+int
+main(int argc, char **argv)
+{
+    size_t nt_min, size;
+    int opt, variant;
+
+    while ((opt = getopt(argc, argv, "m:t:")) != -1) {
+        switch (opt) {
+        case 'm':
+            max_size = strtoul(optarg, NULL, 0);
+            break;
+        case 't':
+            min_ns = strtoul(optarg, NULL, 0) * 1e6;
+            break;
+        default:
+            usage();
+        }
+    }
+    if (optind != argc || max_size < 16 || min_ns <= 0) {
+        usage();
+    }
+
+    /* Ours override libc's in this executable */
+    libc_memcpy = (copy_fn_t)dlsym(RTLD_NEXT, "memcpy");
+    libc_memmove = (copy_fn_t)dlsym(RTLD_NEXT, "memmove");
+    libc_memset = (fill_fn_t)dlsym(RTLD_NEXT, "memset");
+    libc_memcmp = (cmp_fn_t)dlsym(RTLD_NEXT, "memcmp");
+    if (libc_memcpy == NULL || libc_memmove == NULL || libc_memset == NULL ||
+        libc_memcmp == NULL) {
+        fprintf(stderr, "bench-string: no libc string functions\n");
+        return 1;
+    }
+
+    size = (max_size > BENCH_CHECK_MAX) ? max_size : BENCH_CHECK_MAX;
+    buf_dst = aligned_alloc(4096, size + 4096);
+    buf_src = aligned_alloc(4096, size + 4096);
+    buf_ref = aligned_alloc(4096, size + 4096);
+    if (buf_dst == NULL || buf_src == NULL || buf_ref == NULL) {
+        fprintf(stderr, "bench-string: out of memory\n");
+        return 1;
+    }
+
+    variant = string_init();
+    string_current(&nt_min);
+    printf("picked %s, non-temporal fills from %zu KiB\n",
+        string_variants[variant].name, nt_min / 1024);
+
+    /* Small thresholds so the big paths see odd sizes too */
+    for (int v = 0; v < STRING_NVARIANT; ++v) {
+        if (string_select(v, 4096) != 0) {
+            continue;
+        }
+        for (size_t i = 0; i < ARRAY_SIZE(check_sizes); ++i) {
+            for (size_t a = 0; a < ARRAY_SIZE(aligns); ++a) {
+                check(string_variants[v].name, check_sizes[i], &aligns[a]);
+            }
+        }
+    }
+    string_select(variant, nt_min);
+    if (failed) {
+        return 1;
+    }
+
+    bench_op('c', "memcpy");
+    bench_op('s', "memset");
+    bench_op('m', "memcmp");
+    return 0;
+}
@@ -0,0 +1,291 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <efi.h>
+#include <string.h>
+#include <cdefs.h>
+#include <lfive/acpi.h>
+#include <lfive/arena.h>
+#include <lfive/log.h>
+
+/* Smallest RSDP, as of ACPI 1.0 */
+#define RSDP_V1_SIZE 20
+
+/* FADT fields pointing at tables not in the XSDT */
+#define FADT_FACS       36
+#define FADT_DSDT       40
+#define FADT_X_FACS     132
+#define FADT_X_DSDT     140
+
+static rsdp_t *rsdp = NULL;
+static struct l5_acpi_ent *slots = NULL;
+static uint32_t nslot = 0;
+static uint32_t nent = 0;
+
+/*
+ * Check that bytes sum up to zero
+ *
+ * @p: Bytes to check
+ * @len: Number of bytes
+ */
+static int
+acpi_checksum(const void *p, size_t len)
+{
+    const uint8_t *bp = p;
+    uint8_t sum = 0;
+
+    for (size_t i = 0; i < len; ++i) {
+        sum += bp[i];
+    }
+
+    return (sum == 0) ? 0 : -1;
+}
+
+/*
+ * Check two GUIDs for equality
+ */
+static int
+acpi_guid_eq(EFI_GUID *a, EFI_GUID *b)
+{
+    return memcmp(a, b, sizeof(*a)) == 0;
+}
+
+/*
+ * Find the RSDP in the EFI configuration table,
+ * ACPI 2.0+ is preferred.
+ */
+static rsdp_t *
+acpi_find_rsdp(void)
+{
+    EFI_GUID acpi20 = EFI_ACPI_20_TABLE_GUID;
+    EFI_GUID acpi10 = ACPI_10_TABLE_GUID;
+    EFI_CONFIGURATION_TABLE *ct;
+    rsdp_t *res = NULL;
+
+    for (uintn_t i = 0; i < g_systab->number_of_table_entries; ++i) {
+        ct = &g_systab->configuration_table[i];
+        if (acpi_guid_eq(&ct->vendor_guid, &acpi20)) {
+            return ct->vendor_table;
+        }
+        if (acpi_guid_eq(&ct->vendor_guid, &acpi10)) {
+            res = ct->vendor_table;
+        }
+    }
+
+    return res;
+}
+
+/*
+ * Add a table to the index, tables that fail their
+ * checksum are left out.
+ *
+ * @addr: Physical address of the table
+ * @check: Whether the table has a checksum
+ *
+ * Returns zero if the table was added
+ */
+static int
+acpi_add(uintptr_t addr, int check)
+{
+    sdth_t *hdr = (sdth_t *)addr;
+    struct l5_acpi_ent *ent;
+    uint32_t instance = 0;
+    uint32_t mask = nslot - 1;
+    uint32_t i;
+
+    if (addr == 0 || nent >= nslot / 2) {
+        return -1;
+    }
+
+    if (check && acpi_checksum(hdr, hdr->length) != 0) {
+        return -1;
+    }
+
+    /* Tables sharing a signature get the next instance */
+    for (;;) {
+        i = l5_acpi_hash(hdr->signature, instance) & mask;
+        while (slots[i].sig != 0) {
+            if (slots[i].sig == hdr->signature &&
+                slots[i].instance == instance) {
+                break;
+            }
+            i = (i + 1) & mask;
+        }
+
+        if (slots[i].sig == 0) {
+            break;
+        }
+
+        ++instance;
+    }
+
+    ent = &slots[i];
+    ent->sig = hdr->signature;
+    ent->instance = instance;
+    ent->addr = addr;
+    ent->length = hdr->length;
+    ent->revision = hdr->revision;
+    ++nent;
+    return 0;
+}
+
+/*
+ * Add the DSDT and FACS, these hang off the FADT
+ * instead of the XSDT.
+ *
+ * @fadt: The FADT
+ */
+static void
+acpi_add_fadt(sdth_t *fadt)
+{
+    uint8_t *p = (uint8_t *)fadt;
+    uint64_t dsdt = 0, facs = 0;
+    uint32_t v32;
+
+    if (fadt->length >= FADT_DSDT + 4) {
+        memcpy(&v32, p + FADT_FACS, sizeof(v32));
+        facs = v32;
+        memcpy(&v32, p + FADT_DSDT, sizeof(v32));
+        dsdt = v32;
+    }
+
+    /* The 64-bit fields win if they are set */
+    if (fadt->length >= FADT_X_FACS + 8) {
+        memcpy(&v32, p + FADT_X_FACS, sizeof(v32));
+        if (v32 != 0) {
+            memcpy(&facs, p + FADT_X_FACS, sizeof(facs));
+        }
+    }
+    if (fadt->length >= FADT_X_DSDT + 8) {
+        memcpy(&v32, p + FADT_X_DSDT, sizeof(v32));
+        if (v32 != 0) {
+            memcpy(&dsdt, p + FADT_X_DSDT, sizeof(dsdt));
+        }
+    }
+
+    /* The FACS has no checksum */
+    acpi_add(dsdt, 1);
+    acpi_add(facs, 0);
+}
+
+int
+acpi_init(void)
+{
+    sdth_t *sdt, *hdr;
+    uint64_t addr;
+    size_t n, entsize;
+    uint32_t want, bad = 0;
+
+    rsdp = acpi_find_rsdp();
+    if (rsdp == NULL) {
+        log_warn("no ACPI tables\n");
+        return -1;
+    }
+
+    if (acpi_checksum(rsdp, RSDP_V1_SIZE) != 0) {
+        log_warn("bad RSDP checksum\n");
+        rsdp = NULL;
+        return -1;
+    }
+
+    /* Use the XSDT where there is one */
+    if (rsdp->revision >= 2 && rsdp->xsdtAddress != 0 &&
+        acpi_checksum(rsdp, rsdp->length) == 0) {
+        sdt = (sdth_t *)rsdp->xsdtAddress;
+        entsize = sizeof(uint64_t);
+    } else {
+        sdt = (sdth_t *)(uintptr_t)rsdp->rsdtAddress;
+        entsize = sizeof(uint32_t);
+    }
+
+    if (acpi_checksum(sdt, sdt->length) != 0) {
+        log_warn("bad XSDT/RSDT checksum\n");
+        rsdp = NULL;
+        return -1;
+    }
+
+    /* Keep the load factor at a half at most */
+    n = (sdt->length - sizeof(*sdt)) / entsize;
+    want = (n + 3) * 2;
+    nslot = 8;
+    while (nslot < want) {
+        nslot <<= 1;
+    }
+
+    slots = arena_alloc(&g_arena, nslot * sizeof(*slots), sizeof(uint64_t));
+    if (slots == NULL) {
+        rsdp = NULL;
+        return -1;
+    }
+
+    memset(slots, 0, nslot * sizeof(*slots));
+    acpi_add((uintptr_t)sdt, 1);
+
+    for (size_t i = 0; i < n; ++i) {
+        addr = 0;
+        memcpy(&addr, (uint8_t *)(sdt + 1) + i * entsize, entsize);
+        if (acpi_add(addr, 1) != 0) {
+            ++bad;
+            continue;
+        }
+
+        hdr = (sdth_t *)addr;
+        if (hdr->signature == L5_ACPI_SIG('F', 'A', 'C', 'P')) {
+            acpi_add_fadt(hdr);
+        }
+    }
+
+    if (bad != 0) {
+        log_warn("** acpi: %u tables, %u bad\n", nent, bad);
+    } else {
+        log_info("** acpi: %u tables\n", nent);
+    }
+    return 0;
+}
+
+size_t
+acpi_tag_size(void)
+{
+    return sizeof(struct l5_tag_acpi) - sizeof(struct l5_tag) +
+        nslot * sizeof(struct l5_acpi_ent);
+}
+
+void
+acpi_fill(struct l5_tag_acpi *tag)
+{
+    if (rsdp == NULL) {
+        return;
+    }
+
+    tag->rsdp = (uintptr_t)rsdp;
+    tag->revision = rsdp->revision;
+    tag->nslot = nslot;
+    tag->nent = nent;
+    memcpy(tag->slot, slots, nslot * sizeof(struct l5_acpi_ent));
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cdefs.h>
+#include <lfive/arena.h>
+#include <lfive/mem.h>
+
+struct arena g_arena;
+
+int
+arena_init(struct arena *ap, uint32_t purpose, size_t npages)
+{
+    uintptr_t base;
+
+    if (ap == NULL || npages == 0) {
+        return -1;
+    }
+
+    if (mem_alloc_pages(purpose, npages, &base) != 0) {
+        return -1;
+    }
+
+    ap->base = base;
+    ap->size = npages * MEM_PAGESIZE;
+    ap->top = 0;
+    ap->peak = 0;
+    return 0;
+}
+
+void *
+arena_alloc(struct arena *ap, size_t size, size_t align)
+{
+    uintptr_t addr;
+
+    if (ap == NULL || ap->base == 0) {
+        return NULL;
+    }
+
+    if (align == 0) {
+        align = sizeof(uint64_t);
+    }
+
+    addr = ALIGN_UP(ap->base + ap->top, align);
+    if (addr + size > ap->base + ap->size) {
+        return NULL;
+    }
+
+    ap->top = (addr + size) - ap->base;
+    if (ap->top > ap->peak) {
+        ap->peak = ap->top;
+    }
+
+    return (void *)addr;
+}
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <cdefs.h>
+#include <lfive/cmdline.h>
+#include <lfive/arena.h>
+#include <lfive/log.h>
+
+static char *raw = NULL;
+static char *strings = NULL;
+static size_t len = 0;
+static struct l5_cmdline_ent *slots = NULL;
+static uint32_t nslot = 0;
+static uint32_t nent = 0;
+
+/*
+ * Add an option to the table, a later option with
+ * the same key replaces the earlier one.
+ *
+ * @key: Offset of the key in `strings'
+ * @value: Offset of the value, or L5_CMDLINE_NOVAL
+ */
+static void
+cmdline_add(uint16_t key, uint16_t value)
+{
+    const char *kp = strings + key;
+    uint32_t mask = nslot - 1;
+    uint32_t h, i;
+
+    h = l5_cmdline_hash(kp, strlen(kp));
+    i = h & mask;
+    while (slots[i].hash != 0) {
+        if (slots[i].hash == h && strcmp(strings + slots[i].key, kp) == 0) {
+            slots[i].value = value;
+            return;
+        }
+
+        i = (i + 1) & mask;
+    }
+
+    slots[i].hash = h;
+    slots[i].key = key;
+    slots[i].value = value;
+    ++nent;
+}
+
+int
+cmdline_init(const char *str)
+{
+    uint16_t keys[CMDLINE_MAX_OPTS];
+    uint16_t values[CMDLINE_MAX_OPTS];
+    size_t nopt = 0, i = 0;
+    char *p;
+
+    len = strlen(str);
+    if (len == 0) {
+        return 0;
+    }
+
+    if (len >= L5_CMDLINE_MAX) {
+        log_warn("command line too long, cut short\n");
+        len = L5_CMDLINE_MAX - 1;
+    }
+
+    raw = arena_alloc(&g_arena, len + 1, 1);
+    strings = arena_alloc(&g_arena, len + 1, 1);
+    if (raw == NULL || strings == NULL) {
+        len = 0;
+        return -1;
+    }
+
+    memcpy(raw, str, len);
+    raw[len] = '\0';
+    memcpy(strings, raw, len + 1);
+
+    /*
+     * Cut the options apart in place, a value in quotes
+     * may hold blanks and loses its quotes.
+     */
+    p = strings;
+    while (i < len && nopt < CMDLINE_MAX_OPTS) {
+        while (i < len && (p[i] == ' ' || p[i] == '\t')) {
+            p[i++] = '\0';
+        }
+        if (i >= len) {
+            break;
+        }
+
+        keys[nopt] = i;
+        values[nopt] = L5_CMDLINE_NOVAL;
+        while (i < len && p[i] != ' ' && p[i] != '\t' && p[i] != '=') {
+            ++i;
+        }
+
+        if (i < len && p[i] == '=') {
+            p[i++] = '\0';
+            if (i < len && p[i] == '"') {
+                p[i++] = '\0';
+                values[nopt] = i;
+                while (i < len && p[i] != '"') {
+                    ++i;
+                }
+            } else {
+                values[nopt] = i;
+                while (i < len && p[i] != ' ' && p[i] != '\t') {
+                    ++i;
+                }
+            }
+
+            if (i < len) {
+                p[i++] = '\0';
+            }
+        }
+
+        ++nopt;
+    }
+
+    /* Keep the load factor at a half at most */
+    nslot = 8;
+    while (nslot < nopt * 2) {
+        nslot <<= 1;
+    }
+
+    slots = arena_alloc(&g_arena, nslot * sizeof(*slots), sizeof(uint32_t));
+    if (slots == NULL) {
+        len = 0;
+        return -1;
+    }
+
+    memset(slots, 0, nslot * sizeof(*slots));
+    for (i = 0; i < nopt; ++i) {
+        cmdline_add(keys[i], values[i]);
+    }
+
+    return 0;
+}
+
+size_t
+cmdline_tag_size(void)
+{
+    if (len == 0) {
+        return 0;
+    }
+
+    return sizeof(struct l5_tag_cmdline) - sizeof(struct l5_tag) +
+        nslot * sizeof(struct l5_cmdline_ent) + (len + 1) * 2;
+}
+
+void
+cmdline_fill(struct l5_tag_cmdline *tag)
+{
+    char *p = (char *)&tag->slot[nslot];
+
+    tag->nslot = nslot;
+    tag->nent = nent;
+    memcpy(tag->slot, slots, nslot * sizeof(struct l5_cmdline_ent));
+
+    tag->raw = p - (char *)tag;
+    memcpy(p, raw, len + 1);
+    p += len + 1;
+
+    tag->strings = p - (char *)tag;
+    memcpy(p, strings, len + 1);
+}
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <cdefs.h>
+#include <lfive/config.h>
+#include <lfive/arena.h>
+#include <lfive/log.h>
+
+/*
+ * A config entry
+ *
+ * @key: NUL terminated key
+ * @value: NUL terminated value
+ */
+struct config_ent {
+    const char *key;
+    const char *value;
+};
+
+static struct config_ent config[CONFIG_MAX_KEYS];
+static size_t nconfig = 0;
+
+/*
+ * Check for blanks around keys and values
+ */
+static inline int
+config_isblank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+/*
+ * Strip blanks from both ends of a string
+ *
+ * @s: String to strip, changed in place
+ */
+static char *
+config_strip(char *s)
+{
+    char *end;
+
+    while (config_isblank(*s)) {
+        ++s;
+    }
+
+    end = s + strlen(s);
+    while (end > s && config_isblank(end[-1])) {
+        *--end = '\0';
+    }
+
+    return s;
+}
+
+/*
+ * Add or replace a config entry
+ *
+ * @key: NUL terminated key
+ * @value: NUL terminated value
+ */
+static void
+config_set(const char *key, const char *value)
+{
+    for (size_t i = 0; i < nconfig; ++i) {
+        if (strcmp(config[i].key, key) == 0) {
+            config[i].value = value;
+            return;
+        }
+    }
+
+    if (nconfig >= CONFIG_MAX_KEYS) {
+        log_warn("config: too many keys\n");
+        return;
+    }
+
+    config[nconfig].key = key;
+    config[nconfig].value = value;
+    ++nconfig;
+}
+
+int
+config_parse(const char *buf, size_t size)
+{
+    char *copy, *line, *next, *eq;
+
+    /* Lines are cut up in place, work on a copy */
+    copy = arena_alloc(&g_arena, size + 1, 1);
+    if (copy == NULL) {
+        return -1;
+    }
+
+    memcpy(copy, buf, size);
+    copy[size] = '\0';
+
+    for (line = copy; line != NULL; line = next) {
+        next = line;
+        while (*next != '\0' && *next != '\n') {
+            ++next;
+        }
+
+        if (*next == '\n') {
+            *next++ = '\0';
+        } else {
+            next = NULL;
+        }
+
+        line = config_strip(line);
+        if (*line == '\0' || *line == '#') {
+            continue;
+        }
+
+        eq = line;
+        while (*eq != '\0' && *eq != '=') {
+            ++eq;
+        }
+
+        if (*eq != '=') {
+            log_warn("config: line without '='\n");
+            continue;
+        }
+
+        *eq = '\0';
+        config_set(config_strip(line), config_strip(eq + 1));
+    }
+
+    return 0;
+}
+
+const char *
+config_get(const char *key)
+{
+    for (size_t i = 0; i < nconfig; ++i) {
+        if (strcmp(config[i].key, key) == 0) {
+            return config[i].value;
+        }
+    }
+
+    return NULL;
+}
+
+uint64_t
+config_get_num(const char *key, uint64_t def)
+{
+    const char *p = config_get(key);
+    uint64_t v = 0, base = 10;
+    char c;
+
+    if (p == NULL || *p == '\0') {
+        return def;
+    }
+
+    if (p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+        base = 16;
+        p += 2;
+    }
+
+    for (; (c = *p) != '\0'; ++p) {
+        if (c >= '0' && c <= '9') {
+            c -= '0';
+        } else if (base == 16 && (c | 0x20) >= 'a' && (c | 0x20) <= 'f') {
+            c = (c | 0x20) - 'a' + 10;
+        } else {
+            return def;
+        }
+        v = v * base + c;
+    }
+
+    return v;
+}
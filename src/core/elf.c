@@ -0,0 +1,401 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <cdefs.h>
+#include <lfive/elf.h>
+#include <lfive/log.h>
+#include <lfive/mem.h>
+#include <lfive/work.h>
+
+/* Give up looking for an aligned home after this many tries */
+#define ELF_MAX_PLACE_TRIES 64
+
+/*
+ * Convert ELF segment flags to MI protection flags
+ */
+static int
+elf_to_prot(Elf64_Word p_flags)
+{
+    int prot = PROT_READ;
+
+    if (ISSET(p_flags, PF_W))
+        prot |= PROT_WRITE;
+    if (ISSET(p_flags, PF_X))
+        prot |= PROT_EXEC;
+
+    return prot;
+}
+
+/*
+ * Get the protection of a virtual range of the image,
+ * ranges not covered by any segment are read-only.
+ *
+ * @ip: Image to look in
+ * @va: Virtual base of the range
+ * @len: Length of the range
+ * @res: Protection is written here
+ *
+ * Returns zero if the whole range has the same
+ * protection, elf_load() makes sure every page has.
+ */
+static int
+elf_range_prot(struct elf_image *ip, uintptr_t va, size_t len, int *res)
+{
+    Elf64_Phdr *phdr;
+    uintptr_t start, end;
+    int prot, seg_prot;
+    int nsegs = 0;
+
+    prot = PROT_READ;
+    for (size_t i = 0; i < ip->ehdr->e_phnum; ++i) {
+        phdr = &ip->phdr[i];
+        if (phdr->p_type != PT_LOAD) {
+            continue;
+        }
+
+        start = ALIGN_DOWN(phdr->p_vaddr, MEM_PAGESIZE);
+        end = ALIGN_UP(phdr->p_vaddr + phdr->p_memsz, MEM_PAGESIZE);
+        if (end <= va || start >= va + len) {
+            continue;
+        }
+
+        seg_prot = elf_to_prot(phdr->p_flags);
+        if (nsegs++ > 0 && seg_prot != prot) {
+            return -1;
+        }
+
+        prot = seg_prot;
+    }
+
+    *res = prot;
+    return 0;
+}
+
+/*
+ * Find a physical home for the image in the memory map
+ *
+ * @map: Memory map to look in
+ * @nent: Number of entries in `map'
+ * @npages: Number of pages needed
+ * @align: Alignment needed
+ * @res: Physical base is written here
+ *
+ * Returns zero on success
+ */
+static int
+elf_place(struct l5_mementry *map, size_t nent, size_t npages, size_t align,
+    uintptr_t *res)
+{
+    struct l5_mementry *ent;
+    uintptr_t base, end;
+    size_t len = npages * MEM_PAGESIZE;
+    int tries = 0;
+
+    for (size_t i = 0; i < nent; ++i) {
+        ent = &map[i];
+        if (ent->type != L5_MEM_USABLE) {
+            continue;
+        }
+        if (ISSET(ent->flags, L5_MEMF_BOOTSRV)) {
+            continue;
+        }
+
+        /* Never place anything at zero */
+        base = ALIGN_UP(ent->base, align);
+        base = (base == 0) ? align : base;
+        end = ent->base + ent->npages * MEM_PAGESIZE;
+
+        /*
+         * Our view of the map may be stale, let firmware
+         * tell us if a slot is still free.
+         */
+        for (; base + len <= end; base += align) {
+            if (tries++ >= ELF_MAX_PLACE_TRIES) {
+                return -1;
+            }
+
+            if (mem_alloc_at(L5_MEMP_KERNEL, base, npages) == 0) {
+                *res = base;
+                return 0;
+            }
+        }
+    }
+
+    return -1;
+}
+
+int
+elf_check(void *img, size_t size)
+{
+    Elf64_Ehdr *ehdr = img;
+    size_t phdrs_end;
+
+    if (size < sizeof(*ehdr)) {
+        return -1;
+    }
+
+    if (memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0) {
+        return -1;
+    }
+
+    if (ehdr->e_ident[EI_CLASS] != ELFCLASS64) {
+        return -1;
+    }
+    if (ehdr->e_ident[EI_DATA] != ELFDATA2LSB) {
+        return -1;
+    }
+    if (ehdr->e_type != ET_EXEC || ehdr->e_machine != EM_X86_64) {
+        return -1;
+    }
+    if (ehdr->e_phentsize != sizeof(Elf64_Phdr)) {
+        return -1;
+    }
+
+    phdrs_end = ehdr->e_phoff + ehdr->e_phnum * sizeof(Elf64_Phdr);
+    if (phdrs_end > size) {
+        return -1;
+    }
+
+    return 0;
+}
+
+void *
+elf_find_note(void *img, size_t size, const char *name, uint32_t type,
+    size_t *descsz_res)
+{
+    Elf64_Ehdr *ehdr = img;
+    Elf64_Phdr *phdr;
+    Elf64_Nhdr *nhdr;
+    uint8_t *p, *end, *note_name;
+    size_t namesz = 0;
+
+    while (name[namesz] != '\0') {
+        ++namesz;
+    }
+
+    for (size_t i = 0; i < ehdr->e_phnum; ++i) {
+        phdr = (Elf64_Phdr *)((uint8_t *)img + ehdr->e_phoff) + i;
+        if (phdr->p_type != PT_NOTE) {
+            continue;
+        }
+        if (phdr->p_offset + phdr->p_filesz > size) {
+            continue;
+        }
+
+        /* Names and payloads are padded to 4 bytes */
+        p = (uint8_t *)img + phdr->p_offset;
+        end = p + phdr->p_filesz;
+        while (p + sizeof(*nhdr) <= end) {
+            nhdr = (Elf64_Nhdr *)p;
+            note_name = p + sizeof(*nhdr);
+            p = note_name + ALIGN_UP(nhdr->n_namesz, 4);
+            if (p + nhdr->n_descsz > end) {
+                break;
+            }
+
+            /* n_namesz counts the NUL */
+            if (nhdr->n_type == type && nhdr->n_namesz == namesz + 1 &&
+                memcmp(note_name, name, namesz) == 0) {
+                *descsz_res = nhdr->n_descsz;
+                return p;
+            }
+
+            p += ALIGN_UP(nhdr->n_descsz, 4);
+        }
+    }
+
+    return NULL;
+}
+
+int
+elf_load(void *img, size_t size, struct l5_mementry *map, size_t nent,
+    struct elf_image *res)
+{
+    Elf64_Ehdr *ehdr = img;
+    Elf64_Phdr *phdr;
+    uintptr_t vmin = (uintptr_t)-1, vmax = 0;
+    uintptr_t dest, zero, end;
+    size_t align = MEM_2MIB;
+    int error, prot, last_prot = 0;
+
+    if (res == NULL || elf_check(img, size) != 0) {
+        return -1;
+    }
+
+    res->ehdr = ehdr;
+    res->phdr = (Elf64_Phdr *)((uint8_t *)img + ehdr->e_phoff);
+    res->entry = ehdr->e_entry;
+
+    /* Get the span of the image */
+    for (size_t i = 0; i < ehdr->e_phnum; ++i) {
+        phdr = &res->phdr[i];
+        if (phdr->p_type != PT_LOAD) {
+            continue;
+        }
+
+        if (phdr->p_offset + phdr->p_filesz > size) {
+            return -1;
+        }
+        if (phdr->p_filesz > phdr->p_memsz) {
+            return -1;
+        }
+
+        /* Sorted and apart, as the ELF spec has it */
+        if (phdr->p_vaddr < vmax) {
+            return -1;
+        }
+
+        /*
+         * A page takes the protection of a single segment,
+         * anything else would have to make it RWX.
+         */
+        prot = elf_to_prot(phdr->p_flags);
+        if (vmax != 0 && prot != last_prot &&
+            ALIGN_DOWN(phdr->p_vaddr, MEM_PAGESIZE) <
+            ALIGN_UP(vmax, MEM_PAGESIZE)) {
+            log_err("kernel: segment at %p shares a page with the last\n",
+                (void *)phdr->p_vaddr);
+            return -1;
+        }
+
+        last_prot = prot;
+
+        if (phdr->p_vaddr < vmin)
+            vmin = phdr->p_vaddr;
+        if (phdr->p_vaddr + phdr->p_memsz > vmax)
+            vmax = phdr->p_vaddr + phdr->p_memsz;
+        if (phdr->p_align >= MEM_1GIB)
+            align = MEM_1GIB;
+    }
+
+    if (vmax <= vmin) {
+        return -1;
+    }
+
+    /*
+     * Pad the image out to a whole huge page so that
+     * its tail can be mapped with one too.
+     */
+    res->vbase = ALIGN_DOWN(vmin, align);
+    res->npages = ALIGN_UP(vmax - res->vbase, MEM_2MIB) / MEM_PAGESIZE;
+    res->align = align;
+
+    error = elf_place(map, nent, res->npages, align, &res->pbase);
+    if (error != 0 && align > MEM_2MIB) {
+        log_warn("kernel: no 1 GiB home, trying 2 MiB\n");
+        res->vbase = ALIGN_DOWN(vmin, MEM_2MIB);
+        res->npages = ALIGN_UP(vmax - res->vbase, MEM_2MIB) / MEM_PAGESIZE;
+        res->align = MEM_2MIB;
+        error = elf_place(map, nent, res->npages, MEM_2MIB, &res->pbase);
+    }
+
+    /* Last resort, anywhere will do */
+    if (error != 0) {
+        log_warn("kernel: no aligned home, using 4K pages\n");
+        res->vbase = ALIGN_DOWN(vmin, MEM_PAGESIZE);
+        res->npages = ALIGN_UP(vmax - res->vbase, MEM_PAGESIZE) / MEM_PAGESIZE;
+        res->align = MEM_PAGESIZE;
+        error = mem_alloc_pages(L5_MEMP_KERNEL, res->npages, &res->pbase);
+        if (error != 0) {
+            return -1;
+        }
+    }
+
+    /*
+     * Copy in each segment, on every CPU. Everything
+     * else in the image is zeroed, which is the BSS
+     * and the gaps and padding around the segments,
+     * each run of it in one go.
+     */
+    zero = res->pbase;
+    for (size_t i = 0; i < ehdr->e_phnum; ++i) {
+        phdr = &res->phdr[i];
+        if (phdr->p_type != PT_LOAD) {
+            continue;
+        }
+
+        dest = res->pbase + (phdr->p_vaddr - res->vbase);
+        work_zero(L"kernel zero", (void *)zero, dest - zero);
+        work_memcpy(
+            L"kernel copy",
+            (void *)dest,
+            (uint8_t *)img + phdr->p_offset,
+            phdr->p_filesz
+        );
+        zero = dest + phdr->p_filesz;
+    }
+
+    end = res->pbase + res->npages * MEM_PAGESIZE;
+    work_zero(L"kernel zero", (void *)zero, end - zero);
+    return 0;
+}
+
+int
+elf_map(struct elf_image *ip, struct mmu_vas *vas)
+{
+    uintptr_t va, vend;
+    paddr_t pa;
+    int prot, error, huge_ok;
+
+    if (ip == NULL || vas == NULL) {
+        return -1;
+    }
+
+    /* Huge pages need the same offset into the page on both ends */
+    huge_ok = ((ip->pbase - ip->vbase) & (MEM_2MIB - 1)) == 0;
+    vend = ip->vbase + ip->npages * MEM_PAGESIZE;
+
+    va = ip->vbase;
+    while (va < vend) {
+        pa = ip->pbase + (va - ip->vbase);
+
+        if (huge_ok && (va & (MEM_2MIB - 1)) == 0 && va + MEM_2MIB <= vend) {
+            if (elf_range_prot(ip, va, MEM_2MIB, &prot) == 0) {
+                error = mmu_map(vas, va, pa, prot, MAP_HUGE_2MIB);
+                if (error != 0) {
+                    return error;
+                }
+
+                va += MEM_2MIB;
+                continue;
+            }
+        }
+
+        elf_range_prot(ip, va, MEM_PAGESIZE, &prot);
+        error = mmu_map(vas, va, pa, prot, MAP_SMALL_4K);
+        if (error != 0) {
+            return error;
+        }
+
+        va += MEM_PAGESIZE;
+    }
+
+    return 0;
+}
@@ -0,0 +1,356 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <cdefs.h>
+#include <lfive/fbcon.h>
+#include <lfive/font.h>
+#include <lfive/mem.h>
+
+/* Default colors as 0xRRGGBB */
+#define FBCON_FG    0xAAAAAA
+#define FBCON_BG    0x000000
+
+#define FBCON_TABSTOP   8
+
+/* Pixels in a pre-rasterized glyph */
+#define GLYPH_NPIX  (FONT_WIDTH * FONT_HEIGHT)
+
+/* Four pixels at a time, framebuffer rows are only 4-byte aligned */
+typedef uint32_t pixvec_t __attribute__((vector_size(16), aligned(4)));
+
+/*
+ * Framebuffer console state. Text lives in `cells',
+ * a ring of rows so scrolling is a matter of moving
+ * `head'. What is actually on screen is kept in `shown'
+ * and only cells that differ are drawn on a flush.
+ *
+ * @fb: Framebuffer being drawn into
+ * @glyphs: Glyphs rasterized in the console colors
+ * @cells: Ring of text rows, `head' is the top row
+ * @shown: Text currently on screen, by screen row
+ * @dirty_lo: First dirty column of each screen row
+ * @dirty_hi: Last dirty column + 1 of each screen row
+ * @cols: Width in cells
+ * @rows: Height in cells
+ * @head: Row of `cells' shown at the top
+ * @cx: Cursor column
+ * @cy: Cursor row
+ * @active: Set once the console is usable
+ */
+static struct {
+    struct l5_fbinfo fb;
+    uint32_t *glyphs;
+    uint8_t *cells;
+    uint8_t *shown;
+    uint16_t *dirty_lo;
+    uint16_t *dirty_hi;
+    uint32_t cols;
+    uint32_t rows;
+    uint32_t head;
+    uint32_t cx;
+    uint32_t cy;
+    int active;
+} con;
+
+/*
+ * Scale an 8-bit channel value into a pixel mask
+ */
+static uint32_t
+fbcon_chan(uint32_t v, uint32_t mask)
+{
+    uint32_t shift = 0, width = 0;
+
+    if (mask == 0) {
+        return 0;
+    }
+
+    while (!ISSET(mask, 1)) {
+        mask >>= 1;
+        ++shift;
+    }
+    while (ISSET(mask, 1)) {
+        mask >>= 1;
+        ++width;
+    }
+
+    v &= 0xFF;
+    if (width < 8) {
+        v >>= 8 - width;
+    }
+
+    return v << shift;
+}
+
+/*
+ * Convert a 0xRRGGBB color into a pixel
+ */
+static uint32_t
+fbcon_pixel(uint32_t rgb)
+{
+    return fbcon_chan(rgb >> 16, con.fb.red_mask) |
+        fbcon_chan(rgb >> 8, con.fb.green_mask) |
+        fbcon_chan(rgb, con.fb.blue_mask);
+}
+
+/*
+ * Fill a span of pixels with one value
+ *
+ * @dst: First pixel
+ * @n: Number of pixels
+ * @px: Pixel value
+ */
+static void
+fbcon_fill(uint32_t *dst, size_t n, uint32_t px)
+{
+    pixvec_t v = { px, px, px, px };
+
+    for (; n >= 4; n -= 4, dst += 4) {
+        *(pixvec_t *)dst = v;
+    }
+    while (n-- > 0) {
+        *dst++ = px;
+    }
+}
+
+/*
+ * Get the start of a pixel row in the framebuffer
+ */
+static inline uint32_t *
+fbcon_row(uint32_t y)
+{
+    return (uint32_t *)((uint8_t *)con.fb.io + (size_t)y * con.fb.pitch);
+}
+
+/*
+ * Copy a pre-rasterized glyph into a screen cell, one
+ * glyph row is exactly two vector stores.
+ */
+static void
+fbcon_draw(uint32_t col, uint32_t row, uint8_t c)
+{
+    const pixvec_t *src;
+    pixvec_t *dst;
+    uint32_t y;
+
+    src = (pixvec_t *)&con.glyphs[(c - FONT_FIRST) * GLYPH_NPIX];
+    y = row * FONT_HEIGHT;
+
+    for (uint32_t i = 0; i < FONT_HEIGHT; ++i) {
+        dst = (pixvec_t *)(fbcon_row(y + i) + col * FONT_WIDTH);
+        dst[0] = src[0];
+        dst[1] = src[1];
+        src += FONT_WIDTH / 4;
+    }
+}
+
+/*
+ * Get the ring cell for a screen position
+ */
+static inline uint8_t *
+fbcon_cell(uint32_t col, uint32_t row)
+{
+    return &con.cells[((con.head + row) % con.rows) * con.cols + col];
+}
+
+/*
+ * Mark a span of a screen row as needing a redraw
+ */
+static inline void
+fbcon_dirty(uint32_t row, uint32_t lo, uint32_t hi)
+{
+    if (lo < con.dirty_lo[row]) {
+        con.dirty_lo[row] = lo;
+    }
+    if (hi > con.dirty_hi[row]) {
+        con.dirty_hi[row] = hi;
+    }
+}
+
+/*
+ * Draw every dirty cell that differs from what is
+ * already on screen. The framebuffer is never read.
+ */
+static void
+fbcon_flush(void)
+{
+    uint8_t *shown, c;
+
+    for (uint32_t row = 0; row < con.rows; ++row) {
+        shown = &con.shown[row * con.cols];
+        for (uint32_t col = con.dirty_lo[row]; col < con.dirty_hi[row]; ++col) {
+            c = *fbcon_cell(col, row);
+            if (shown[col] != c) {
+                fbcon_draw(col, row, c);
+                shown[col] = c;
+            }
+        }
+
+        con.dirty_lo[row] = con.cols;
+        con.dirty_hi[row] = 0;
+    }
+}
+
+/*
+ * Move everything up a row by advancing the ring,
+ * the whole screen has to be drawn again.
+ */
+static void
+fbcon_scroll(void)
+{
+    memset(fbcon_cell(0, 0), ' ', con.cols);
+    con.head = (con.head + 1) % con.rows;
+
+    for (uint32_t row = 0; row < con.rows; ++row) {
+        fbcon_dirty(row, 0, con.cols);
+    }
+}
+
+static void
+fbcon_newline(void)
+{
+    if (++con.cy >= con.rows) {
+        fbcon_scroll();
+        con.cy = con.rows - 1;
+    }
+}
+
+static void
+fbcon_putc(uint16_t c)
+{
+    switch (c) {
+    case '\r':
+        con.cx = 0;
+        return;
+    case '\n':
+        fbcon_newline();
+        return;
+    case '\b':
+        if (con.cx > 0) {
+            --con.cx;
+        }
+        return;
+    case '\t':
+        con.cx = ALIGN_UP(con.cx + 1, FBCON_TABSTOP);
+        if (con.cx >= con.cols) {
+            con.cx = 0;
+            fbcon_newline();
+        }
+        return;
+    }
+
+    if (c < FONT_FIRST || c > FONT_LAST) {
+        c = '?';
+    }
+
+    if (con.cx >= con.cols) {
+        con.cx = 0;
+        fbcon_newline();
+    }
+
+    *fbcon_cell(con.cx, con.cy) = c;
+    fbcon_dirty(con.cy, con.cx, con.cx + 1);
+    ++con.cx;
+}
+
+void
+fbcon_puts(const uint16_t *s)
+{
+    while (*s != '\0') {
+        fbcon_putc(*s++);
+    }
+
+    fbcon_flush();
+}
+
+int
+fbcon_active(void)
+{
+    return con.active;
+}
+
+int
+fbcon_init(const struct l5_fbinfo *fb)
+{
+    uint32_t fg, bg, *glyph;
+    size_t ncells;
+    uint8_t bits;
+
+    if (fb->io == NULL || fb->bpp != 32) {
+        return -1;
+    }
+
+    con.fb = *fb;
+    con.cols = fb->width / FONT_WIDTH;
+    con.rows = fb->height / FONT_HEIGHT;
+    if (con.cols == 0 || con.rows == 0) {
+        return -1;
+    }
+
+    ncells = (size_t)con.cols * con.rows;
+    con.glyphs = mem_alloc(L5_MEMP_LOADER, FONT_NGLYPH * GLYPH_NPIX * 4);
+    con.cells = mem_alloc(L5_MEMP_LOADER, ncells * 2 + con.rows * 4);
+    if (con.glyphs == NULL || con.cells == NULL) {
+        return -1;
+    }
+
+    con.shown = con.cells + ncells;
+    con.dirty_lo = (uint16_t *)(con.shown + ncells);
+    con.dirty_hi = con.dirty_lo + con.rows;
+
+    /* Glyphs only ever get copied from here on */
+    fg = fbcon_pixel(FBCON_FG);
+    bg = fbcon_pixel(FBCON_BG);
+    glyph = con.glyphs;
+    for (size_t i = 0; i < FONT_NGLYPH; ++i) {
+        for (size_t y = 0; y < FONT_HEIGHT; ++y) {
+            bits = g_font[i][y];
+            for (size_t x = 0; x < FONT_WIDTH; ++x) {
+                *glyph++ = ISSET(bits, 0x80 >> x) ? fg : bg;
+            }
+        }
+    }
+
+    /* A blank screen matches a screen full of spaces */
+    for (uint32_t y = 0; y < fb->height; ++y) {
+        fbcon_fill(fbcon_row(y), fb->width, bg);
+    }
+
+    memset(con.cells, ' ', ncells * 2);
+    for (uint32_t row = 0; row < con.rows; ++row) {
+        con.dirty_lo[row] = con.cols;
+        con.dirty_hi[row] = 0;
+    }
+
+    con.head = 0;
+    con.cx = 0;
+    con.cy = 0;
+    con.active = 1;
+    return 0;
+}
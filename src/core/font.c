@@ -0,0 +1,499 @@
+/*
+ * Copyright 2010-2020 Adobe Systems Incorporated (http://www.adobe.com/),
+ * with Reserved Font Name 'Source'.
+ *
+ * The glyph data below is a Modified Version of Source Code Pro, made by
+ * rasterizing it to 8x16 bitmaps. Unlike the rest of L5 this file is not
+ * under the BSD license: it is Font Software licensed under the SIL Open
+ * Font License, Version 1.1, and may only be distributed under that
+ * license. The full text is in LICENSE.font at the top of the tree, and
+ * is also available with a FAQ at https://openfontlicense.org
+ *
+ * THE FONT SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED. See the license for the full disclaimer.
+ */
+
+#include <lfive/font.h>
+
+/*
+ * 8x16 glyphs for printable ASCII, one byte per row
+ * with the leftmost pixel in the top bit. See the
+ * notice above for where these come from.
+ */
+const uint8_t g_font[FONT_NGLYPH][FONT_HEIGHT] = {
+    /* 0x20 ' ' */
+    {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x21 '!' */
+    {
+        0x00, 0x00, 0x00, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x00, 0x18, 0x18, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x22 '"' */
+    {
+        0x00, 0x00, 0x00, 0x24, 0x24, 0x24, 0x24, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x23 '#' */
+    {
+        0x00, 0x00, 0x00, 0x14, 0x24, 0x7E, 0x24, 0x28,
+        0x7C, 0x28, 0x28, 0x28, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x24 '$' */
+    {
+        0x00, 0x00, 0x10, 0x10, 0x38, 0x40, 0x40, 0x30,
+        0x08, 0x04, 0x44, 0x38, 0x10, 0x10, 0x00, 0x00
+    },
+    /* 0x25 '%' */
+    {
+        0x00, 0x00, 0x00, 0x30, 0x4B, 0x4C, 0x30, 0x06,
+        0x19, 0x29, 0x49, 0x06, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x26 '&' */
+    {
+        0x00, 0x00, 0x00, 0x1C, 0x24, 0x24, 0x28, 0x31,
+        0x49, 0x46, 0x46, 0x3D, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x27 quote */
+    {
+        0x00, 0x00, 0x00, 0x10, 0x10, 0x10, 0x10, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x28 '(' */
+    {
+        0x00, 0x04, 0x08, 0x08, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x08, 0x08, 0x04, 0x00, 0x00, 0x00
+    },
+    /* 0x29 ')' */
+    {
+        0x00, 0x20, 0x10, 0x10, 0x08, 0x08, 0x08, 0x08,
+        0x08, 0x08, 0x10, 0x10, 0x20, 0x00, 0x00, 0x00
+    },
+    /* 0x2A '*' */
+    {
+        0x00, 0x00, 0x00, 0x00, 0x08, 0x08, 0x3E, 0x08,
+        0x14, 0x22, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x2B '+' */
+    {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x10, 0x7C,
+        0x10, 0x10, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x2C ',' */
+    {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x18, 0x18, 0x08, 0x08, 0x10, 0x00
+    },
+    /* 0x2D '-' */
+    {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7E,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x2E '.' */
+    {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x18, 0x18, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x2F '/' */
+    {
+        0x00, 0x00, 0x04, 0x04, 0x04, 0x08, 0x08, 0x08,
+        0x10, 0x10, 0x10, 0x20, 0x20, 0x40, 0x00, 0x00
+    },
+    /* 0x30 '0' */
+    {
+        0x00, 0x00, 0x00, 0x3C, 0x24, 0x42, 0x52, 0x52,
+        0x42, 0x42, 0x24, 0x3C, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x31 '1' */
+    {
+        0x00, 0x00, 0x00, 0x18, 0x08, 0x08, 0x08, 0x08,
+        0x08, 0x08, 0x08, 0x3E, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x32 '2' */
+    {
+        0x00, 0x00, 0x00, 0x38, 0x44, 0x04, 0x04, 0x08,
+        0x08, 0x10, 0x20, 0x7E, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x33 '3' */
+    {
+        0x00, 0x00, 0x00, 0x38, 0x44, 0x04, 0x0C, 0x30,
+        0x0C, 0x04, 0x04, 0x78, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x34 '4' */
+    {
+        0x00, 0x00, 0x00, 0x0C, 0x0C, 0x14, 0x34, 0x24,
+        0x44, 0xFE, 0x04, 0x04, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x35 '5' */
+    {
+        0x00, 0x00, 0x00, 0x3E, 0x20, 0x20, 0x3C, 0x26,
+        0x02, 0x02, 0x46, 0x3C, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x36 '6' */
+    {
+        0x00, 0x00, 0x00, 0x1C, 0x20, 0x40, 0x5C, 0x66,
+        0x42, 0x42, 0x26, 0x1C, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x37 '7' */
+    {
+        0x00, 0x00, 0x00, 0x7E, 0x04, 0x04, 0x08, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x38 '8' */
+    {
+        0x00, 0x00, 0x00, 0x1C, 0x22, 0x22, 0x22, 0x1C,
+        0x62, 0x42, 0x62, 0x3C, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x39 '9' */
+    {
+        0x00, 0x00, 0x00, 0x38, 0x44, 0x42, 0x46, 0x3A,
+        0x02, 0x02, 0x04, 0x38, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x3A ':' */
+    {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x18, 0x18, 0x00,
+        0x00, 0x00, 0x18, 0x18, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x3B ';' */
+    {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x18, 0x18, 0x00,
+        0x00, 0x00, 0x18, 0x18, 0x08, 0x08, 0x10, 0x00
+    },
+    /* 0x3C '<' */
+    {
+        0x00, 0x00, 0x00, 0x00, 0x06, 0x0C, 0x10, 0x20,
+        0x18, 0x0C, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x3D '=' */
+    {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x7E, 0x00, 0x00,
+        0x7E, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x3E '>' */
+    {
+        0x00, 0x00, 0x00, 0x00, 0x60, 0x30, 0x08, 0x04,
+        0x18, 0x30, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x3F '?' */
+    {
+        0x00, 0x00, 0x00, 0x38, 0x24, 0x04, 0x0C, 0x08,
+        0x10, 0x00, 0x18, 0x18, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x40 '@' */
+    {
+        0x00, 0x00, 0x00, 0x1E, 0x33, 0x21, 0x41, 0x4F,
+        0x51, 0x51, 0x4F, 0x20, 0x30, 0x1E, 0x00, 0x00
+    },
+    /* 0x41 'A' */
+    {
+        0x00, 0x00, 0x00, 0x18, 0x18, 0x28, 0x24, 0x24,
+        0x3C, 0x42, 0x42, 0x42, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x42 'B' */
+    {
+        0x00, 0x00, 0x00, 0x78, 0x44, 0x44, 0x44, 0x78,
+        0x46, 0x42, 0x46, 0x7C, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x43 'C' */
+    {
+        0x00, 0x00, 0x00, 0x1C, 0x22, 0x40, 0x40, 0x40,
+        0x40, 0x40, 0x22, 0x1C, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x44 'D' */
+    {
+        0x00, 0x00, 0x00, 0x78, 0x44, 0x42, 0x42, 0x42,
+        0x42, 0x42, 0x44, 0x78, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x45 'E' */
+    {
+        0x00, 0x00, 0x00, 0x7C, 0x40, 0x40, 0x40, 0x7C,
+        0x40, 0x40, 0x40, 0x7C, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x46 'F' */
+    {
+        0x00, 0x00, 0x00, 0x3E, 0x20, 0x20, 0x20, 0x3E,
+        0x20, 0x20, 0x20, 0x20, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x47 'G' */
+    {
+        0x00, 0x00, 0x00, 0x1C, 0x20, 0x40, 0x40, 0x4E,
+        0x42, 0x42, 0x22, 0x1C, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x48 'H' */
+    {
+        0x00, 0x00, 0x00, 0x42, 0x42, 0x42, 0x42, 0x7E,
+        0x42, 0x42, 0x42, 0x42, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x49 'I' */
+    {
+        0x00, 0x00, 0x00, 0x7C, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x10, 0x7C, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x4A 'J' */
+    {
+        0x00, 0x00, 0x00, 0x7C, 0x04, 0x04, 0x04, 0x04,
+        0x04, 0x04, 0x44, 0x38, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x4B 'K' */
+    {
+        0x00, 0x00, 0x00, 0x44, 0x4C, 0x48, 0x50, 0x68,
+        0x68, 0x44, 0x44, 0x42, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x4C 'L' */
+    {
+        0x00, 0x00, 0x00, 0x20, 0x20, 0x20, 0x20, 0x20,
+        0x20, 0x20, 0x20, 0x3E, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x4D 'M' */
+    {
+        0x00, 0x00, 0x00, 0x62, 0x66, 0x66, 0x66, 0x5A,
+        0x5A, 0x42, 0x42, 0x42, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x4E 'N' */
+    {
+        0x00, 0x00, 0x00, 0x42, 0x62, 0x72, 0x52, 0x5A,
+        0x4A, 0x4E, 0x46, 0x42, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x4F 'O' */
+    {
+        0x00, 0x00, 0x00, 0x3C, 0x24, 0x42, 0x42, 0x42,
+        0x42, 0x42, 0x24, 0x3C, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x50 'P' */
+    {
+        0x00, 0x00, 0x00, 0x7C, 0x42, 0x42, 0x46, 0x7C,
+        0x40, 0x40, 0x40, 0x40, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x51 'Q' */
+    {
+        0x00, 0x00, 0x00, 0x18, 0x24, 0x42, 0x42, 0x42,
+        0x42, 0x42, 0x42, 0x24, 0x18, 0x08, 0x06, 0x00
+    },
+    /* 0x52 'R' */
+    {
+        0x00, 0x00, 0x00, 0x7C, 0x42, 0x42, 0x46, 0x7C,
+        0x48, 0x44, 0x44, 0x42, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x53 'S' */
+    {
+        0x00, 0x00, 0x00, 0x3C, 0x40, 0x40, 0x60, 0x1C,
+        0x06, 0x02, 0x42, 0x3C, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x54 'T' */
+    {
+        0x00, 0x00, 0x00, 0xFE, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x10, 0x10, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x55 'U' */
+    {
+        0x00, 0x00, 0x00, 0x42, 0x42, 0x42, 0x42, 0x42,
+        0x42, 0x42, 0x66, 0x3C, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x56 'V' */
+    {
+        0x00, 0x00, 0x00, 0x42, 0x42, 0x44, 0x24, 0x24,
+        0x24, 0x18, 0x18, 0x18, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x57 'W' */
+    {
+        0x00, 0x00, 0x00, 0xC1, 0x41, 0x4B, 0x5A, 0x5A,
+        0x56, 0x56, 0x66, 0x26, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x58 'X' */
+    {
+        0x00, 0x00, 0x00, 0x42, 0x24, 0x24, 0x18, 0x18,
+        0x18, 0x24, 0x24, 0x42, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x59 'Y' */
+    {
+        0x00, 0x00, 0x00, 0xC6, 0x44, 0x44, 0x28, 0x28,
+        0x10, 0x10, 0x10, 0x10, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x5A 'Z' */
+    {
+        0x00, 0x00, 0x00, 0x7E, 0x06, 0x04, 0x08, 0x18,
+        0x10, 0x20, 0x60, 0x7E, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x5B '[' */
+    {
+        0x00, 0x00, 0x1E, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1E, 0x00
+    },
+    /* 0x5C backslash */
+    {
+        0x00, 0x00, 0x40, 0x20, 0x20, 0x20, 0x10, 0x10,
+        0x08, 0x08, 0x08, 0x04, 0x04, 0x04, 0x00, 0x00
+    },
+    /* 0x5D ']' */
+    {
+        0x00, 0x00, 0x78, 0x08, 0x08, 0x08, 0x08, 0x08,
+        0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x78, 0x00
+    },
+    /* 0x5E '^' */
+    {
+        0x00, 0x00, 0x10, 0x18, 0x18, 0x28, 0x24, 0x24,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x5F '_' */
+    {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x7E, 0x00, 0x00
+    },
+    /* 0x60 '`' */
+    {
+        0x00, 0x20, 0x10, 0x08, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x61 'a' */
+    {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x3C, 0x02, 0x02,
+        0x3E, 0x42, 0x46, 0x3A, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x62 'b' */
+    {
+        0x00, 0x00, 0x40, 0x40, 0x40, 0x5C, 0x66, 0x42,
+        0x42, 0x42, 0x44, 0x7C, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x63 'c' */
+    {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x1C, 0x20, 0x40,
+        0x40, 0x40, 0x22, 0x1C, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x64 'd' */
+    {
+        0x00, 0x00, 0x02, 0x02, 0x02, 0x3E, 0x22, 0x42,
+        0x42, 0x42, 0x66, 0x3A, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x65 'e' */
+    {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x3C, 0x26, 0x42,
+        0x7E, 0x40, 0x20, 0x3C, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x66 'f' */
+    {
+        0x00, 0x00, 0x0E, 0x10, 0x10, 0x7E, 0x10, 0x10,
+        0x10, 0x10, 0x10, 0x10, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x67 'g' */
+    {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x3E, 0x44, 0x44,
+        0x44, 0x38, 0x40, 0x3E, 0x42, 0x42, 0x3C, 0x00
+    },
+    /* 0x68 'h' */
+    {
+        0x00, 0x00, 0x40, 0x40, 0x40, 0x5C, 0x62, 0x42,
+        0x42, 0x42, 0x42, 0x42, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x69 'i' */
+    {
+        0x00, 0x00, 0x08, 0x08, 0x00, 0x78, 0x08, 0x08,
+        0x08, 0x08, 0x08, 0x08, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x6A 'j' */
+    {
+        0x00, 0x00, 0x08, 0x08, 0x00, 0x78, 0x08, 0x08,
+        0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x70, 0x00
+    },
+    /* 0x6B 'k' */
+    {
+        0x00, 0x00, 0x40, 0x40, 0x40, 0x44, 0x48, 0x50,
+        0x68, 0x68, 0x44, 0x46, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x6C 'l' */
+    {
+        0x00, 0x00, 0x70, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x10, 0x0E, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x6D 'm' */
+    {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x7F, 0x49, 0x49,
+        0x49, 0x49, 0x49, 0x49, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x6E 'n' */
+    {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x5C, 0x62, 0x42,
+        0x42, 0x42, 0x42, 0x42, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x6F 'o' */
+    {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x3C, 0x66, 0x42,
+        0x42, 0x42, 0x66, 0x3C, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x70 'p' */
+    {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x5C, 0x66, 0x42,
+        0x42, 0x42, 0x44, 0x7C, 0x40, 0x40, 0x40, 0x00
+    },
+    /* 0x71 'q' */
+    {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x3E, 0x62, 0x42,
+        0x42, 0x42, 0x66, 0x3A, 0x02, 0x02, 0x02, 0x00
+    },
+    /* 0x72 'r' */
+    {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x2E, 0x30, 0x20,
+        0x20, 0x20, 0x20, 0x20, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x73 's' */
+    {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x38, 0x40, 0x40,
+        0x38, 0x04, 0x44, 0x38, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x74 't' */
+    {
+        0x00, 0x00, 0x00, 0x10, 0x10, 0x7E, 0x10, 0x10,
+        0x10, 0x10, 0x10, 0x0E, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x75 'u' */
+    {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x42, 0x42, 0x42,
+        0x42, 0x42, 0x46, 0x3A, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x76 'v' */
+    {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x42, 0x42, 0x24,
+        0x24, 0x28, 0x18, 0x18, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x77 'w' */
+    {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x91, 0x9A, 0x5A,
+        0x5A, 0x6A, 0x66, 0x64, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x78 'x' */
+    {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x64, 0x24, 0x18,
+        0x18, 0x38, 0x24, 0x46, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x79 'y' */
+    {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x42, 0x42, 0x24,
+        0x24, 0x14, 0x18, 0x18, 0x10, 0x10, 0x60, 0x00
+    },
+    /* 0x7A 'z' */
+    {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x7E, 0x04, 0x08,
+        0x18, 0x10, 0x20, 0x7E, 0x00, 0x00, 0x00, 0x00
+    },
+    /* 0x7B '{' */
+    {
+        0x00, 0x00, 0x1C, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1C, 0x00
+    },
+    /* 0x7C '|' */
+    {
+        0x00, 0x00, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10
+    },
+    /* 0x7D '}' */
+    {
+        0x00, 0x00, 0x30, 0x08, 0x08, 0x08, 0x08, 0x08,
+        0x06, 0x08, 0x08, 0x08, 0x08, 0x08, 0x30, 0x00
+    },
+    /* 0x7E '~' */
+    {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x32, 0x4C, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+    },
+};
@@ -0,0 +1,310 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <efi.h>
+#include <string.h>
+#include <cdefs.h>
+#include <lfive/gop.h>
+#include <lfive/log.h>
+
+/* Mode policies */
+#define GOP_NATIVE  0x00
+#define GOP_MAX     0x01
+#define GOP_SIZE    0x02
+
+/* EDID layout, only the base block is looked at */
+#define EDID_MIN_SIZE   128
+#define EDID_DTD        54      /* First detailed timing, the preferred one */
+
+extern EFI_GRAPHICS_OUTPUT_PROTOCOL *g_gop;
+
+/*
+ * Parse a decimal number
+ *
+ * @s: String to parse, advanced past the number
+ */
+static uint32_t
+gop_atou(const char **s)
+{
+    uint32_t v = 0;
+
+    while (**s >= '0' && **s <= '9') {
+        v = v * 10 + (*(*s)++ - '0');
+    }
+
+    return v;
+}
+
+/*
+ * Parse a mode policy
+ *
+ * @policy: Policy string
+ * @w: Wanted width is written here for GOP_SIZE
+ * @h: Wanted height is written here for GOP_SIZE
+ */
+static int
+gop_policy(const char *policy, uint32_t *w, uint32_t *h)
+{
+    if (policy == NULL || strcmp(policy, "native") == 0) {
+        return GOP_NATIVE;
+    }
+    if (strcmp(policy, "max") == 0) {
+        return GOP_MAX;
+    }
+
+    *w = gop_atou(&policy);
+    if (*policy++ == 'x') {
+        *h = gop_atou(&policy);
+        if (*w != 0 && *h != 0 && *policy == '\0') {
+            return GOP_SIZE;
+        }
+    }
+
+    log_warn("gop: bad mode policy, using native\n");
+    return GOP_NATIVE;
+}
+
+/*
+ * Get the preferred resolution of the display from
+ * its EDID, the active one if firmware overrode it.
+ *
+ * @w: Width is written here
+ * @h: Height is written here
+ *
+ * Returns zero if there is one
+ */
+static int
+gop_edid(uint32_t *w, uint32_t *h)
+{
+    static const uint8_t hdr[8] = {
+        0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00
+    };
+    EFI_GUID gop_guid = EFI_GRAPHICS_OUTPUT_PROTOCOL_GUID;
+    EFI_GUID edid_guids[] = {
+        EFI_EDID_ACTIVE_PROTOCOL_GUID,
+        EFI_EDID_DISCOVERED_PROTOCOL_GUID
+    };
+    EFI_EDID_PROTOCOL *edid;
+    efi_handle_t *handles;
+    efi_status_t status;
+    uintn_t nhandles;
+    const uint8_t *dtd;
+    int error = -1;
+
+    status = g_bootsrv->locate_handle_buffer(ByProtocol, &gop_guid, NULL,
+        &nhandles, &handles);
+    if (EFI_ERROR(status)) {
+        return -1;
+    }
+
+    for (uintn_t i = 0; i < nhandles && error != 0; ++i) {
+        for (size_t j = 0; j < ARRAY_SIZE(edid_guids) && error != 0; ++j) {
+            status = g_bootsrv->handle_protocol(handles[i], &edid_guids[j],
+                (void **)&edid);
+            if (EFI_ERROR(status) || edid->size_of_edid < EDID_MIN_SIZE) {
+                continue;
+            }
+            if (memcmp(edid->edid, hdr, sizeof(hdr)) != 0) {
+                continue;
+            }
+
+            /* A zero pixel clock makes it a display descriptor */
+            dtd = &edid->edid[EDID_DTD];
+            if (dtd[0] == 0 && dtd[1] == 0) {
+                continue;
+            }
+
+            *w = dtd[2] | ((uint32_t)(dtd[4] & 0xF0) << 4);
+            *h = dtd[5] | ((uint32_t)(dtd[7] & 0xF0) << 4);
+            error = (*w != 0 && *h != 0) ? 0 : -1;
+        }
+    }
+
+    g_bootsrv->free_pool(handles);
+    return error;
+}
+
+/*
+ * Get the channel masks of a mode
+ *
+ * @info: Mode information
+ * @res: Masks are written here
+ *
+ * Returns -1 if the mode is not 32bpp linear
+ */
+static int
+gop_masks(EFI_GRAPHICS_OUTPUT_MODE_INFORMATION *info, EFI_PIXEL_BITMASK *res)
+{
+    uint32_t all;
+
+    switch (info->pixel_format) {
+    case PixelRedGreenBlueReserved8BitPerColor:
+        res->red_mask = 0x000000FF;
+        res->green_mask = 0x0000FF00;
+        res->blue_mask = 0x00FF0000;
+        res->reserved_mask = 0xFF000000;
+        return 0;
+    case PixelBlueGreenRedReserved8BitPerColor:
+        res->red_mask = 0x00FF0000;
+        res->green_mask = 0x0000FF00;
+        res->blue_mask = 0x000000FF;
+        res->reserved_mask = 0xFF000000;
+        return 0;
+    case PixelBitMask:
+        /* The highest mask bit gives the pixel size */
+        *res = info->pixel_information;
+        all = res->red_mask | res->green_mask | res->blue_mask |
+            res->reserved_mask;
+        return ISSET(all, BIT(31)) ? 0 : -1;
+    default:
+        /* No linear framebuffer at all */
+        return -1;
+    }
+}
+
+/*
+ * Check if mode `a' beats mode `b' under a policy
+ */
+static int
+gop_better(int policy, uint32_t w, uint32_t h,
+    EFI_GRAPHICS_OUTPUT_MODE_INFORMATION *a,
+    EFI_GRAPHICS_OUTPUT_MODE_INFORMATION *b)
+{
+    uint64_t area_a, area_b;
+
+    area_a = (uint64_t)a->horizontal_resolution * a->vertical_resolution;
+    area_b = (uint64_t)b->horizontal_resolution * b->vertical_resolution;
+
+    if (policy == GOP_SIZE) {
+        /* An exact match beats all, then what fits */
+        if (a->horizontal_resolution == w && a->vertical_resolution == h) {
+            return 1;
+        }
+        if (b->horizontal_resolution == w && b->vertical_resolution == h) {
+            return 0;
+        }
+        if (a->horizontal_resolution > w || a->vertical_resolution > h) {
+            return 0;
+        }
+        if (b->horizontal_resolution > w || b->vertical_resolution > h) {
+            return 1;
+        }
+    }
+
+    return area_a > area_b;
+}
+
+int
+gop_init(const char *policy, struct l5_fbinfo *res)
+{
+    EFI_GUID gop_guid = EFI_GRAPHICS_OUTPUT_PROTOCOL_GUID;
+    EFI_GRAPHICS_OUTPUT_MODE_INFORMATION *info, best_info = { 0 };
+    EFI_GRAPHICS_OUTPUT_PROTOCOL *gop;
+    EFI_PIXEL_BITMASK masks;
+    efi_status_t status;
+    uint32_t w = 0, h = 0, best, cur;
+    uintn_t info_size;
+    int pol, have_best = 0;
+
+    status = g_bootsrv->locate_protocol(&gop_guid, NULL, (void **)&gop);
+    if (EFI_ERROR(status)) {
+        log_warn("could not get graphics handle!\n");
+        return -1;
+    }
+
+    g_gop = gop;
+    pol = gop_policy(policy, &w, &h);
+    cur = gop->mode->mode;
+    best = cur;
+
+    /*
+     * Native is the preferred timing from EDID, or the
+     * biggest mode that fits it. Without EDID there is
+     * nothing to go by but size.
+     */
+    if (pol == GOP_NATIVE) {
+        if (gop_edid(&w, &h) == 0) {
+            log_info("** gop: display prefers %ux%u\n", w, h);
+            pol = GOP_SIZE;
+        } else {
+            pol = GOP_MAX;
+        }
+    }
+
+    for (uint32_t i = 0; i < gop->mode->max_mode; ++i) {
+        status = gop->query_mode(gop, i, &info_size, &info);
+        if (EFI_ERROR(status)) {
+            continue;
+        }
+
+        if (gop_masks(info, &masks) == 0) {
+            if (!have_best || gop_better(pol, w, h, info, &best_info) ||
+                (i == cur && !gop_better(pol, w, h, &best_info, info))) {
+                best = i;
+                best_info = *info;
+                have_best = 1;
+            }
+        }
+
+        g_bootsrv->free_pool(info);
+    }
+
+    if (!have_best) {
+        log_warn("gop: no 32bpp linear mode\n");
+        return -1;
+    }
+
+    /* Mode sets can be slow, only do it if we must */
+    if (best != cur) {
+        status = gop->set_mode(gop, best);
+        if (EFI_ERROR(status)) {
+            log_warn("gop: could not set mode\n");
+            if (gop_masks(gop->mode->info, &masks) != 0) {
+                return -1;
+            }
+        }
+    }
+
+    info = gop->mode->info;
+    gop_masks(info, &masks);
+    res->io = (uint32_t *)gop->mode->frame_buffer_base;
+    res->size = gop->mode->frame_buffer_size;
+    res->pitch = info->pixels_per_scan_line * sizeof(uint32_t);
+    res->width = info->horizontal_resolution;
+    res->height = info->vertical_resolution;
+    res->bpp = 32;
+    res->red_mask = masks.red_mask;
+    res->green_mask = masks.green_mask;
+    res->blue_mask = masks.blue_mask;
+    res->reserved_mask = masks.reserved_mask;
+
+    log_info("** fb: %ux%u at %p, pitch %u%s\n", res->width, res->height,
+        res->io, res->pitch, (best != cur) ? " (mode set)" : "");
+    return 0;
+}
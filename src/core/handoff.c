@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <cdefs.h>
+#include <lfive/handoff.h>
+#include <lfive/mem.h>
+
+static struct l5_proto *proto = NULL;
+static size_t budget = 0;
+
+/*
+ * Size of a tag in the block, including its header
+ */
+static inline size_t
+handoff_tagsize(size_t size)
+{
+    return ALIGN_UP(sizeof(struct l5_tag) + size, L5_TAG_ALIGN);
+}
+
+void
+handoff_reserve(size_t size)
+{
+    budget += handoff_tagsize(size);
+}
+
+struct l5_proto *
+handoff_alloc(void)
+{
+    size_t size;
+
+    /* Header and L5_TAG_END come on top */
+    size = ALIGN_UP(sizeof(*proto), L5_TAG_ALIGN);
+    size += budget + handoff_tagsize(0);
+    size = ALIGN_UP(size, MEM_PAGESIZE);
+
+    proto = mem_alloc(L5_MEMP_HANDOFF, size);
+    if (proto == NULL) {
+        return NULL;
+    }
+
+    memset(proto, 0, sizeof(*proto));
+    proto->magic = L5_PROTO_MAGIC;
+    proto->version = L5_PROTO_VERSION;
+    proto->hdr_size = ALIGN_UP(sizeof(*proto), L5_TAG_ALIGN);
+    proto->size = proto->hdr_size;
+    proto->budget = size;
+    return proto;
+}
+
+void *
+handoff_tag(uint32_t type, size_t size)
+{
+    struct l5_tag *tag;
+    size_t tag_size = handoff_tagsize(size);
+
+    if (proto == NULL) {
+        return NULL;
+    }
+
+    /* Always keep room for L5_TAG_END */
+    if (proto->size + tag_size + handoff_tagsize(0) > proto->budget) {
+        return NULL;
+    }
+
+    tag = (struct l5_tag *)((uint8_t *)proto + proto->size);
+    memset(tag, 0, tag_size);
+    tag->type = type;
+    tag->size = tag_size;
+
+    proto->size += tag_size;
+    ++proto->ntags;
+    return tag;
+}
+
+struct l5_proto *
+handoff_finish(void)
+{
+    struct l5_tag *tag;
+
+    if (proto == NULL) {
+        return NULL;
+    }
+
+    tag = (struct l5_tag *)((uint8_t *)proto + proto->size);
+    tag->type = L5_TAG_END;
+    tag->size = handoff_tagsize(0);
+    proto->size += tag->size;
+    return proto;
+}
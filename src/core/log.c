@@ -0,0 +1,477 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdarg.h>
+#include <string.h>
+#include <lfive/log.h>
+#include <lfive/fbcon.h>
+#include <machine/uart.h>
+#include <machine/cpu.h>
+#include <cdefs.h>
+
+/* Longest line log_write() formats, the rest is cut */
+#define LOG_LINE_MAX    256
+
+/*
+ * Everything logged goes into `ring', `head' and
+ * `flushed' count bytes ever written so the ring
+ * index is just the low bits.
+ */
+static char ring[LOG_RING_SIZE];
+static uint64_t head;
+static uint64_t flushed;
+static int con_level = LOG_INFO;
+static int con_mask = CON_SCREEN | CON_SERIAL;
+static int efi_gone;
+
+/* Bytes and TSC cycles spent per backend, see con_stat() */
+static uint64_t con_bytes[2];
+static uint64_t con_cycles[2];
+
+static const char digits2[] =
+    "00010203040506070809101112131415161718192021222324"
+    "25262728293031323334353637383940414243444546474849"
+    "50515253545556575859606162636465666768697071727374"
+    "75767778798081828384858687888990919293949596979899";
+
+static const char hexdig[2][16] = {
+    { '0', '1', '2', '3', '4', '5', '6', '7',
+      '8', '9', 'a', 'b', 'c', 'd', 'e', 'f' },
+    { '0', '1', '2', '3', '4', '5', '6', '7',
+      '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' }
+};
+
+void
+con_puts(const uint16_t *s)
+{
+    uint64_t start, len;
+
+    for (len = 0; s[len] != '\0'; ++len);
+
+    if (ISSET(con_mask, CON_SERIAL) && uart_active()) {
+        start = rdtsc();
+        uart_puts(s);
+        con_cycles[1] += rdtsc() - start;
+        con_bytes[1] += len;
+    }
+
+    if (!ISSET(con_mask, CON_SCREEN)) {
+        return;
+    }
+
+    start = rdtsc();
+    if (fbcon_active()) {
+        fbcon_puts(s);
+    } else if (!efi_gone) {
+        g_systab->con_out->output_string(g_systab->con_out, (uint16_t *)s);
+    } else {
+        return;
+    }
+
+    con_cycles[0] += rdtsc() - start;
+    con_bytes[0] += len;
+}
+
+void
+con_select(int mask)
+{
+    con_mask = mask;
+}
+
+void
+con_stat(void)
+{
+    static const char *name[] = { "screen", "serial" };
+
+    for (int i = 0; i < 2; ++i) {
+        if (con_bytes[i] == 0) {
+            continue;
+        }
+
+        log_info("** %s: %lu bytes, %lu cycles/byte\n", name[i],
+            con_bytes[i], con_cycles[i] / con_bytes[i]);
+    }
+}
+
+void
+con_exit_bootsrv(void)
+{
+    efi_gone = 1;
+}
+
+/*
+ * Convert an unsigned value to decimal, two digits
+ * per division.
+ *
+ * @v: Value to convert
+ * @end: End of the buffer, digits go right before it
+ *
+ * Returns a pointer to the first digit
+ */
+static char *
+fmt_dec(uint64_t v, char *end)
+{
+    const char *d;
+
+    while (v >= 100) {
+        d = &digits2[(v % 100) * 2];
+        v /= 100;
+        *--end = d[1];
+        *--end = d[0];
+    }
+
+    if (v >= 10) {
+        d = &digits2[v * 2];
+        *--end = d[1];
+        *--end = d[0];
+    } else {
+        *--end = '0' + v;
+    }
+
+    return end;
+}
+
+/*
+ * Convert an unsigned value to hex
+ *
+ * @v: Value to convert
+ * @upper: Use upper case digits
+ * @end: End of the buffer, digits go right before it
+ *
+ * Returns a pointer to the first digit
+ */
+static char *
+fmt_hex(uint64_t v, int upper, char *end)
+{
+    do {
+        *--end = hexdig[upper][v & 0xF];
+        v >>= 4;
+    } while (v != 0);
+
+    return end;
+}
+
+/*
+ * Format into a buffer, output past `size' - 1
+ * bytes is dropped. The result is NUL terminated.
+ *
+ * Returns the length of the result
+ */
+static size_t
+fmt_vsnprintf(char *buf, size_t size, const char *fmt, va_list ap)
+{
+    char num[24], *p, *end = &num[sizeof(num)];
+    const uint16_t *ws;
+    const char *s;
+    size_t len, n = 0;
+    int64_t sv;
+    uint64_t v;
+    int width, zero, left, wide;
+    char sign;
+
+#define EMIT(c)                 \
+    do {                        \
+        if (n + 1 < size)       \
+            buf[n] = (c);       \
+        ++n;                    \
+    } while (0)
+
+    for (; *fmt != '\0'; ++fmt) {
+        if (*fmt != '%') {
+            EMIT(*fmt);
+            continue;
+        }
+
+        width = zero = left = wide = 0;
+        sign = '\0';
+        for (;; ++fmt) {
+            if (fmt[1] == '0') {
+                zero = 1;
+            } else if (fmt[1] == '-') {
+                left = 1;
+            } else {
+                break;
+            }
+        }
+        if (fmt[1] == '*') {
+            width = va_arg(ap, int);
+            ++fmt;
+        }
+        while (fmt[1] >= '0' && fmt[1] <= '9') {
+            width = width * 10 + (*++fmt - '0');
+        }
+        while (fmt[1] == 'l' || fmt[1] == 'z' || fmt[1] == 'h') {
+            wide |= (*++fmt != 'h');
+        }
+
+        s = NULL;
+        p = end;
+        switch (*++fmt) {
+        case 'd':
+        case 'i':
+            sv = wide ? va_arg(ap, int64_t) : va_arg(ap, int32_t);
+            v = (sv < 0) ? -(uint64_t)sv : (uint64_t)sv;
+            sign = (sv < 0) ? '-' : '\0';
+            p = fmt_dec(v, end);
+            break;
+        case 'u':
+            v = wide ? va_arg(ap, uint64_t) : va_arg(ap, uint32_t);
+            p = fmt_dec(v, end);
+            break;
+        case 'x':
+        case 'X':
+            v = wide ? va_arg(ap, uint64_t) : va_arg(ap, uint32_t);
+            p = fmt_hex(v, *fmt == 'X', end);
+            break;
+        case 'p':
+            v = (uintptr_t)va_arg(ap, void *);
+            EMIT('0');
+            EMIT('x');
+            p = fmt_hex(v, 0, end);
+            width = 16;
+            zero = 1;
+            break;
+        case 'c':
+            *--p = (char)va_arg(ap, int);
+            break;
+        case 's':
+            if (wide) {
+                /* UCS-2, anything past ASCII is lost */
+                ws = va_arg(ap, const uint16_t *);
+                for (len = 0; ws != NULL && ws[len] != 0; ++len);
+                for (; !left && (int)len < width; --width) {
+                    EMIT(' ');
+                }
+                for (size_t i = 0; i < len; ++i) {
+                    EMIT(ws[i] < 0x7F ? (char)ws[i] : '?');
+                }
+                for (; left && (int)len < width; --width) {
+                    EMIT(' ');
+                }
+                continue;
+            }
+            s = va_arg(ap, const char *);
+            if (s == NULL) {
+                s = "(null)";
+            }
+            break;
+        case '%':
+            EMIT('%');
+            continue;
+        case '\0':
+            --fmt;
+            continue;
+        default:
+            EMIT('%');
+            EMIT(*fmt);
+            continue;
+        }
+
+        if (s == NULL) {
+            s = p;
+            len = end - p;
+        } else {
+            len = strlen(s);
+        }
+
+        len += (sign != '\0');
+        if (sign != '\0' && zero) {
+            EMIT(sign);
+            sign = '\0';
+        }
+        for (; !left && (int)len < width; --width) {
+            EMIT(zero ? '0' : ' ');
+        }
+        if (sign != '\0') {
+            EMIT(sign);
+        }
+        for (const char *q = s; *q != '\0' && q != end; ++q) {
+            EMIT(*q);
+        }
+        for (; left && (int)len < width; --width) {
+            EMIT(' ');
+        }
+    }
+
+#undef EMIT
+
+    if (size > 0) {
+        buf[(n < size) ? n : size - 1] = '\0';
+    }
+
+    return (n < size) ? n : size - 1;
+}
+
+size_t
+log_snprintf(char *buf, size_t size, const char *fmt, ...)
+{
+    va_list ap;
+    size_t len;
+
+    va_start(ap, fmt);
+    len = fmt_vsnprintf(buf, size, fmt, ap);
+    va_end(ap);
+    return len;
+}
+
+/*
+ * Append bytes to the ring, overwriting the oldest
+ */
+static void
+ring_put(const char *s, size_t len)
+{
+    for (size_t i = 0; i < len; ++i) {
+        ring[head++ & (LOG_RING_SIZE - 1)] = s[i];
+    }
+}
+
+/*
+ * Get the first byte still in the ring, skipping
+ * past a line cut short by wrapping.
+ *
+ * @pos: Wanted position
+ */
+static uint64_t
+ring_start(uint64_t pos)
+{
+    if (head - pos <= LOG_RING_SIZE) {
+        return pos;
+    }
+
+    pos = head - LOG_RING_SIZE;
+    while (pos < head && ring[pos++ & (LOG_RING_SIZE - 1)] != '\n');
+    return pos;
+}
+
+void
+log_init(const char *mode)
+{
+    if (mode == NULL) {
+        return;
+    }
+
+    if (strcmp(mode, "quiet") == 0) {
+        con_level = LOG_ERR;
+    } else if (strcmp(mode, "debug") == 0) {
+        con_level = LOG_DEBUG;
+    } else if (strcmp(mode, "info") == 0) {
+        con_level = LOG_INFO;
+    } else {
+        log_warn("log: unknown mode %s\n", mode);
+    }
+}
+
+void
+log_flush(void)
+{
+    uint16_t buf[128];
+    size_t n = 0;
+    uint64_t pos;
+    int show = 0;
+    char c;
+
+    pos = ring_start(flushed);
+    while (pos < head) {
+        /* Each line starts with "<N>" */
+        c = ring[pos & (LOG_RING_SIZE - 1)];
+        if (c == '<' && head - pos >= 3) {
+            c = ring[(pos + 1) & (LOG_RING_SIZE - 1)];
+            show = (c - '0') <= con_level;
+            pos += 3;
+        }
+
+        do {
+            c = ring[pos++ & (LOG_RING_SIZE - 1)];
+            if (!show) {
+                continue;
+            }
+            if (c == '\n') {
+                buf[n++] = '\r';
+            }
+            buf[n++] = c;
+            if (n >= ARRAY_SIZE(buf) - 2) {
+                buf[n] = '\0';
+                con_puts(buf);
+                n = 0;
+            }
+        } while (c != '\n' && pos < head);
+    }
+
+    if (n > 0) {
+        buf[n] = '\0';
+        con_puts(buf);
+    }
+
+    flushed = head;
+}
+
+void
+log_write(int level, const char *fmt, ...)
+{
+    char line[LOG_LINE_MAX + 4];
+    va_list ap;
+    size_t len;
+
+    line[0] = '<';
+    line[1] = '0' + level;
+    line[2] = '>';
+
+    va_start(ap, fmt);
+    len = 3 + fmt_vsnprintf(&line[3], LOG_LINE_MAX, fmt, ap);
+    va_end(ap);
+
+    if (line[len - 1] != '\n') {
+        line[len++] = '\n';
+    }
+    ring_put(line, len);
+
+    if (level <= LOG_WARN || head - flushed >= LOG_BATCH) {
+        log_flush();
+    }
+}
+
+size_t
+log_tag_size(void)
+{
+    return sizeof(struct l5_tag_log) - sizeof(struct l5_tag) +
+        (head - ring_start(0));
+}
+
+void
+log_fill(struct l5_tag_log *tag)
+{
+    uint64_t pos;
+
+    pos = ring_start(0);
+    tag->len = head - pos;
+    tag->dropped = pos;
+    for (uint32_t i = 0; i < tag->len; ++i) {
+        tag->text[i] = ring[(pos + i) & (LOG_RING_SIZE - 1)];
+    }
+}
@@ -28,21 +28,80 @@
  */
 
 #include <efi.h>
+#include <string.h>
 #include <cdefs.h>
 #include <lfive/log.h>
+#include <lfive/arena.h>
+#include <lfive/elf.h>
+#include <lfive/handoff.h>
+#include <lfive/mem.h>
+#include <lfive/phys.h>
 #include <lfive/proto.h>
+#include <lfive/smp.h>
+#include <lfive/work.h>
+#include <lfive/tsc.h>
+#include <lfive/acpi.h>
+#include <lfive/config.h>
+#include <lfive/cmdline.h>
+#include <lfive/gop.h>
+#include <lfive/fbcon.h>
+#include <lfive/prof.h>
+#include <lfive/trace.h>
 #include <machine/mmu.h>
+#include <machine/cpu.h>
+#include <machine/uart.h>
+#include <machine/string.h>
 
-#define SEEK_END 0xFFFFFFFFFFFFFFFF
+/* Size of the stack the kernel is entered on */
+#define KERNEL_STACK_SIZE 0x10000
+
+/* Retries when the map changes under exit_boot_services() */
+#define EXIT_RETRIES 4
+
+/* Direct maps are data only, see prep_handoff() for code */
+#define DIRECT_PROT     (PROT_READ | PROT_WRITE)
+
+/* Entries our own allocations may split off per map fetch */
+#define MAP_SLACK       2
+
+/* Entries the map may gain per exit attempt, see alloc_proto() */
+#define MAP_EXIT_SLACK  8
+
+/* Entries efi_mark_fb() and phys_commit() may add after the exit */
+#define MAP_LATE_SLACK  (1 + 2 * PHYS_MAX_RANGES)
+
+/* Boot prompt timeout, see wait_key() */
+#define WAIT_FOREVER    ((uint64_t)-1)
+#define WAIT_POLL_US    10000
 
 static uintptr_t vas_pg;
+static struct mmu_vas kern_vas;
+static struct elf_image kern;
+static struct cpu_handoff handoff;
+static struct l5_proto *proto = NULL;
+static struct l5_tag_timing *timing = NULL;
+static struct l5_tag_smp *smp = NULL;
+static struct cpu_state cpust;
+static size_t memmap_budget = 0;
 static void *kern_img = NULL;
+static uintn_t kern_size = 0;
+static struct l5_module modules[L5_MAX_MODULES];
+static size_t nmodules = 0;
+
+/* What the kernel asked for, see read_kernel() */
+static struct l5_request req = {
+    .version = L5_REQUEST_VERSION,
+    .flags = L5_REQ_DEFAULT,
+    .stack_size = 0,
+    .paging_mode = L5_PAGING_4LVL,
+    .nmodules = 0
+};
 EFI_SYSTEM_TABLE *g_systab;
 EFI_BOOT_SERVICES *g_bootsrv;
 EFI_GRAPHICS_OUTPUT_PROTOCOL *g_gop;
 EFI_SIMPLE_FILE_SYSTEM_PROTOCOL *g_sfs;
 EFI_FILE_PROTOCOL *g_fproto;
-struct l5_proto g_lfive;
+struct l5_bootinfo g_lfive;
 
 /*
  * Get the file size
@@ -55,103 +114,338 @@ struct l5_proto g_lfive;
 static efi_status_t
 efi_get_fsize(EFI_FILE_PROTOCOL *file, uintn_t *size_res)
 {
+    EFI_GUID info_guid = EFI_FILE_INFO_ID;
+    EFI_FILE_INFO *info;
     efi_status_t status;
-    uintn_t size;
-
-    /* Seek to the end */
-    status = file->set_position(
-        file,
-        SEEK_END
-    );
+    arena_mark_t mark;
+    uintn_t info_size;
+    uint64_t start;
 
-    if (EFI_ERROR(status)) {
-        puts(L"could not seek to end of file\n");
-        return status;
+    /*
+     * The file info is variable length because of the
+     * name, start with room for a short one.
+     */
+    mark = arena_mark(&g_arena);
+    info_size = sizeof(*info) + 64 * sizeof(uint16_t);
+    info = arena_alloc(&g_arena, info_size, 0);
+    if (info == NULL) {
+        log_warn("could not allocate file info\n");
+        return EFI_OUT_OF_RESOURCES;
     }
 
-    /* The position should be the file size */
-    status = file->get_position(
-        file,
-        &size
-    );
+    start = trace_begin();
+    status = file->get_info(file, &info_guid, &info_size, info);
+    trace_end(TRACE_FILE_INFO, start, 0);
+    if (status == EFI_BUFFER_TOO_SMALL) {
+        arena_rollback(&g_arena, mark);
+        info = arena_alloc(&g_arena, info_size, 0);
+        if (info == NULL) {
+            log_warn("could not allocate file info\n");
+            return EFI_OUT_OF_RESOURCES;
+        }
 
-    if (EFI_ERROR(status)) {
-        puts(L"could not get file position\n");
-        return status;
+        start = trace_begin();
+        status = file->get_info(file, &info_guid, &info_size, info);
+        trace_end(TRACE_FILE_INFO, start, 0);
     }
 
-    /* Seek to the start */
-    status = file->set_position(
-        file,
-        0
-    );
-
     if (EFI_ERROR(status)) {
-        puts(L"could not seek to start of file\n");
+        log_warn("could not get file info\n");
+        arena_rollback(&g_arena, mark);
         return status;
     }
 
-    *size_res = size;
+    *size_res = info->file_size;
+    arena_rollback(&g_arena, mark);
     return EFI_SUCCESS;
 }
 
 /*
- * Load the kernel via EFi
+ * Read a whole file from the boot volume
+ *
+ * @name: File name
+ * @purpose: What the file is for (L5_MEMP_*)
+ * @buf_res: File buffer is written here
+ * @size_res: File size is written here
+ *
+ * Returns zero on success
  */
-static void
-load_kernel(void)
+static efi_status_t
+efi_read_file(uint16_t *name, uint32_t purpose, void **buf_res,
+    uintn_t *size_res)
 {
     EFI_FILE_PROTOCOL *file;
     uintn_t file_size;
     efi_status_t status;
-    void *bin_buf;
+    uint64_t start;
+    void *buf;
 
-    /* Open the kernel image */
+    start = trace_begin();
     status = g_fproto->open(
         g_fproto,
         &file,
-        L"l5",
+        name,
         EFI_FILE_MODE_READ,
         EFI_FILE_READ_ONLY | EFI_FILE_READ_ONLY | EFI_FILE_SYSTEM
     );
 
+    trace_end(TRACE_FILE_OPEN, start, 0);
     if (EFI_ERROR(status)) {
-        puts(L"could not load kernel\r\n");
-        die();
+        return status;
     }
 
     /* Get the file size */
     status = efi_get_fsize(file, &file_size);
     if (EFI_ERROR(status)) {
-        puts(L"get file size\r\n");
-        die();
+        file->close(file);
+        return status;
+    }
+
+    buf = mem_alloc(purpose, file_size);
+    if (buf == NULL) {
+        file->close(file);
+        return EFI_OUT_OF_RESOURCES;
     }
 
-    /* Allocate memory for the kernel */
-    status = g_bootsrv->allocate_pool(
-        EfiRuntimeServicesData,
-        file_size,
-        (void **)&kern_img
+    start = trace_begin();
+    status = file->read(
+        file,
+        &file_size,
+        buf
     );
+    trace_end(TRACE_FILE_READ, start, EFI_ERROR(status) ? 0 : file_size);
+
+    file->close(file);
+    if (EFI_ERROR(status)) {
+        return status;
+    }
+
+    *buf_res = buf;
+    *size_res = file_size;
+    return EFI_SUCCESS;
+}
+
+/*
+ * Read the kernel via EFI and pick up its request
+ * note, this comes first so that we know what we
+ * can skip.
+ */
+static void
+read_kernel(void)
+{
+    struct l5_request *note;
+    efi_status_t status;
+    size_t note_size;
 
+    /*
+     * The file itself is only needed until it has been
+     * loaded, the kernel gets a home of its own.
+     */
+    status = efi_read_file(L"l5", L5_MEMP_SCRATCH, &kern_img, &kern_size);
     if (EFI_ERROR(status)) {
-        puts(L"failed to allocate kernel buffer\r\n");
+        log_err("could not load kernel\n");
         die();
     }
 
-    /* Load the kernel image into our buffer */
-    status = file->read(
-        file,
-        &file_size,
-        kern_img
+    if (elf_check(kern_img, kern_size) != 0) {
+        log_err("kernel is not a valid ELF\n");
+        die();
+    }
+
+    note = elf_find_note(
+        kern_img,
+        kern_size,
+        L5_NOTE_NAME,
+        L5_NOTE_REQUEST,
+        &note_size
     );
 
+    if (note == NULL) {
+        return;
+    }
+
+    if (note_size < sizeof(*note) || note->version != L5_REQUEST_VERSION) {
+        log_warn("ignoring bad kernel request\n");
+        return;
+    }
+
+    req = *note;
+    if (req.nmodules > L5_MAX_MODULES) {
+        req.nmodules = L5_MAX_MODULES;
+    }
+
+    if (req.paging_mode == L5_PAGING_5LVL) {
+        log_warn("5-level paging not supported, using 4-level\n");
+        req.paging_mode = L5_PAGING_4LVL;
+    }
+}
+
+/*
+ * Read the loader config if there is one, it is
+ * optional.
+ */
+static void
+read_config(void)
+{
+    efi_status_t status;
+    const char *cmdline, *serial, *console;
+    uintn_t size;
+    void *buf;
+
+    status = efi_read_file(L"l5.cfg", L5_MEMP_SCRATCH, &buf, &size);
     if (EFI_ERROR(status)) {
-        puts(L"failed to read kernel\r\n");
+        return;
+    }
+
+    if (config_parse(buf, size) != 0) {
+        log_warn("could not parse l5.cfg\n");
+        return;
+    }
+
+    log_init(config_get("log"));
+
+    /* Serial output, on top of or instead of the screen */
+    serial = config_get("serial");
+    console = config_get("console");
+    if (serial != NULL) {
+        if (uart_init(serial, config_get_num("baud", 0)) != 0) {
+            log_warn("no UART at %s\n", serial);
+        } else if (console != NULL && strcmp(console, "serial") == 0) {
+            con_select(CON_SERIAL);
+        }
+    }
+
+    trace_init(config_get("trace"));
+    cmdline = config_get("cmdline");
+    if (cmdline != NULL) {
+        cmdline_init(cmdline);
+    }
+}
+
+/*
+ * Place the kernel and map its half
+ */
+static void
+load_kernel(void)
+{
+    if (elf_load(kern_img, kern_size, g_lfive.memmap,
+        g_lfive.memmap_nent, &kern) != 0) {
+        log_err("failed to load kernel ELF\n");
+        die();
+    }
+
+    if (elf_map(&kern, &kern_vas) != 0) {
+        log_err("failed to map kernel\n");
+        die();
+    }
+}
+
+/*
+ * Load the boot modules the kernel asked for
+ */
+static void
+load_modules(void)
+{
+    struct l5_module *mod;
+    efi_status_t status;
+    uint16_t name[L5_MODNAME_MAX];
+    uintn_t size;
+    void *buf;
+    size_t i;
+
+    for (size_t n = 0; n < req.nmodules; ++n) {
+        /* File names are ASCII in the note */
+        for (i = 0; i < L5_MODNAME_MAX - 1; ++i) {
+            name[i] = req.modules[n][i];
+            if (name[i] == L'\0') {
+                break;
+            }
+        }
+        name[i] = L'\0';
+
+        status = efi_read_file(name, L5_MEMP_MODULE, &buf, &size);
+        if (EFI_ERROR(status)) {
+            log_warn("could not load module %ls\n", name);
+            continue;
+        }
+
+        /* The kernel gets whole pages, leave no firmware garbage */
+        work_zero(L"module tail", (uint8_t *)buf + size,
+            ALIGN_UP(size, MEM_PAGESIZE) - size);
+
+        mod = &modules[nmodules++];
+        mod->base = (uintptr_t)buf;
+        mod->size = size;
+        memcpy(mod->name, req.modules[n], L5_MODNAME_MAX);
+        mod->name[L5_MODNAME_MAX - 1] = '\0';
+    }
+}
+
+/*
+ * Set up the direct maps the kernel asked for, this
+ * runs after the exit so that their page tables come
+ * from the final memory map and the cache types are
+ * those of the map the kernel gets.
+ */
+static void
+map_direct(void)
+{
+    struct l5_mementry *ent;
+    uintptr_t end, hhdm_len = MEM_IDENT_LIMIT;
+
+    if (ISSET(req.flags, L5_REQ_IDMAP)) {
+        if (mmu_map_direct(&kern_vas, 0, MEM_IDENT_LIMIT, DIRECT_PROT,
+            g_lfive.memmap, g_lfive.memmap_nent) != 0) {
+            log_err("failed to map lower 4 GiB\n");
+            die();
+        }
+    }
+
+    if (!ISSET(req.flags, L5_REQ_HHDM)) {
+        return;
+    }
+
+    /* Cover everything up to the last non-device region */
+    for (size_t i = 0; i < g_lfive.memmap_nent; ++i) {
+        ent = &g_lfive.memmap[i];
+        if (ent->type == L5_MEM_MMIO || ent->type == L5_MEM_RESERVED) {
+            continue;
+        }
+
+        end = ent->base + ent->npages * MEM_PAGESIZE;
+        if (end > hhdm_len) {
+            hhdm_len = end;
+        }
+    }
+
+    hhdm_len = ALIGN_UP(hhdm_len, MEM_2MIB);
+    if (mmu_map_direct(&kern_vas, L5_HHDM_BASE, hhdm_len, DIRECT_PROT,
+        g_lfive.memmap, g_lfive.memmap_nent) != 0) {
+        log_err("failed to map HHDM\n");
         die();
     }
 }
 
+/*
+ * Identity map a physical range, used to keep the
+ * handoff path reachable after the CR3 switch.
+ *
+ * @prot: Protection flags
+ */
+static void
+map_ident(uintptr_t base, size_t len, int prot)
+{
+    uintptr_t end = ALIGN_UP(base + len, MEM_PAGESIZE);
+
+    base = ALIGN_DOWN(base, MEM_PAGESIZE);
+    for (; base < end; base += MEM_PAGESIZE) {
+        if (mmu_map(&kern_vas, base, base, prot, MAP_SMALL_4K) != 0) {
+            log_err("failed to map handoff path\n");
+            die();
+        }
+    }
+}
+
 /*
  * Initialize the EFI file protocol
  *
@@ -176,7 +470,7 @@ init_efi_file(efi_handle_t image, EFI_FILE_PROTOCOL **res)
     );
 
     if (EFI_ERROR(status)) {
-        puts(L"could not handle loaded image protocol\r\n");
+        log_err("could not handle loaded image protocol\n");
         return status;
     }
 
@@ -188,13 +482,13 @@ init_efi_file(efi_handle_t image, EFI_FILE_PROTOCOL **res)
     );
 
     if (EFI_ERROR(status)) {
-        puts(L"could not get I/O image\r\n");
+        log_err("could not get I/O image\n");
         return status;
     }
 
     status = g_sfs->open_volume(g_sfs, res);
     if (EFI_ERROR(status)) {
-        puts(L"could not open file protocol\r\n");
+        log_err("could not open file protocol\n");
         return status;
     }
 
@@ -202,115 +496,623 @@ init_efi_file(efi_handle_t image, EFI_FILE_PROTOCOL **res)
 }
 
 /*
- * Get the memory map from firmware
+ * Convert an EFI memory type to an L5 memory type
+ *
+ * @efi_type: EFI memory type (EFI_MEMORY_TYPE)
+ */
+static uint32_t
+efi_to_l5_type(uint32_t efi_type)
+{
+    switch (efi_type) {
+    case EfiBootServicesCode:
+    case EfiBootServicesData:
+    case EfiConventionalMemory:
+        return L5_MEM_USABLE;
+    case EfiLoaderCode:
+    case EfiLoaderData:
+        return L5_MEM_LOADER;
+    case EfiACPIReclaimMemory:
+        return L5_MEM_ACPI_RECLAIM;
+    case EfiACPIMemoryNVS:
+        return L5_MEM_ACPI_NVS;
+    case EfiMemoryMappedIO:
+    case EfiMemoryMappedIOPortSpace:
+        return L5_MEM_MMIO;
+    case EfiUnusableMemory:
+        return L5_MEM_BAD;
+    case EfiPersistentMemory:
+        return L5_MEM_PERSISTENT;
+    }
+
+    return L5_MEM_RESERVED;
+}
+
+/*
+ * Pick the fastest legal memory type for a region
+ *
+ * @type: L5 memory type of the region
+ * @flags: L5 memory flags of the region
+ */
+static uint8_t
+l5_mem_cache(uint32_t type, uint16_t flags)
+{
+    /*
+     * Device memory must never be cached, however it
+     * may allow write-combining (e.g., framebuffers).
+     */
+    if (type == L5_MEM_MMIO) {
+        if (ISSET(flags, L5_MEMF_WC))
+            return L5_CACHE_WC;
+        return L5_CACHE_UC;
+    }
+
+    /* No attributes at all, leave it to the MTRRs */
+    if (!ISSET(flags, L5_MEMF_CACHEMASK))
+        return (type == L5_MEM_RESERVED) ? L5_CACHE_UC : L5_CACHE_WB;
+
+    if (ISSET(flags, L5_MEMF_WB))
+        return L5_CACHE_WB;
+    if (ISSET(flags, L5_MEMF_WT))
+        return L5_CACHE_WT;
+    if (ISSET(flags, L5_MEMF_WC))
+        return L5_CACHE_WC;
+
+    return L5_CACHE_UC;
+}
+
+/*
+ * Firmware memory map as last fetched by efi_get_mem(),
+ * lives in the arena until efi_xlate_mem() is done.
+ */
+static EFI_MEMORY_DESCRIPTOR *efi_map = NULL;
+static uintn_t efi_map_size;
+static uintn_t efi_desc_size;
+static arena_mark_t efi_map_mark;
+
+/*
+ * Get the memory map from firmware, this may be called
+ * more than once. The last call must come right before
+ * exiting boot services as the map key is returned.
+ *
+ * The map is only fetched here and not translated, so
+ * that efi_xlate_mem() can be deferred past the exit.
  */
 static uintn_t
 efi_get_mem(void)
 {
-    struct l5_mementry *l5_ent;
-    EFI_MEMORY_DESCRIPTOR *map, *ent;
     efi_status_t status;
     uintn_t map_key;
-    uintn_t map_size, l5_mapsize;
+    uintn_t map_size;
     uintn_t descriptor_size;
     uint32_t descriptor_version;
-    uint8_t i = 0;
+    size_t l5_mapsize, nent;
+
+    /* Drop a copy that was never translated */
+    if (efi_map != NULL) {
+        arena_rollback(&g_arena, efi_map_mark);
+        efi_map = NULL;
+    }
 
     /* Grab a hold of the memory map */
-    map = NULL;
     map_size = 0;
 
     /* Get the pool size */
     status = g_bootsrv->get_memory_map(
         &map_size,
-        map,
+        NULL,
         NULL,
         &descriptor_size,
         NULL
     );
 
     if (status != EFI_BUFFER_TOO_SMALL) {
-        puts(L"could not get memory map size\r\n");
+        log_err("could not get memory map size\n");
         die();
     }
 
-    /* Allocate a pool for the memory map */
-    l5_mapsize = map_size;
-    status = g_bootsrv->allocate_pool(
-        EfiLoaderData,
-        map_size,
-        (void **)&g_lfive.memmap
-    );
+    /*
+     * Our own allocations below may split regions, leave
+     * some room for that.
+     */
+    map_size += MAP_SLACK * descriptor_size;
+    nent = map_size / descriptor_size + MAP_LATE_SLACK;
+    map_size = ALIGN_UP(map_size, MEM_PAGESIZE);
 
-    /* Allocate a pool for the memory map */
-    map_size += 2 * descriptor_size;
-    status = g_bootsrv->allocate_pool(
-        EfiLoaderData,
-        map_size,
-        (void **)&map
-    );
-    if (EFI_ERROR(status)) {
-        puts(L"could not allocate memory map\r\n");
+    /*
+     * The L5 copy must also take what is added to it once
+     * boot services are gone. Only go to firmware if the
+     * last copy is too small.
+     */
+    if (nent > g_lfive.memmap_cap) {
+        if (g_lfive.memmap != NULL) {
+            l5_mapsize = g_lfive.memmap_cap * sizeof(struct l5_mementry);
+            mem_free_pages(
+                (uintptr_t)g_lfive.memmap,
+                ALIGN_UP(l5_mapsize, MEM_PAGESIZE) / MEM_PAGESIZE
+            );
+        }
+
+        l5_mapsize = ALIGN_UP(nent * sizeof(struct l5_mementry),
+            MEM_PAGESIZE);
+        g_lfive.memmap = mem_alloc(L5_MEMP_LOADER, l5_mapsize);
+        g_lfive.memmap_cap = l5_mapsize / sizeof(struct l5_mementry);
+        if (g_lfive.memmap == NULL) {
+            log_err("could not allocate L5 memory map\n");
+            die();
+        }
+    }
+
+    /* The firmware copy is only needed until translated */
+    efi_map_mark = arena_mark(&g_arena);
+    efi_map = arena_alloc(&g_arena, map_size, 8);
+    if (efi_map == NULL) {
+        log_err("could not allocate memory map\n");
         die();
     }
 
     /* Actually get the memory map now */
     status = g_bootsrv->get_memory_map(
         &map_size,
-        map,
+        efi_map,
         &map_key,
         &descriptor_size,
         &descriptor_version
     );
     if (EFI_ERROR(status)) {
-        puts(L"could not load memory map\r\n");
+        log_err("could not load memory map\n");
+        die();
+    }
+
+    efi_map_size = map_size;
+    efi_desc_size = descriptor_size;
+    return map_key;
+}
+
+/*
+ * Count the entries in the firmware memory map as
+ * it is right now, without fetching it.
+ */
+static size_t
+efi_map_count(void)
+{
+    efi_status_t status;
+    uintn_t map_size = 0;
+    uintn_t descriptor_size = 0;
+
+    status = g_bootsrv->get_memory_map(
+        &map_size,
+        NULL,
+        NULL,
+        &descriptor_size,
+        NULL
+    );
+
+    if (status != EFI_BUFFER_TOO_SMALL || descriptor_size == 0) {
+        log_err("could not get memory map size\n");
         die();
     }
 
-    ent = map;
-    do {
-        l5_ent = &g_lfive.memmap[i];
+    return map_size / descriptor_size;
+}
+
+/*
+ * Translate the memory map fetched by efi_get_mem() into
+ * the L5 memory map. This makes no firmware calls and is
+ * safe to use once boot services are gone.
+ */
+static void
+efi_xlate_mem(void)
+{
+    struct l5_mementry *l5_ent;
+    EFI_MEMORY_DESCRIPTOR *ent;
+    uintn_t i = 0;
+
+    ent = efi_map;
+    while ((uint8_t *)ent < (uint8_t *)efi_map + efi_map_size) {
+        l5_ent = &g_lfive.memmap[i++];
         l5_ent->base = ent->physical_start;
         l5_ent->npages = ent->number_of_pages;
-        ent = ((void *)((uint8_t *)ent + descriptor_size));
-    } while ((uint8_t *)ent < (uint8_t *)map + map_size);
-    return map_key;
+        l5_ent->type = efi_to_l5_type(ent->type);
+        l5_ent->flags = ent->attribute & L5_MEMF_CACHEMASK;
+        l5_ent->cache = l5_mem_cache(l5_ent->type, l5_ent->flags);
+        l5_ent->reserved = 0;
+
+        if (ISSET(ent->attribute, EFI_MEMORY_RUNTIME))
+            l5_ent->flags |= L5_MEMF_RUNTIME;
+
+        switch (ent->type) {
+        case EfiBootServicesCode:
+        case EfiBootServicesData:
+            l5_ent->flags |= L5_MEMF_BOOTSRV;
+            break;
+        }
+
+        ent = ((void *)((uint8_t *)ent + efi_desc_size));
+    }
+
+    g_lfive.memmap_nent = i;
+    arena_rollback(&g_arena, efi_map_mark);
+    efi_map = NULL;
 }
 
 /*
- * Acquire the handle for graphics output protocol
- *
- * Returns zero on success, otherwise a less than zero
- * value on failure.
+ * Describe the framebuffer as write-combining in the L5
+ * memory map so the direct maps pick it up. Firmware
+ * often leaves it out of the map, in which case an entry
+ * is added. Must be redone after every efi_xlate_mem().
  */
-static int
-efi_get_gop(void)
+static void
+efi_mark_fb(void)
+{
+    struct l5_fbinfo *fb = &g_lfive.fbinfo;
+    struct l5_mementry *ent, *map = g_lfive.memmap;
+    uintptr_t base, end, ent_end;
+    size_t i, pos, nent = g_lfive.memmap_nent;
+    int covered = 0;
+
+    if (!ISSET(req.flags, L5_REQ_FB) || fb->io == NULL) {
+        return;
+    }
+
+    base = ALIGN_DOWN((uintptr_t)fb->io, MEM_PAGESIZE);
+    end = ALIGN_UP((uintptr_t)fb->io + fb->size, MEM_PAGESIZE);
+    pos = nent;
+
+    for (i = 0; i < nent; ++i) {
+        ent = &map[i];
+        ent_end = ent->base + ent->npages * MEM_PAGESIZE;
+        if (pos == nent && ent->base >= end) {
+            pos = i;
+        }
+        if (ent_end <= base || ent->base >= end) {
+            continue;
+        }
+
+        /*
+         * Never widen WC past the framebuffer, a larger
+         * window may hold device registers.
+         */
+        covered = 1;
+        if (ent->base >= base && ent_end <= end &&
+            (ent->type == L5_MEM_MMIO || ent->type == L5_MEM_RESERVED)) {
+            ent->cache = L5_CACHE_WC;
+        }
+    }
+
+    if (covered || nent >= g_lfive.memmap_cap) {
+        return;
+    }
+
+    /* Keep the map sorted */
+    for (i = nent; i > pos; --i) {
+        map[i] = map[i - 1];
+    }
+
+    ent = &map[pos];
+    ent->base = base;
+    ent->npages = (end - base) / MEM_PAGESIZE;
+    ent->type = L5_MEM_MMIO;
+    ent->flags = L5_MEMF_WC;
+    ent->cache = L5_CACHE_WC;
+    ent->reserved = 0;
+    g_lfive.memmap_nent = nent + 1;
+}
+
+/*
+ * Print how long the last boot took from the exit to
+ * the kernel, if the kernel kept it for us.
+ */
+static void
+efi_show_handoff(void)
 {
-    struct l5_fbinfo *fbinfo;
-    EFI_GUID gopGuid = EFI_GRAPHICS_OUTPUT_PROTOCOL_GUID;
-    EFI_GRAPHICS_OUTPUT_PROTOCOL *gop;
+    EFI_GUID guid = L5_VENDOR_GUID;
+    uint64_t cycles;
+    uintn_t size = sizeof(cycles);
     efi_status_t status;
 
-    /* Get the graphics output protocol */
-    status = g_bootsrv->locate_protocol(&gopGuid, NULL, (void **)&gop);
-    if (EFI_ERROR(status)) {
-        puts(L"could not get graphics handle!\r\n");
+    status = g_systab->runtime_services->get_variable(
+        L5_HANDOFF_VAR,
+        &guid,
+        NULL,
+        &size,
+        &cycles
+    );
+
+    if (EFI_ERROR(status) || size != sizeof(cycles)) {
+        return;
     }
 
-    fbinfo = &g_lfive.fbinfo;
-    fbinfo->pitch = gop->mode->info->pixels_per_scan_line;
-    fbinfo->width = gop->mode->info->horizontal_resolution;
-    fbinfo->height = gop->mode->info->vertical_resolution;
-    return 0;
+    log_info("** last exit to kernel entry: %lu cycles\n", cycles);
+}
+
+/*
+ * Set aside the protocol block, every tag needs its
+ * room reserved here as nothing can be allocated once
+ * it is packed.
+ */
+static void
+alloc_proto(void)
+{
+    /*
+     * The memory map still grows from here. What is left
+     * of our own allocations and firmware events split
+     * entries on every exit attempt, then efi_mark_fb()
+     * and phys_commit() add theirs after the exit.
+     */
+    if (ISSET(req.flags, L5_REQ_MEMMAP)) {
+        memmap_budget = efi_map_count() +
+            (EXIT_RETRIES + 1) * MAP_EXIT_SLACK + MAP_LATE_SLACK;
+        handoff_reserve(
+            sizeof(struct l5_tag_memmap) - sizeof(struct l5_tag) +
+            memmap_budget * sizeof(struct l5_mementry)
+        );
+    }
+
+    handoff_reserve(
+        sizeof(struct l5_tag_reclaim) - sizeof(struct l5_tag) +
+        MEM_MAX_RANGES * sizeof(struct l5_memrange)
+    );
+
+    if (ISSET(req.flags, L5_REQ_FB)) {
+        handoff_reserve(sizeof(struct l5_tag_fb) - sizeof(struct l5_tag));
+    }
+
+    if (ISSET(req.flags, L5_REQ_HHDM)) {
+        handoff_reserve(sizeof(struct l5_tag_hhdm) - sizeof(struct l5_tag));
+    }
+
+    if (ISSET(req.flags, L5_REQ_SMP)) {
+        handoff_reserve(smp_tag_size());
+    }
+
+    if (ISSET(req.flags, L5_REQ_TOPO)) {
+        handoff_reserve(smp_topo_size());
+    }
+
+    if (ISSET(req.flags, L5_REQ_ACPI)) {
+        handoff_reserve(acpi_tag_size());
+    }
+
+    if (cmdline_tag_size() > 0) {
+        handoff_reserve(cmdline_tag_size());
+    }
+
+    /* Whatever is logged up to the packing may go in */
+    if (ISSET(req.flags, L5_REQ_LOG)) {
+        handoff_reserve(
+            sizeof(struct l5_tag_log) - sizeof(struct l5_tag) +
+            LOG_RING_SIZE
+        );
+    }
+
+    if (nmodules > 0) {
+        handoff_reserve(
+            sizeof(struct l5_tag_modules) - sizeof(struct l5_tag) +
+            nmodules * sizeof(struct l5_module)
+        );
+    }
+
+    handoff_reserve(sizeof(struct l5_tag_timing) - sizeof(struct l5_tag));
+    handoff_reserve(sizeof(struct l5_tag_tsc) - sizeof(struct l5_tag));
+    handoff_reserve(sizeof(struct l5_tag_cpu) - sizeof(struct l5_tag));
+    handoff_reserve(prof_tag_size());
+
+    proto = handoff_alloc();
+    if (proto == NULL) {
+        log_err("could not allocate L5 protocol\n");
+        die();
+    }
+
+    log_info("** handoff budget: %u bytes\n", proto->budget);
+}
+
+/*
+ * Pack everything into the protocol block, this is
+ * done after the exit and makes no firmware calls.
+ */
+static void
+pack_proto(void)
+{
+    struct l5_tag_memmap *memmap;
+    struct l5_tag_reclaim *reclaim;
+    struct l5_tag_fb *fb;
+    struct l5_tag_hhdm *hhdm;
+    struct l5_tag_modules *mods;
+    struct l5_tag_topo *topo;
+    struct l5_tag_tsc *tsc;
+    struct l5_tag_cpu *cpu;
+    struct l5_tag_acpi *acpi;
+    struct l5_tag_cmdline *cmdline;
+    struct l5_tag_log *log;
+    struct l5_tag_phases *phases;
+    size_t nent;
+
+    /* A cut short map would hand out memory that is in use */
+    nent = g_lfive.memmap_nent;
+    if (ISSET(req.flags, L5_REQ_MEMMAP) && nent > memmap_budget) {
+        log_err("memory map has %zu entries, room for %zu\n", nent,
+            memmap_budget);
+        die();
+    }
+
+    if (ISSET(req.flags, L5_REQ_MEMMAP)) {
+        memmap = handoff_tag(
+            L5_TAG_MEMMAP,
+            sizeof(*memmap) - sizeof(struct l5_tag) +
+            nent * sizeof(struct l5_mementry)
+        );
+        if (memmap != NULL) {
+            memmap->entsize = sizeof(struct l5_mementry);
+            memmap->nent = nent;
+            memcpy(memmap->ent, g_lfive.memmap,
+                nent * sizeof(struct l5_mementry));
+        }
+    }
+
+    /* Sized for the worst case, only what is used counts */
+    reclaim = handoff_tag(
+        L5_TAG_RECLAIM,
+        sizeof(*reclaim) - sizeof(struct l5_tag) +
+        MEM_MAX_RANGES * sizeof(struct l5_memrange)
+    );
+    if (reclaim != NULL) {
+        reclaim->nent = mem_report(reclaim->ent, MEM_MAX_RANGES);
+    }
+
+    if (ISSET(req.flags, L5_REQ_FB)) {
+        fb = handoff_tag(L5_TAG_FB, sizeof(*fb) - sizeof(struct l5_tag));
+        if (fb != NULL) {
+            fb->fbinfo = g_lfive.fbinfo;
+        }
+    }
+
+    if (ISSET(req.flags, L5_REQ_HHDM)) {
+        hhdm = handoff_tag(L5_TAG_HHDM, sizeof(*hhdm) - sizeof(struct l5_tag));
+        if (hhdm != NULL) {
+            hhdm->offset = L5_HHDM_BASE;
+        }
+    }
+
+    if (ISSET(req.flags, L5_REQ_SMP)) {
+        smp = handoff_tag(L5_TAG_SMP, smp_tag_size());
+        if (smp != NULL) {
+            smp_fill(smp);
+        }
+    }
+
+    if (ISSET(req.flags, L5_REQ_TOPO)) {
+        topo = handoff_tag(L5_TAG_TOPO, smp_topo_size());
+        if (topo != NULL) {
+            smp_topo_fill(topo);
+        }
+    }
+
+    if (ISSET(req.flags, L5_REQ_ACPI)) {
+        acpi = handoff_tag(L5_TAG_ACPI, acpi_tag_size());
+        if (acpi != NULL) {
+            acpi_fill(acpi);
+        }
+    }
+
+    if (cmdline_tag_size() > 0) {
+        cmdline = handoff_tag(L5_TAG_CMDLINE, cmdline_tag_size());
+        if (cmdline != NULL) {
+            cmdline_fill(cmdline);
+        }
+    }
+
+    if (nmodules > 0) {
+        mods = handoff_tag(
+            L5_TAG_MODULES,
+            sizeof(*mods) - sizeof(struct l5_tag) +
+            nmodules * sizeof(struct l5_module)
+        );
+        if (mods != NULL) {
+            mods->nmod = nmodules;
+            memcpy(mods->mod, modules, nmodules * sizeof(struct l5_module));
+        }
+    }
+
+    timing = handoff_tag(
+        L5_TAG_TIMING,
+        sizeof(*timing) - sizeof(struct l5_tag)
+    );
+    if (timing != NULL) {
+        timing->tsc_exit = g_lfive.tsc_exit;
+        timing->tsc_entry = g_lfive.tsc_entry;
+        timing->tsc_load = g_lfive.tsc_load;
+    }
+
+    tsc = handoff_tag(L5_TAG_TSC, sizeof(*tsc) - sizeof(struct l5_tag));
+    if (tsc != NULL) {
+        tsc_fill(tsc);
+    }
+
+    cpu = handoff_tag(L5_TAG_CPU, sizeof(*cpu) - sizeof(struct l5_tag));
+    if (cpu != NULL) {
+        cpu->features = cpust.features;
+        cpu->xcr0 = cpust.xcr0;
+        cpu->cr0 = cpust.cr0;
+        cpu->cr4 = cpust.cr4;
+    }
+
+    /* The packing itself is still running */
+    phases = handoff_tag(L5_TAG_PHASES, prof_tag_size());
+    if (phases != NULL) {
+        prof_fill(phases);
+    }
+
+    /* Last so it holds as much of the log as it can */
+    if (ISSET(req.flags, L5_REQ_LOG)) {
+        log = handoff_tag(L5_TAG_LOG, log_tag_size());
+        if (log != NULL) {
+            log_fill(log);
+        }
+    }
+
+    handoff_finish();
+}
+
+/*
+ * Get everything ready to enter the kernel so that
+ * there is little left to do after the exit.
+ */
+static void
+prep_handoff(void)
+{
+    uintptr_t stack;
+    size_t stack_size = KERNEL_STACK_SIZE;
+
+    if (req.stack_size != 0) {
+        stack_size = ALIGN_UP(req.stack_size, MEM_PAGESIZE);
+    }
+
+    stack = (uintptr_t)mem_alloc(L5_MEMP_KERNEL, stack_size);
+    if (stack == 0) {
+        log_err("could not allocate kernel stack\n");
+        die();
+    }
+
+    if (cpu_handoff_init(&handoff, vas_pg, stack + stack_size,
+        kern.entry, proto) != 0) {
+        log_err("could not prepare handoff\n");
+        die();
+    }
+
+    /* Without the identity map the data needs its own pages */
+    if (!ISSET(req.flags, L5_REQ_IDMAP)) {
+        map_ident(handoff.gdtr.base, handoff.gdtr.limit + 1,
+            PROT_READ | PROT_WRITE);
+        map_ident(stack, stack_size, PROT_READ | PROT_WRITE);
+        map_ident((uintptr_t)proto, proto->budget, PROT_READ | PROT_WRITE);
+    }
+
+    /*
+     * The direct maps are not executable, so the code
+     * that runs on the kernel page tables gets its own
+     * pages, never writable. This comes last so that it
+     * wins a page shared with the GDT, and map_direct()
+     * leaves these pages alone.
+     */
+    map_ident((uintptr_t)cpu_handoff, MEM_PAGESIZE * 2,
+        PROT_READ | PROT_EXEC);
+    if (ISSET(req.flags, L5_REQ_SMP)) {
+        map_ident(smp_tramp(), MEM_PAGESIZE, PROT_READ | PROT_EXEC);
+    }
 }
 
 /*
  * Wait for a keystroke to boot the system
+ *
+ * @timeout: Seconds to wait before booting anyway,
+ *           WAIT_FOREVER to only boot on a key
  */
 static void
-wait_key(void)
+wait_key(uint64_t timeout)
 {
     EFI_INPUT_KEY input;
+    efi_status_t status;
+    uint64_t waited = 0;
 
     /* Flush the console input */
     g_systab->con_in->reset(
@@ -319,14 +1121,24 @@ wait_key(void)
     );
 
     for (;;) {
-        g_systab->con_in->read_key_stroke(
+        status = g_systab->con_in->read_key_stroke(
             g_systab->con_in,
             &input
         );
 
-        if (input.unicode_char == L'\r') {
+        if (!EFI_ERROR(status) && input.unicode_char == L'\r') {
+            break;
+        }
+
+        if (timeout == WAIT_FOREVER) {
+            continue;
+        }
+        if (waited >= timeout * 1000000) {
             break;
         }
+
+        g_bootsrv->Stall(WAIT_POLL_US);
+        waited += WAIT_POLL_US;
     }
 }
 
@@ -335,69 +1147,236 @@ efi_main(efi_handle_t *hand, EFI_SYSTEM_TABLE *systab)
 {
     efi_status_t status;
     EFI_FILE_PROTOCOL file;
+    const char *console;
     uintn_t map_key = 0;
-    int error;
+    uint64_t tsc, timeout;
+    size_t nt_min, nparked;
+    int ph, strv;
 
+    g_lfive.tsc_entry = rdtsc();
     g_systab = systab;
     g_bootsrv = systab->boot_services;
+    ph = prof_begin("init", 0);
+
+    /* Before anything big gets copied around */
+    strv = string_init();
 
     /* Grab the boot services */
     systab->boot_services->set_watchdog_timer(0, 0, 0, NULL);
 
+    /* Everything L5 needs for itself comes from here */
+    if (arena_init(&g_arena, L5_MEMP_LOADER, ARENA_NPAGES) != 0) {
+        log_err("could not allocate loader arena\n");
+        die();
+    }
+
+    /* Spare CPUs help with the heavy lifting */
+    work_init();
+
     /* Clear the console */
     systab->con_out->reset(
         systab->con_out,
         0
     );
 
-    puts(L"** l5 loader (uefi) **\r\n");
-    if ((error = efi_get_gop()) < 0) {
+    log_info("** l5 loader (uefi) **\n");
+    string_current(&nt_min);
+    log_info("** string: %s, non-temporal fills from %zu KiB\n",
+        string_variants[strv].name, nt_min / 1024);
+    efi_show_handoff();
+    tsc_init();
+    prof_end(ph);
+
+    /* The kernel tells us what it wants first */
+    ph = prof_begin("config", 0);
+    if (init_efi_file(hand, &g_fproto) != 0) {
+        die();
+    }
+    read_config();
+    read_kernel();
+    prof_end(ph);
+
+    if (ISSET(req.flags, L5_REQ_FB)) {
+        ph = prof_begin("gop", 0);
+        if (gop_init(config_get("gop"), &g_lfive.fbinfo) != 0) {
+            log_warn("no framebuffer, booting headless\n");
+            req.flags &= ~L5_REQ_FB;
+        }
+        prof_end(ph);
+    }
+
+    /* Firmware text output is slow, draw our own */
+    if (ISSET(req.flags, L5_REQ_FB)) {
+        console = config_get("console");
+        if (console == NULL || strcmp(console, "fb") == 0) {
+            ph = prof_begin("fbcon", 0);
+            fbcon_init(&g_lfive.fbinfo);
+            prof_end(ph);
+        }
+    }
+
+    /* Allocate a virtual address space */
+    if (mem_alloc_pages(L5_MEMP_PGTBL, 1, &vas_pg) != 0) {
+        log_err("failed to allocate VAS\n");
         die();
     }
 
+    kern_vas.pml4 = vas_pg;
+
     /*
      * Initialize the address space, we don't want to
-     * switch just yet! But take advantage of the boot
-     * services before we exit them
+     * switch just yet! The direct maps wait for the exit,
+     * until then a first look at the memory map is enough
+     * to place the kernel and the AP trampoline.
      */
-    mmu_init_vas(vas_pg);
-    puts(L"** vas initialized\r\n");
-
-    /* Wait for input */
-    puts(L"[ press enter to boot ]\r\n");
-    wait_key();
-    puts(L"** booting...\r\n");
+    ph = prof_begin("memmap", 0);
+    efi_get_mem();
+    efi_xlate_mem();
+    efi_mark_fb();
+    prof_end(ph);
 
-    /* Allocate a virtual address space */
-    status = g_bootsrv->allocate_pages(
-        AllocateAnyPages,
-        EfiLoaderData,
-        1,
-        &vas_pg
-    );
+    ph = prof_begin("vas", 0);
+    mmu_init_vas(vas_pg);
+    prof_end(ph);
+    log_info("** vas initialized\n");
 
-    if (EFI_ERROR(status)) {
-        puts(L"failed to allocate VAS\r\n");
-        die();
+    /* Wait for input, unless told to boot right away */
+    timeout = config_get_num("timeout", WAIT_FOREVER);
+    if (timeout != 0) {
+        log_flush();
+        puts(L"[ press enter to boot ]\r\n");
+        ph = prof_begin("wait", L5_PHASEF_WAIT);
+        wait_key(timeout);
+        prof_end(ph);
     }
+    log_info("** booting...\n");
 
     /* Load the kernel and L5 protocol */
-    init_efi_file(hand, &g_fproto);
+    ph = prof_begin("kernel", 0);
     load_kernel();
-    map_key = efi_get_mem();
+    prof_end(ph);
 
-    /* Get the heck out of here! */
-    status = g_bootsrv->exit_boot_services(
-        hand,
-        map_key
-    );
+    ph = prof_begin("modules", 0);
+    load_modules();
+    prof_end(ph);
+    g_lfive.tsc_load = rdtsc();
+
+    /* Find the APs while MP services are still around */
+    if (ISSET(req.flags, L5_REQ_SMP)) {
+        ph = prof_begin("smp", 0);
+        if (smp_init(g_lfive.memmap, g_lfive.memmap_nent) != 0) {
+            log_warn("SMP unavailable, booting on the BSP only\n");
+        }
+        prof_end(ph);
+    }
+
+    if (ISSET(req.flags, L5_REQ_TOPO)) {
+        ph = prof_begin("topo", 0);
+        smp_probe();
+        prof_end(ph);
+    }
+
+    if (ISSET(req.flags, L5_REQ_ACPI)) {
+        ph = prof_begin("acpi", 0);
+        acpi_init();
+        prof_end(ph);
+    }
+
+    ph = prof_begin("prep", 0);
+    alloc_proto();
+    prep_handoff();
+    prof_end(ph);
+
+    mem_stat();
+    work_stat();
+    con_stat();
+    trace_stat();
+    log_flush();
+
+    /* Past this point memory comes from phys_alloc() */
+    ph = prof_begin("exit", 0);
+
+    /*
+     * Firmware events may still change the map between
+     * the two calls, in which case the exit fails with
+     * a stale key. Only the memory services may be used
+     * until it is retried, so nothing is logged here.
+     */
+    for (int i = 0; i <= EXIT_RETRIES; ++i) {
+        map_key = efi_get_mem();
+
+        /* Get the heck out of here! */
+        status = g_bootsrv->exit_boot_services(
+            hand,
+            map_key
+        );
+        if (status != EFI_INVALID_PARAMETER) {
+            break;
+        }
+    }
 
     /* This would suck */
     if (status != EFI_SUCCESS) {
-        puts(L"could not exit EFI boot services\r\n");
+        log_err("could not exit EFI boot services\n");
+        die();
+    }
+
+    g_lfive.tsc_exit = rdtsc();
+    prof_end(ph);
+    con_exit_bootsrv();
+
+    /*
+     * Boot services are gone, from here on memory comes
+     * from the final memory map instead.
+     */
+    ph = prof_begin("phys", 0);
+    efi_xlate_mem();
+    efi_mark_fb();
+    if (phys_init(g_lfive.memmap, g_lfive.memmap_nent) != 0) {
+        log_err("no usable memory after exit\n");
         die();
     }
+    mem_exit_bootsrv();
+    prof_end(ph);
+
+    ph = prof_begin("direct", 0);
+    map_direct();
+    prof_end(ph);
+
+    /* Let the kernel know what we took */
+    if (phys_commit(g_lfive.memmap, &g_lfive.memmap_nent,
+        g_lfive.memmap_cap) != 0) {
+        log_err("memory map too small for late allocations\n");
+        die();
+    }
+
+    /* The kernel gets vector and paging features from the start */
+    cpu_enable(&cpust);
+    ph = prof_begin("pack", 0);
+    pack_proto();
+    prof_end(ph);
+
+    /* The APs take the PAT from us */
+    mmu_init_pat();
+    nparked = smp_start(smp, vas_pg);
+    if (smp != NULL && smp->ncpu > 1 && nparked < smp->ncpu - 1) {
+        log_warn("only %zu of %u APs parked\n", nparked, smp->ncpu - 1);
+    }
+
+    /* Only the framebuffer or serial console is left */
+    prof_stat();
+    log_flush();
+
+    /*
+     * Off to the kernel, nothing may run between the
+     * stamp and the jump. Keeping the latency across
+     * boots is up to the kernel, see L5_HANDOFF_VAR.
+     */
+    tsc = rdtsc();
+    if (timing != NULL) {
+        timing->tsc_handoff = tsc;
+    }
 
-    for (;;);
+    cpu_handoff(&handoff);
     return 0;
 }
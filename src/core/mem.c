@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <efi.h>
+#include <cdefs.h>
+#include <lfive/log.h>
+#include <lfive/arena.h>
+#include <lfive/mem.h>
+#include <lfive/phys.h>
+#include <lfive/proto.h>
+
+/*
+ * Per-purpose accounting
+ *
+ * @name: Human readable name
+ * @efi_type: EFI memory type to allocate with
+ * @npages: Number of pages currently held
+ * @peak: Most pages ever held at once
+ */
+struct mem_acct {
+    uint16_t *name;
+    EFI_MEMORY_TYPE efi_type;
+    size_t npages;
+    size_t peak;
+};
+
+/*
+ * Only scratch memory goes away with boot services,
+ * everything else must survive into the kernel.
+ */
+static struct mem_acct acct[L5_MEMP_MAX] = {
+    [L5_MEMP_KERNEL]  = { L"kernel",  EfiLoaderData, 0, 0 },
+    [L5_MEMP_MODULE]  = { L"modules", EfiLoaderData, 0, 0 },
+    [L5_MEMP_PGTBL]   = { L"pgtbl",   EfiLoaderData, 0, 0 },
+    [L5_MEMP_HANDOFF] = { L"handoff", EfiLoaderData, 0, 0 },
+    [L5_MEMP_LOADER]  = { L"loader",  EfiLoaderData, 0, 0 },
+    [L5_MEMP_SCRATCH] = { L"scratch", EfiBootServicesData, 0, 0 },
+    [L5_MEMP_SMP]     = { L"smp",     EfiLoaderData, 0, 0 }
+};
+
+static struct l5_memrange ranges[MEM_MAX_RANGES];
+static size_t nranges = 0;
+static int bootsrv_gone = 0;
+
+/*
+ * Record a newly allocated range, merging it with
+ * a neighbour of the same purpose if we can.
+ */
+static void
+mem_track(uint32_t purpose, uintptr_t base, size_t npages)
+{
+    struct l5_memrange *r;
+    size_t len = npages * MEM_PAGESIZE;
+
+    for (size_t i = 0; i < nranges; ++i) {
+        r = &ranges[i];
+        if (r->purpose != purpose) {
+            continue;
+        }
+
+        /* Grows upwards */
+        if (r->base + r->npages * MEM_PAGESIZE == base) {
+            r->npages += npages;
+            return;
+        }
+
+        /* Grows downwards */
+        if (base + len == r->base) {
+            r->base = base;
+            r->npages += npages;
+            return;
+        }
+    }
+
+    if (nranges >= MEM_MAX_RANGES) {
+        log_warn("mem: out of range slots\n");
+        return;
+    }
+
+    r = &ranges[nranges++];
+    r->base = base;
+    r->npages = npages;
+    r->purpose = purpose;
+    r->reserved = 0;
+}
+
+/*
+ * Drop a range from the records, this may split
+ * a merged range in two.
+ */
+static void
+mem_untrack(uintptr_t base, size_t npages)
+{
+    struct l5_memrange *r;
+    uintptr_t end = base + npages * MEM_PAGESIZE;
+    uintptr_t r_end;
+
+    for (size_t i = 0; i < nranges; ++i) {
+        r = &ranges[i];
+        r_end = r->base + r->npages * MEM_PAGESIZE;
+        if (base < r->base || end > r_end) {
+            continue;
+        }
+
+        acct[r->purpose].npages -= npages;
+
+        /* Whole range, move the last one in its place */
+        if (base == r->base && end == r_end) {
+            *r = ranges[--nranges];
+            return;
+        }
+
+        if (base == r->base) {
+            r->base = end;
+            r->npages -= npages;
+            return;
+        }
+
+        /* Keep the head, track the tail separately */
+        r->npages = (base - r->base) / MEM_PAGESIZE;
+        if (end < r_end) {
+            mem_track(r->purpose, end, (r_end - end) / MEM_PAGESIZE);
+        }
+        return;
+    }
+}
+
+int
+mem_alloc_pages(uint32_t purpose, size_t npages, uintptr_t *res)
+{
+    struct mem_acct *ap;
+    efi_status_t status;
+    efi_phys_addr_t addr = MEM_IDENT_LIMIT - 1;
+
+    if (purpose >= L5_MEMP_MAX || res == NULL) {
+        return -1;
+    }
+
+    ap = &acct[purpose];
+    if (bootsrv_gone) {
+        if (phys_alloc(npages, MEM_PAGESIZE, &addr) != 0) {
+            return -1;
+        }
+    } else {
+        status = g_bootsrv->allocate_pages(
+            AllocateMaxAddress,
+            ap->efi_type,
+            npages,
+            &addr
+        );
+
+        if (EFI_ERROR(status)) {
+            return -1;
+        }
+    }
+
+    ap->npages += npages;
+    if (ap->npages > ap->peak) {
+        ap->peak = ap->npages;
+    }
+
+    mem_track(purpose, addr, npages);
+    *res = addr;
+    return 0;
+}
+
+int
+mem_alloc_at(uint32_t purpose, uintptr_t base, size_t npages)
+{
+    struct mem_acct *ap;
+    efi_status_t status;
+    efi_phys_addr_t addr = base;
+
+    if (purpose >= L5_MEMP_MAX || bootsrv_gone) {
+        return -1;
+    }
+
+    ap = &acct[purpose];
+    status = g_bootsrv->allocate_pages(
+        AllocateAddress,
+        ap->efi_type,
+        npages,
+        &addr
+    );
+
+    if (EFI_ERROR(status)) {
+        return -1;
+    }
+
+    ap->npages += npages;
+    if (ap->npages > ap->peak) {
+        ap->peak = ap->npages;
+    }
+
+    mem_track(purpose, addr, npages);
+    return 0;
+}
+
+void *
+mem_alloc(uint32_t purpose, size_t size)
+{
+    uintptr_t addr;
+    size_t npages;
+
+    npages = ALIGN_UP(size, MEM_PAGESIZE) / MEM_PAGESIZE;
+    if (mem_alloc_pages(purpose, npages, &addr) != 0) {
+        return NULL;
+    }
+
+    return (void *)addr;
+}
+
+void
+mem_free_pages(uintptr_t base, size_t npages)
+{
+    mem_untrack(base, npages);
+
+    /* The physical allocator never takes anything back */
+    if (!bootsrv_gone) {
+        g_bootsrv->free_pages(base, npages);
+    }
+}
+
+void
+mem_exit_bootsrv(void)
+{
+    bootsrv_gone = 1;
+}
+
+size_t
+mem_report(struct l5_memrange *buf, size_t max)
+{
+    struct l5_memrange *r;
+    size_t n = 0;
+
+    /*
+     * The kernel image and its modules are not ours to
+     * give back, scratch memory already shows up as
+     * usable in the memory map and the AP trampoline
+     * is in use until the kernel starts every AP.
+     */
+    for (size_t i = 0; i < nranges && n < max; ++i) {
+        r = &ranges[i];
+        switch (r->purpose) {
+        case L5_MEMP_KERNEL:
+        case L5_MEMP_MODULE:
+        case L5_MEMP_SCRATCH:
+        case L5_MEMP_SMP:
+            continue;
+        }
+
+        buf[n++] = *r;
+    }
+
+    return n;
+}
+
+void
+mem_stat(void)
+{
+    struct mem_acct *ap;
+
+    log_info("** memory high-water marks (KiB):\n");
+    for (int i = 0; i < L5_MEMP_MAX; ++i) {
+        ap = &acct[i];
+        log_info("   %ls: %lu now, %lu peak\n", ap->name,
+            (uint64_t)ap->npages * (MEM_PAGESIZE / 1024),
+            (uint64_t)ap->peak * (MEM_PAGESIZE / 1024));
+    }
+
+    log_info("   arena: %lu of %lu used\n", (uint64_t)g_arena.peak / 1024,
+        (uint64_t)g_arena.size / 1024);
+}
@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cdefs.h>
+#include <lfive/mem.h>
+#include <lfive/phys.h>
+
+/* Leave the first MiB alone, it is too precious */
+#define PHYS_LOW_LIMIT 0x100000
+
+/*
+ * A range of physical memory
+ *
+ * @base: Base address
+ * @end: End address (exclusive)
+ * @src: Free range a used range came from
+ */
+struct phys_range {
+    uintptr_t base;
+    uintptr_t end;
+    size_t src;
+};
+
+static struct phys_range free_ranges[PHYS_MAX_RANGES];
+static struct phys_range used_ranges[PHYS_MAX_RANGES];
+static size_t nfree = 0;
+static size_t nused = 0;
+
+/*
+ * Remember a range that was handed out, most will be
+ * right after another one from the same free range.
+ */
+static int
+phys_mark_used(uintptr_t base, uintptr_t end, size_t src)
+{
+    struct phys_range *r;
+
+    for (size_t i = 0; i < nused; ++i) {
+        r = &used_ranges[i];
+        if (r->src == src && r->end == base) {
+            r->end = end;
+            return 0;
+        }
+    }
+
+    if (nused >= PHYS_MAX_RANGES) {
+        return -1;
+    }
+
+    r = &used_ranges[nused++];
+    r->base = base;
+    r->end = end;
+    r->src = src;
+    return 0;
+}
+
+int
+phys_init(struct l5_mementry *map, size_t nent)
+{
+    struct l5_mementry *ent;
+    struct phys_range *r;
+    uintptr_t base, end;
+
+    nfree = 0;
+    nused = 0;
+
+    for (size_t i = 0; i < nent && nfree < PHYS_MAX_RANGES; ++i) {
+        ent = &map[i];
+
+        /*
+         * Boot services memory is free too, but our own
+         * stack lives there until the kernel takes over.
+         */
+        if (ent->type != L5_MEM_USABLE) {
+            continue;
+        }
+        if (ISSET(ent->flags, L5_MEMF_BOOTSRV)) {
+            continue;
+        }
+
+        base = ent->base;
+        end = ent->base + ent->npages * MEM_PAGESIZE;
+        if (end <= PHYS_LOW_LIMIT || base >= MEM_IDENT_LIMIT) {
+            continue;
+        }
+        if (end > MEM_IDENT_LIMIT) {
+            end = MEM_IDENT_LIMIT;
+        }
+        if (base < PHYS_LOW_LIMIT) {
+            base = PHYS_LOW_LIMIT;
+        }
+
+        r = &free_ranges[nfree];
+        r->base = base;
+        r->end = end;
+        r->src = nfree++;
+    }
+
+    return (nfree > 0) ? 0 : -1;
+}
+
+int
+phys_alloc(size_t npages, size_t align, uintptr_t *res)
+{
+    struct phys_range *r;
+    uintptr_t base, end;
+
+    if (npages == 0 || res == NULL) {
+        return -1;
+    }
+
+    if (align < MEM_PAGESIZE) {
+        align = MEM_PAGESIZE;
+    }
+
+    for (size_t i = 0; i < nfree; ++i) {
+        r = &free_ranges[i];
+        base = ALIGN_UP(r->base, align);
+        end = base + npages * MEM_PAGESIZE;
+        if (base < r->base || end > r->end) {
+            continue;
+        }
+
+        if (phys_mark_used(base, end, i) != 0) {
+            return -1;
+        }
+
+        /*
+         * Anything skipped over for alignment is lost, the
+         * memory map still reports it as usable though.
+         */
+        r->base = end;
+        *res = base;
+        return 0;
+    }
+
+    return -1;
+}
+
+int
+phys_commit(struct l5_mementry *map, size_t *nent, size_t cap)
+{
+    struct l5_mementry *ent, tmp;
+    struct phys_range *r;
+    uintptr_t ent_end;
+    size_t n, nsplit;
+
+    if (map == NULL || nent == NULL) {
+        return -1;
+    }
+
+    n = *nent;
+    for (size_t i = 0; i < nused; ++i) {
+        r = &used_ranges[i];
+        for (size_t j = 0; j < n; ++j) {
+            ent = &map[j];
+            ent_end = ent->base + ent->npages * MEM_PAGESIZE;
+            if (ent->type != L5_MEM_USABLE) {
+                continue;
+            }
+            if (r->base < ent->base || r->end > ent_end) {
+                continue;
+            }
+
+            /* Used range goes between a head and a tail */
+            nsplit = (r->base > ent->base) + (r->end < ent_end);
+            if (n + nsplit > cap) {
+                return -1;
+            }
+
+            /* Make room right after this entry */
+            for (size_t k = n; k > j + 1; --k) {
+                map[k - 1 + nsplit] = map[k - 1];
+            }
+            n += nsplit;
+
+            tmp = *ent;
+            if (r->base > ent->base) {
+                ent->npages = (r->base - ent->base) / MEM_PAGESIZE;
+                ent = &map[++j];
+            }
+
+            *ent = tmp;
+            ent->base = r->base;
+            ent->npages = (r->end - r->base) / MEM_PAGESIZE;
+            ent->type = L5_MEM_LOADER;
+
+            if (r->end < ent_end) {
+                ent = &map[++j];
+                *ent = tmp;
+                ent->base = r->end;
+                ent->npages = (ent_end - r->end) / MEM_PAGESIZE;
+            }
+            break;
+        }
+    }
+
+    *nent = n;
+    return 0;
+}
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <cdefs.h>
+#include <lfive/prof.h>
+#include <lfive/tsc.h>
+#include <lfive/log.h>
+#include <machine/cpu.h>
+
+static struct l5_phase phases[PROF_MAX_PHASES];
+static uint32_t nphases = 0;
+static uint16_t depth = 0;
+
+/*
+ * Take the next free phase
+ *
+ * @name: Phase name, cut to L5_PHASE_NAMELEN - 1
+ * @flags: Phase flags (L5_PHASEF_*)
+ *
+ * Returns NULL if the table is full
+ */
+static struct l5_phase *
+prof_new(const char *name, uint16_t flags)
+{
+    struct l5_phase *pp;
+    size_t i;
+
+    if (nphases >= PROF_MAX_PHASES) {
+        return NULL;
+    }
+
+    pp = &phases[nphases++];
+    for (i = 0; i < L5_PHASE_NAMELEN - 1 && name[i] != '\0'; ++i) {
+        pp->name[i] = name[i];
+    }
+
+    pp->name[i] = '\0';
+    pp->flags = flags;
+    pp->depth = depth;
+    pp->bytes = 0;
+    return pp;
+}
+
+int
+prof_begin(const char *name, uint16_t flags)
+{
+    struct l5_phase *pp;
+
+    pp = prof_new(name, flags);
+    if (pp == NULL) {
+        return -1;
+    }
+
+    ++depth;
+    pp->start = rdtsc();
+    return pp - phases;
+}
+
+void
+prof_end(int id)
+{
+    if (id < 0 || (uint32_t)id >= nphases) {
+        return;
+    }
+
+    phases[id].end = rdtsc();
+    if (depth > 0) {
+        --depth;
+    }
+}
+
+void
+prof_sum(const char *name, uint64_t start, uint64_t cycles, uint64_t bytes)
+{
+    struct l5_phase *pp;
+
+    for (uint32_t i = 0; i < nphases; ++i) {
+        pp = &phases[i];
+        if (!ISSET(pp->flags, L5_PHASEF_SUM)) {
+            continue;
+        }
+        if (strcmp(pp->name, name) != 0) {
+            continue;
+        }
+
+        pp->end += cycles;
+        pp->bytes += bytes;
+        return;
+    }
+
+    pp = prof_new(name, L5_PHASEF_SUM);
+    if (pp == NULL) {
+        return;
+    }
+
+    pp->start = start;
+    pp->end = start + cycles;
+    pp->bytes = bytes;
+}
+
+void
+prof_stat(void)
+{
+    struct l5_phase *pp;
+    uint64_t mhz, cycles, total = 0, wait = 0;
+    int indent;
+
+    mhz = tsc_hz() / 1000000;
+    if (mhz == 0) {
+        mhz = 1;
+    }
+
+    log_info("** boot phases (us):\n");
+    for (uint32_t i = 0; i < nphases; ++i) {
+        pp = &phases[i];
+        if (pp->end == 0) {
+            continue;
+        }
+
+        cycles = pp->end - pp->start;
+        indent = (pp->depth < 4) ? pp->depth * 2 : 8;
+        if (pp->bytes != 0 && cycles != 0) {
+            /* Bytes per microsecond, that is MB/s */
+            log_info("   %*s%-*s %8lu (%lu KiB, %lu MB/s)\n", indent, "",
+                12 - indent, pp->name, cycles / mhz, pp->bytes / 1024,
+                pp->bytes * mhz / cycles);
+        } else {
+            log_info("   %*s%-*s %8lu%s\n", indent, "", 12 - indent, pp->name,
+                cycles / mhz,
+                ISSET(pp->flags, L5_PHASEF_WAIT) ? " (wait)" : "");
+        }
+
+        /* Nested phases are already part of their parent */
+        if (pp->depth != 0) {
+            continue;
+        }
+        if (ISSET(pp->flags, L5_PHASEF_WAIT)) {
+            wait += cycles;
+        } else {
+            total += cycles;
+        }
+    }
+
+    log_info("   total        %8lu, %lu waiting\n", total / mhz, wait / mhz);
+}
+
+size_t
+prof_tag_size(void)
+{
+    return sizeof(struct l5_tag_phases) - sizeof(struct l5_tag) +
+        PROF_MAX_PHASES * sizeof(struct l5_phase);
+}
+
+void
+prof_fill(struct l5_tag_phases *tag)
+{
+    tag->nphase = nphases;
+    memcpy(tag->phase, phases, nphases * sizeof(struct l5_phase));
+}
@@ -0,0 +1,270 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <efi.h>
+#include <string.h>
+#include <cdefs.h>
+#include <lfive/smp.h>
+#include <lfive/mem.h>
+#include <lfive/arena.h>
+#include <lfive/log.h>
+#include <lfive/tsc.h>
+#include <machine/smp.h>
+#include <machine/cpu.h>
+
+/* How long APs get to park, in microseconds */
+#define SMP_PARK_TIMEOUT 100000
+
+static EFI_MP_SERVICES_PROTOCOL *mp = NULL;
+static struct l5_cpu *cpus = NULL;
+static struct l5_cpu bsp_cpu;
+static size_t ncpu = 0;
+static uint32_t bsp_id = 0;
+static uintptr_t tramp_pg = 0;
+static uint64_t tsc_per_us = 0;
+
+/*
+ * Get the mailboxes of a tag
+ *
+ * @tag: SMP tag
+ */
+static inline struct l5_mailbox *
+smp_mbox(struct l5_tag_smp *tag)
+{
+    return (struct l5_mailbox *)((uint8_t *)tag + tag->mbox_offset);
+}
+
+/*
+ * Take a page below AP_TRAMP_LIMIT for the trampoline,
+ * the highest free one is used to keep clear of the
+ * BIOS data areas.
+ *
+ * @map: L5 memory map
+ * @nent: Number of entries in `map'
+ */
+static int
+smp_alloc_tramp(struct l5_mementry *map, size_t nent)
+{
+    struct l5_mementry *ent;
+    uintptr_t start, end;
+
+    for (size_t i = nent; i-- > 0;) {
+        ent = &map[i];
+        if (ent->type != L5_MEM_USABLE) {
+            continue;
+        }
+        if (ISSET(ent->flags, L5_MEMF_BOOTSRV)) {
+            continue;
+        }
+
+        start = (ent->base < MEM_PAGESIZE) ? MEM_PAGESIZE : ent->base;
+        end = ent->base + ent->npages * MEM_PAGESIZE;
+        if (end > AP_TRAMP_LIMIT) {
+            end = AP_TRAMP_LIMIT;
+        }
+
+        for (; end >= start + MEM_PAGESIZE; end -= MEM_PAGESIZE) {
+            if (mem_alloc_at(L5_MEMP_SMP, end - MEM_PAGESIZE, 1) == 0) {
+                tramp_pg = end - MEM_PAGESIZE;
+                return 0;
+            }
+        }
+    }
+
+    return -1;
+}
+
+int
+smp_probe(void)
+{
+    EFI_GUID mp_guid = EFI_MP_SERVICES_PROTOCOL_GUID;
+    EFI_PROCESSOR_INFORMATION info;
+    efi_status_t status;
+    uintn_t nproc, nenabled;
+    struct l5_cpu *cp;
+
+    if (ncpu > 0) {
+        return 0;
+    }
+
+    /* Without MP services all we know of is ourselves */
+    bsp_id = cpu_apic_id();
+    bsp_cpu.apic_id = bsp_id;
+    cpus = &bsp_cpu;
+    ncpu = 1;
+
+    status = g_bootsrv->locate_protocol(&mp_guid, NULL, (void **)&mp);
+    if (EFI_ERROR(status)) {
+        mp = NULL;
+        return -1;
+    }
+
+    status = mp->GetNumberOfProcessors(mp, &nproc, &nenabled);
+    if (EFI_ERROR(status)) {
+        return -1;
+    }
+
+    cp = arena_alloc(&g_arena, nproc * sizeof(*cp), sizeof(uint64_t));
+    if (cp == NULL) {
+        return -1;
+    }
+
+    /* Only enabled processors are handed over */
+    cpus = cp;
+    ncpu = 0;
+    for (uintn_t i = 0; i < nproc; ++i) {
+        status = mp->GetProcessorInfo(mp, i, &info);
+        if (EFI_ERROR(status)) {
+            continue;
+        }
+        if (!ISSET(info.status_flag, PROCESSOR_ENABLED_BIT)) {
+            continue;
+        }
+        if (ISSET(info.status_flag, PROCESSOR_AS_BSP_BIT)) {
+            bsp_id = info.processor_id;
+        }
+
+        cp = &cpus[ncpu++];
+        cp->apic_id = info.processor_id;
+        cp->package = info.location.package;
+        cp->core = info.location.core;
+        cp->thread = info.location.thread;
+    }
+
+    if (ncpu == 0) {
+        cpus = &bsp_cpu;
+        ncpu = 1;
+    }
+
+    return 0;
+}
+
+int
+smp_init(struct l5_mementry *map, size_t nent)
+{
+    if (smp_probe() != 0) {
+        return -1;
+    }
+
+    if (smp_alloc_tramp(map, nent) != 0) {
+        log_warn("no low page for the AP trampoline\n");
+        return -1;
+    }
+
+    /* The INIT-SIPI delays are timed with the TSC */
+    tsc_per_us = tsc_hz() / 1000000;
+    if (tsc_per_us == 0) {
+        tsc_per_us = 1;
+    }
+
+    log_info("** cpus: %zu\n", ncpu);
+    return 0;
+}
+
+uintptr_t
+smp_tramp(void)
+{
+    return tramp_pg;
+}
+
+size_t
+smp_tag_size(void)
+{
+    return sizeof(struct l5_tag_smp) - sizeof(struct l5_tag) +
+        L5_MBOX_SIZE + ncpu * sizeof(struct l5_mailbox);
+}
+
+void
+smp_fill(struct l5_tag_smp *tag)
+{
+    struct l5_mailbox *mbox;
+    uintptr_t first;
+
+    first = ALIGN_UP((uintptr_t)(tag + 1), L5_MBOX_SIZE);
+    tag->ncpu = ncpu;
+    tag->bsp_apic_id = bsp_id;
+    tag->mbox_offset = first - (uintptr_t)tag;
+
+    mbox = smp_mbox(tag);
+    for (size_t i = 0; i < ncpu; ++i) {
+        mbox[i].apic_id = cpus[i].apic_id;
+        if (mbox[i].apic_id == bsp_id) {
+            mbox[i].flags = L5_MBOX_BSP;
+        }
+    }
+}
+
+size_t
+smp_start(struct l5_tag_smp *tag, uintptr_t cr3)
+{
+    volatile struct l5_mailbox *mbox;
+    size_t nparked = 0;
+    uint64_t end;
+
+    if (tag == NULL || tag->ncpu < 2 || tramp_pg == 0) {
+        return 0;
+    }
+
+    mbox = smp_mbox(tag);
+    if (ap_tramp_install(tramp_pg, cr3, (uintptr_t)mbox, tag->ncpu) != 0) {
+        return 0;
+    }
+
+    ap_start_all(tramp_pg, tsc_per_us);
+
+    /* Wait for every AP to show up */
+    end = rdtsc() + SMP_PARK_TIMEOUT * tsc_per_us;
+    while (nparked < tag->ncpu - 1 && rdtsc() < end) {
+        nparked = 0;
+        for (size_t i = 0; i < tag->ncpu; ++i) {
+            if (ISSET(mbox[i].flags, L5_MBOX_PARKED)) {
+                ++nparked;
+            }
+        }
+
+        __ASMV("pause");
+    }
+
+    return nparked;
+}
+
+size_t
+smp_topo_size(void)
+{
+    return sizeof(struct l5_tag_topo) - sizeof(struct l5_tag) +
+        ncpu * sizeof(struct l5_cpu);
+}
+
+void
+smp_topo_fill(struct l5_tag_topo *tag)
+{
+    tag->ncache = cpu_caches(tag->cache, L5_MAX_CACHES);
+    tag->ncpu = ncpu;
+    memcpy(tag->cpu, cpus, ncpu * sizeof(struct l5_cpu));
+}
@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <efi.h>
+#include <string.h>
+#include <cdefs.h>
+#include <lfive/trace.h>
+#include <lfive/tsc.h>
+#include <lfive/log.h>
+#include <machine/cpu.h>
+#include <machine/uart.h>
+
+#define PAGESIZE 4096
+
+/*
+ * Accounting for one kind of call
+ *
+ * @count: Number of calls
+ * @cycles: TSC cycles spent in all calls
+ * @max: TSC cycles of the slowest call
+ * @bytes: Bytes moved or allocated by all calls
+ */
+struct trace_acct {
+    uint64_t count;
+    uint64_t cycles;
+    uint64_t max;
+    uint64_t bytes;
+};
+
+static const char *trace_names[TRACE_NCALLS] = {
+    [TRACE_ALLOC_PAGES] = "allocate_pages",
+    [TRACE_FREE_PAGES] = "free_pages",
+    [TRACE_GET_MEMMAP] = "get_memory_map",
+    [TRACE_ALLOC_POOL] = "allocate_pool",
+    [TRACE_FREE_POOL] = "free_pool",
+    [TRACE_HANDLE_PROTO] = "handle_protocol",
+    [TRACE_LOCATE_PROTO] = "locate_protocol",
+    [TRACE_STALL] = "stall",
+    [TRACE_FILE_OPEN] = "file_open",
+    [TRACE_FILE_INFO] = "file_get_info",
+    [TRACE_FILE_READ] = "file_read"
+};
+
+static struct trace_acct acct[TRACE_NCALLS];
+static EFI_BOOT_SERVICES traced;
+static EFI_BOOT_SERVICES *fw;
+static int enabled = 0;
+static int stream = 0;
+
+static efi_status_t __efiapi
+trace_allocate_pages(EFI_ALLOCATE_TYPE type, EFI_MEMORY_TYPE memtype,
+    uintn_t pages, efi_phys_addr_t *memory)
+{
+    uint64_t start = rdtsc();
+    efi_status_t status;
+
+    status = fw->allocate_pages(type, memtype, pages, memory);
+    trace_end(TRACE_ALLOC_PAGES, start, pages * PAGESIZE);
+    return status;
+}
+
+static efi_status_t __efiapi
+trace_free_pages(efi_phys_addr_t memory, uintn_t pages)
+{
+    uint64_t start = rdtsc();
+    efi_status_t status;
+
+    status = fw->free_pages(memory, pages);
+    trace_end(TRACE_FREE_PAGES, start, pages * PAGESIZE);
+    return status;
+}
+
+static efi_status_t __efiapi
+trace_get_memory_map(uintn_t *map_size, EFI_MEMORY_DESCRIPTOR *map,
+    uintn_t *map_key, uintn_t *desc_size, uint32_t *desc_version)
+{
+    uint64_t start = rdtsc();
+    efi_status_t status;
+
+    status = fw->get_memory_map(map_size, map, map_key, desc_size,
+        desc_version);
+    trace_end(TRACE_GET_MEMMAP, start, EFI_ERROR(status) ? 0 : *map_size);
+    return status;
+}
+
+static efi_status_t __efiapi
+trace_allocate_pool(EFI_MEMORY_TYPE pool_type, uintn_t size, void **buf)
+{
+    uint64_t start = rdtsc();
+    efi_status_t status;
+
+    status = fw->allocate_pool(pool_type, size, buf);
+    trace_end(TRACE_ALLOC_POOL, start, size);
+    return status;
+}
+
+static efi_status_t __efiapi
+trace_free_pool(void *buf)
+{
+    uint64_t start = rdtsc();
+    efi_status_t status;
+
+    status = fw->free_pool(buf);
+    trace_end(TRACE_FREE_POOL, start, 0);
+    return status;
+}
+
+static efi_status_t __efiapi
+trace_handle_protocol(efi_handle_t handle, EFI_GUID *proto, void **iface)
+{
+    uint64_t start = rdtsc();
+    efi_status_t status;
+
+    status = fw->handle_protocol(handle, proto, iface);
+    trace_end(TRACE_HANDLE_PROTO, start, 0);
+    return status;
+}
+
+static efi_status_t __efiapi
+trace_locate_protocol(EFI_GUID *proto, void *reg, void **iface)
+{
+    uint64_t start = rdtsc();
+    efi_status_t status;
+
+    status = fw->locate_protocol(proto, reg, iface);
+    trace_end(TRACE_LOCATE_PROTO, start, 0);
+    return status;
+}
+
+static efi_status_t __efiapi
+trace_stall(uintn_t us)
+{
+    uint64_t start = rdtsc();
+    efi_status_t status;
+
+    status = fw->Stall(us);
+    trace_end(TRACE_STALL, start, 0);
+    return status;
+}
+
+int
+trace_init(const char *mode)
+{
+    char line[64];
+    size_t len;
+
+    if (mode == NULL || strcmp(mode, "off") == 0) {
+        return 0;
+    }
+
+    if (strcmp(mode, "stream") == 0) {
+        if (!uart_active()) {
+            log_warn("trace: streaming needs a UART\n");
+        }
+        stream = 1;
+    } else if (strcmp(mode, "on") != 0) {
+        log_warn("trace: unknown mode %s\n", mode);
+        return -1;
+    }
+
+    /* Only our copy is touched, the firmware table stays as is */
+    fw = g_bootsrv;
+    traced = *fw;
+    traced.allocate_pages = trace_allocate_pages;
+    traced.free_pages = trace_free_pages;
+    traced.get_memory_map = trace_get_memory_map;
+    traced.allocate_pool = trace_allocate_pool;
+    traced.free_pool = trace_free_pool;
+    traced.handle_protocol = trace_handle_protocol;
+    traced.locate_protocol = trace_locate_protocol;
+    traced.Stall = trace_stall;
+    g_bootsrv = &traced;
+    enabled = 1;
+
+    /* Lets the host side turn cycles into time */
+    if (stream) {
+        len = log_snprintf(line, sizeof(line), "@trace-hz %lu\n", tsc_hz());
+        uart_write(line, len);
+    }
+
+    return 0;
+}
+
+uint64_t
+trace_begin(void)
+{
+    return enabled ? rdtsc() : 0;
+}
+
+void
+trace_end(uint32_t call, uint64_t start, uint64_t bytes)
+{
+    struct trace_acct *ap;
+    uint64_t cycles;
+    char line[96];
+    size_t len;
+
+    if (!enabled || call >= TRACE_NCALLS) {
+        return;
+    }
+
+    cycles = rdtsc() - start;
+    ap = &acct[call];
+    ++ap->count;
+    ap->cycles += cycles;
+    ap->bytes += bytes;
+    if (cycles > ap->max) {
+        ap->max = cycles;
+    }
+
+    /* One line per call, see tools/trace2json.py */
+    if (stream) {
+        len = log_snprintf(line, sizeof(line), "@trace %s %lu %lu %lu\n",
+            trace_names[call], start, cycles, bytes);
+        uart_write(line, len);
+    }
+}
+
+void
+trace_stat(void)
+{
+    struct trace_acct *ap;
+    uint64_t mhz;
+
+    if (!enabled) {
+        return;
+    }
+
+    mhz = tsc_hz() / 1000000;
+    if (mhz == 0) {
+        mhz = 1;
+    }
+
+    log_info("** firmware calls (us):\n");
+    log_info("   %-16s %6s %10s %8s %12s\n", "call", "count", "total",
+        "max", "bytes");
+    for (uint32_t i = 0; i < TRACE_NCALLS; ++i) {
+        ap = &acct[i];
+        if (ap->count == 0) {
+            continue;
+        }
+
+        log_info("   %-16s %6lu %10lu %8lu %12lu\n", trace_names[i],
+            ap->count, ap->cycles / mhz, ap->max / mhz, ap->bytes);
+    }
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <efi.h>
+#include <cdefs.h>
+#include <lfive/tsc.h>
+#include <lfive/log.h>
+#include <machine/cpu.h>
+
+/* Length of a Stall() calibration run in microseconds */
+#define TSC_STALL_US 5000
+
+static uint64_t freq = 0;
+static uint32_t method = L5_TSC_STALL;
+static uint32_t flags = 0;
+
+/*
+ * Time the TSC against Stall(), the firmware backs
+ * this with a fixed rate timer.
+ */
+static uint64_t
+tsc_stall_freq(void)
+{
+    uint64_t start, end;
+
+    start = rdtsc();
+    g_bootsrv->Stall(TSC_STALL_US);
+    end = rdtsc();
+
+    return (end - start) * (1000000 / TSC_STALL_US);
+}
+
+void
+tsc_init(void)
+{
+    freq = cpu_tsc_freq(&method);
+    if (freq == 0) {
+        method = L5_TSC_STALL;
+        freq = tsc_stall_freq();
+    }
+
+    if (cpu_tsc_invariant()) {
+        flags |= L5_TSCF_INVARIANT;
+    }
+
+    log_info("** tsc: %lu MHz%s\n", freq / 1000000,
+        ISSET(flags, L5_TSCF_INVARIANT) ? "" : " (not invariant)");
+}
+
+uint64_t
+tsc_hz(void)
+{
+    return freq;
+}
+
+void
+tsc_fill(struct l5_tag_tsc *tag)
+{
+    tag->freq = freq;
+    tag->method = method;
+    tag->flags = flags;
+}
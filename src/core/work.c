@@ -0,0 +1,375 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <efi.h>
+#include <string.h>
+#include <cdefs.h>
+#include <lfive/work.h>
+#include <lfive/log.h>
+#include <lfive/prof.h>
+#include <lfive/tsc.h>
+#include <machine/cpu.h>
+#include <machine/string.h>
+
+/* Max number of phases work_stat() keeps apart */
+#define WORK_MAX_PHASES 8
+
+/*
+ * Zeroing from here on bypasses the caches and is
+ * spread over every CPU, below it the calling CPU
+ * does it alone with plain stores.
+ */
+#define WORK_ZERO_NT    0x100000
+
+/*
+ * A job being worked on, shares are claimed by
+ * bumping `next' so faster CPUs take more.
+ *
+ * @fn: Work function
+ * @arg: Argument passed to `fn'
+ * @n: Number of items
+ * @share: Items per share
+ * @next: First unclaimed item
+ * @busy: TSC ticks spent working, over all CPUs
+ */
+struct work_job {
+    work_fn_t fn;
+    void *arg;
+    size_t n;
+    size_t share;
+    size_t next;
+    uint64_t busy;
+};
+
+/*
+ * Time spent in a phase
+ *
+ * @name: Phase name
+ * @elapsed: Wall TSC ticks
+ * @busy: TSC ticks spent working, over all CPUs
+ * @bytes: Bytes copied or filled, zero for other jobs
+ */
+struct work_phase {
+    const uint16_t *name;
+    uint64_t elapsed;
+    uint64_t busy;
+    size_t bytes;
+};
+
+/*
+ * Arguments for work_memcpy(), work_memset() and
+ * work_zero()
+ */
+struct work_mem {
+    uint8_t *dst;
+    const uint8_t *src;
+    int c;
+};
+
+static EFI_MP_SERVICES_PROTOCOL *mp = NULL;
+static efi_event_t done_ev = NULL;
+static size_t ncpu = 1;
+static struct work_phase phases[WORK_MAX_PHASES];
+static size_t nphases = 0;
+
+/*
+ * Claim and work shares until the job runs dry
+ *
+ * @jp: Job to work on
+ */
+static void
+work_loop(struct work_job *jp)
+{
+    size_t start, end;
+    uint64_t tsc = rdtsc();
+
+    for (;;) {
+        start = __atomic_fetch_add(&jp->next, jp->share, __ATOMIC_RELAXED);
+        if (start >= jp->n) {
+            break;
+        }
+
+        end = start + jp->share;
+        if (end > jp->n) {
+            end = jp->n;
+        }
+
+        jp->fn(jp->arg, start, end);
+    }
+
+    __atomic_fetch_add(&jp->busy, rdtsc() - tsc, __ATOMIC_RELAXED);
+}
+
+/*
+ * AP side of a job
+ *
+ * @arg: Job to work on
+ */
+static void __efiapi
+work_ap(void *arg)
+{
+    /*
+     * Firmware might not have turned on AVX on the
+     * APs, leave the shares to the BSP if so.
+     */
+    if (!string_usable(string_current(NULL))) {
+        return;
+    }
+
+    work_loop(arg);
+}
+
+/*
+ * Account time to a phase, memory jobs also go to
+ * the phase table handed to the kernel.
+ *
+ * @name: Phase name
+ * @start: TSC when the job began
+ * @elapsed: Wall TSC ticks
+ * @busy: TSC ticks spent working
+ * @bytes: Bytes moved, if any
+ */
+static void
+work_account(const uint16_t *name, uint64_t start, uint64_t elapsed,
+    uint64_t busy, size_t bytes)
+{
+    struct work_phase *pp;
+    char buf[L5_PHASE_NAMELEN];
+    size_t i;
+
+    if (bytes != 0) {
+        for (i = 0; i < sizeof(buf) - 1 && name[i] != L'\0'; ++i) {
+            buf[i] = (char)name[i];
+        }
+
+        buf[i] = '\0';
+        prof_sum(buf, start, elapsed, bytes);
+    }
+
+    for (size_t i = 0; i < nphases; ++i) {
+        pp = &phases[i];
+        if (pp->name == name) {
+            pp->elapsed += elapsed;
+            pp->busy += busy;
+            pp->bytes += bytes;
+            return;
+        }
+    }
+
+    if (nphases >= WORK_MAX_PHASES) {
+        return;
+    }
+
+    pp = &phases[nphases++];
+    pp->name = name;
+    pp->elapsed = elapsed;
+    pp->busy = busy;
+    pp->bytes = bytes;
+}
+
+void
+work_init(void)
+{
+    EFI_GUID mp_guid = EFI_MP_SERVICES_PROTOCOL_GUID;
+    efi_status_t status;
+    uintn_t nproc, nenabled;
+
+    status = g_bootsrv->locate_protocol(&mp_guid, NULL, (void **)&mp);
+    if (EFI_ERROR(status)) {
+        mp = NULL;
+        return;
+    }
+
+    status = mp->GetNumberOfProcessors(mp, &nproc, &nenabled);
+    if (EFI_ERROR(status) || nenabled < 2) {
+        mp = NULL;
+        return;
+    }
+
+    /* Lets the BSP take a share while the APs run */
+    status = g_bootsrv->create_event(0, TPL_APPLICATION, NULL, NULL,
+        &done_ev);
+    if (EFI_ERROR(status)) {
+        mp = NULL;
+        return;
+    }
+
+    ncpu = nenabled;
+}
+
+/*
+ * Body of work_run(), the bytes moved by memory
+ * jobs are accounted to the phase as well.
+ *
+ * @bytes: Bytes the job moves, zero if it is not
+ *         a memory job
+ */
+static void
+work_spread(const uint16_t *phase, work_fn_t fn, void *arg, size_t n,
+    size_t grain, size_t bytes)
+{
+    struct work_job job;
+    efi_status_t status = EFI_NOT_STARTED;
+    uintn_t index;
+    uint64_t tsc;
+
+    if (n == 0) {
+        return;
+    }
+
+    job.fn = fn;
+    job.arg = arg;
+    job.n = n;
+    job.next = 0;
+    job.busy = 0;
+
+    /* A few shares per CPU evens out uneven CPUs */
+    job.share = ALIGN_UP(n / (ncpu * 4) + 1, grain);
+
+    tsc = rdtsc();
+    if (mp != NULL && n > job.share) {
+        status = mp->StartupAllAPs(mp, work_ap, 0, done_ev, 0, &job, NULL);
+    }
+
+    work_loop(&job);
+    if (!EFI_ERROR(status)) {
+        g_bootsrv->wait_for_event(1, &done_ev, &index);
+    }
+
+    work_account(phase, tsc, rdtsc() - tsc, job.busy, bytes);
+}
+
+void
+work_run(const uint16_t *phase, work_fn_t fn, void *arg, size_t n,
+    size_t grain)
+{
+    work_spread(phase, fn, arg, n, grain, 0);
+}
+
+/*
+ * Share of work_memcpy()
+ */
+static void
+work_memcpy_fn(void *arg, size_t start, size_t end)
+{
+    struct work_mem *wp = arg;
+
+    memcpy(wp->dst + start, wp->src + start, end - start);
+}
+
+/*
+ * Share of work_memset()
+ */
+static void
+work_memset_fn(void *arg, size_t start, size_t end)
+{
+    struct work_mem *wp = arg;
+
+    memset(wp->dst + start, wp->c, end - start);
+}
+
+/*
+ * Share of work_zero()
+ */
+static void
+work_zero_fn(void *arg, size_t start, size_t end)
+{
+    struct work_mem *wp = arg;
+
+    memset_nt(wp->dst + start, 0, end - start);
+}
+
+void
+work_memcpy(const uint16_t *phase, void *dst, const void *src, size_t n)
+{
+    struct work_mem wm = { .dst = dst, .src = src };
+
+    work_spread(phase, work_memcpy_fn, &wm, n, WORK_GRAIN, n);
+}
+
+void
+work_memset(const uint16_t *phase, void *dst, int c, size_t n)
+{
+    struct work_mem wm = { .dst = dst, .c = c };
+
+    work_spread(phase, work_memset_fn, &wm, n, WORK_GRAIN, n);
+}
+
+void
+work_zero(const uint16_t *phase, void *dst, size_t n)
+{
+    struct work_mem wm = { .dst = dst };
+    uint64_t tsc, elapsed;
+
+    if (n == 0) {
+        return;
+    }
+
+    /* Not worth waking anyone, and it may well be used soon */
+    if (n < WORK_ZERO_NT) {
+        tsc = rdtsc();
+        memset(dst, 0, n);
+        elapsed = rdtsc() - tsc;
+        work_account(phase, tsc, elapsed, elapsed, n);
+        return;
+    }
+
+    work_spread(phase, work_zero_fn, &wm, n, WORK_GRAIN, n);
+}
+
+void
+work_stat(void)
+{
+    struct work_phase *pp;
+    uint64_t speedup, rate;
+
+    log_info("** work: %zu cpus\n", ncpu);
+
+    for (size_t i = 0; i < nphases; ++i) {
+        pp = &phases[i];
+        if (pp->elapsed == 0) {
+            continue;
+        }
+
+        /* Work done over wall time, in hundredths */
+        speedup = pp->busy * 100 / pp->elapsed;
+        if (pp->bytes == 0) {
+            log_info("   %ls: %lu Kcycles, speedup %lu.%02lux\n", pp->name,
+                pp->elapsed / 1000, speedup / 100, speedup % 100);
+            continue;
+        }
+
+        /* Bytes per Kcycle, then hundredths of a GiB/s */
+        rate = pp->bytes * 1000 / pp->elapsed;
+        rate = (rate * (tsc_hz() / 1000) * 100) >> 30;
+        log_info("   %ls: %lu Kcycles, speedup %lu.%02lux, %lu.%02lu GiB/s\n",
+            pp->name, pp->elapsed / 1000, speedup / 100, speedup % 100,
+            rate / 100, rate % 100);
+    }
+}
@@ -36,12 +36,14 @@
 #define ISSET(v, f)  ((v) & (f))
 #define BIT(n) (1ULL << (n))
 #define MASK(n) ((1ULL << n) - 1)
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
 
 /* Align up/down a value */
 #define ALIGN_DOWN(value, align)      ((value) & ~((align)-1))
 #define ALIGN_UP(value, align)        (((value) + (align)-1) & ~((align)-1))
 
 #define die()                           \
+    log_flush();                        \
     puts(L"\r\n!! l5 panic !!\r\n");    \
     for (;;);
 
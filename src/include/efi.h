@@ -108,7 +108,9 @@ typedef uint8_t BOOLEAN;
 #define TRUE  1
 #define FALSE 0
 
+#ifndef NULL
 #define NULL 0
+#endif
 
 typedef uintmax_t uintn_t;
 typedef intmax_t  intn_t;
@@ -1249,7 +1251,7 @@ typedef struct EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL {
 /***********************/
 
 #define EFI_SPECIFICATION_VERSION   EFI_SYSTEM_TABLE_REVISION
-#define EFI_SYSTEM_TABLE_REVISION EFI_2_8_SYSTEM_TABLE_REVISION
+#define EFI_SYSTEM_TABLE_REVISION EFI_2_80_SYSTEM_TABLE_REVISION
 
 typedef struct {
     uint64_t  signature;
@@ -1599,6 +1601,23 @@ typedef struct EFI_GRAPHICS_OUTPUT_PROTOCOL {
     EFI_GRAPHICS_OUTPUT_PROTOCOL_MODE *mode;
 } EFI_GRAPHICS_OUTPUT_PROTOCOL;
 
+#define EFI_EDID_ACTIVE_PROTOCOL_GUID \
+    {0xbd8c1056,0x9f36,0x44ec,\
+    {0x92,0xa8,0xa6,0x33,0x7f,0x81,0x79,0x86}}
+
+#define EFI_EDID_DISCOVERED_PROTOCOL_GUID \
+    {0x1c0c34f6,0xd380,0x41fa,\
+    {0xa0,0x49,0x8a,0xd0,0x6c,0x1a,0x66,0xaa}}
+
+//
+// EDID of the display on a GOP handle, the active
+// and discovered protocols share this layout
+//
+typedef struct {
+    uint32_t size_of_edid;
+    uint8_t *edid;
+} EFI_EDID_PROTOCOL;
+
 //
 // ImageEntryPoint
 //
@@ -1833,7 +1852,7 @@ typedef struct EFI_FILE_SYSTEM_INFO {
 } EFI_FILE_SYSTEM_INFO;
 
 typedef struct EFI_FILE_SYSTEM_VOLUME_LABEL {
-    uint16_t VolumeLabel[];
+    uint16_t VolumeLabel[1];
 } EFI_FILE_SYSTEM_VOLUME_LABEL;
 
 typedef struct EFI_FILE_IO_TOKEN {
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _LFIVE_ARENA_H_
+#define _LFIVE_ARENA_H_ 1
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Size of the loader arena in pages */
+#define ARENA_NPAGES 128
+
+/*
+ * A bump allocator over a single range of pages,
+ * used for anything L5 only needs for itself. The
+ * handoff is packed from it after the exit, so its
+ * pages are never freed, the kernel takes them back
+ * through the reclaim list instead.
+ *
+ * @base: Base of the backing pages
+ * @size: Size of the backing pages in bytes
+ * @top: Offset of the next free byte
+ * @peak: Highest `top' ever reached
+ */
+struct arena {
+    uintptr_t base;
+    size_t size;
+    size_t top;
+    size_t peak;
+};
+
+/* Saved arena position for arena_rollback() */
+typedef size_t arena_mark_t;
+
+/* Loader wide arena */
+extern struct arena g_arena;
+
+/*
+ * Back an arena with newly allocated pages
+ *
+ * @ap: Arena to initialize
+ * @purpose: What the memory is for (L5_MEMP_*)
+ * @npages: Number of pages to back it with
+ *
+ * Returns zero on success
+ */
+int arena_init(struct arena *ap, uint32_t purpose, size_t npages);
+
+/*
+ * Allocate memory from an arena
+ *
+ * @ap: Arena to allocate from
+ * @size: Number of bytes to allocate
+ * @align: Alignment, must be a power of two
+ *
+ * Returns NULL if the arena is exhausted
+ */
+void *arena_alloc(struct arena *ap, size_t size, size_t align);
+
+/*
+ * Take a checkpoint of an arena
+ *
+ * @ap: Arena to checkpoint
+ */
+static inline arena_mark_t
+arena_mark(struct arena *ap)
+{
+    return ap->top;
+}
+
+/*
+ * Throw away everything allocated since
+ * a checkpoint
+ *
+ * @ap: Arena to roll back
+ * @mark: Checkpoint from arena_mark()
+ */
+static inline void
+arena_rollback(struct arena *ap, arena_mark_t mark)
+{
+    if (mark <= ap->top) {
+        ap->top = mark;
+    }
+}
+
+#endif  /* !_LFIVE_ARENA_H_ */
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _LFIVE_CMDLINE_H_
+#define _LFIVE_CMDLINE_H_ 1
+
+#include <stddef.h>
+#include <lfive/proto.h>
+
+/* Max number of options on the command line */
+#define CMDLINE_MAX_OPTS 128
+
+/*
+ * Split the kernel command line into options and
+ * hash them, done once before the exit.
+ *
+ * @str: NUL terminated command line
+ *
+ * Returns zero on success
+ */
+int cmdline_init(const char *str);
+
+/*
+ * Get the payload size of the L5_TAG_CMDLINE tag,
+ * zero if there is no command line.
+ */
+size_t cmdline_tag_size(void);
+
+/*
+ * Fill in an L5_TAG_CMDLINE tag, this makes no
+ * firmware calls.
+ *
+ * @tag: Zeroed tag of cmdline_tag_size() bytes
+ */
+void cmdline_fill(struct l5_tag_cmdline *tag);
+
+#endif  /* !_LFIVE_CMDLINE_H_ */
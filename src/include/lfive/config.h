@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _LFIVE_CONFIG_H_
+#define _LFIVE_CONFIG_H_ 1
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Max number of keys kept from the config file */
+#define CONFIG_MAX_KEYS 32
+
+/*
+ * Parse the loader config, a list of `key = value'
+ * lines. Blank lines and lines starting with `#' are
+ * skipped.
+ *
+ * @buf: Config file contents
+ * @size: Size of `buf' in bytes
+ *
+ * Returns zero on success
+ */
+int config_parse(const char *buf, size_t size);
+
+/*
+ * Get a config value
+ *
+ * @key: Key to look up
+ *
+ * Returns NULL if the key is not set
+ */
+const char *config_get(const char *key);
+
+/*
+ * Get a config value as a number, decimal or hex
+ * with a 0x prefix.
+ *
+ * @key: Key to look up
+ * @def: Returned if the key is not set or bad
+ */
+uint64_t config_get_num(const char *key, uint64_t def);
+
+#endif  /* !_LFIVE_CONFIG_H_ */
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _LFIVE_ELF_H_
+#define _LFIVE_ELF_H_ 1
+
+#include <stdint.h>
+#include <stddef.h>
+#include <elf.h>
+#include <lfive/proto.h>
+#include <machine/mmu.h>
+
+/*
+ * Describes a kernel image loaded into memory
+ *
+ * @ehdr: ELF header (within the file buffer)
+ * @phdr: Program headers (within the file buffer)
+ * @entry: Entry point
+ * @vbase: Virtual base, aligned down to `align'
+ * @pbase: Physical base the image was placed at
+ * @npages: Number of pages backing the image
+ * @align: Alignment of `pbase'
+ */
+struct elf_image {
+    Elf64_Ehdr *ehdr;
+    Elf64_Phdr *phdr;
+    uintptr_t entry;
+    uintptr_t vbase;
+    uintptr_t pbase;
+    size_t npages;
+    size_t align;
+};
+
+/*
+ * Check that an ELF file is a kernel we can load
+ *
+ * @img: File buffer
+ * @size: Size of the file buffer
+ *
+ * Returns zero if the image is valid
+ */
+int elf_check(void *img, size_t size);
+
+/*
+ * Find a note in the PT_NOTE segments of an ELF file,
+ * only needs the file to have passed elf_check().
+ *
+ * @img: File buffer
+ * @size: Size of the file buffer
+ * @name: Note name (owner)
+ * @type: Note type
+ * @descsz_res: Size of the note payload is written here
+ *
+ * Returns a pointer to the note payload within the
+ * file buffer, or NULL if there is no such note.
+ */
+void *elf_find_note(void *img, size_t size, const char *name, uint32_t type,
+    size_t *descsz_res);
+
+/*
+ * Place an ELF kernel physically and copy its loadable
+ * segments in. The image is placed as one contiguous
+ * block aligned to 2 MiB, or to 1 GiB if any segment
+ * asks for that alignment, so that it can be mapped
+ * with huge pages.
+ *
+ * @img: File buffer
+ * @size: Size of the file buffer
+ * @map: Memory map to look for a home in
+ * @nent: Number of entries in `map'
+ * @res: Loaded image is described here
+ *
+ * Returns zero on success
+ */
+int elf_load(void *img, size_t size, struct l5_mementry *map, size_t nent,
+    struct elf_image *res);
+
+/*
+ * Map a loaded image into an address space with
+ * huge pages wherever segment permissions allow
+ *
+ * @ip: Image from elf_load()
+ * @vas: Address space to map into
+ *
+ * Returns zero on success
+ */
+int elf_map(struct elf_image *ip, struct mmu_vas *vas);
+
+#endif  /* !_LFIVE_ELF_H_ */
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _LFIVE_HANDOFF_H_
+#define _LFIVE_HANDOFF_H_ 1
+
+#include <stdint.h>
+#include <stddef.h>
+#include <lfive/proto.h>
+
+/*
+ * What L5 gathers on the way to the kernel before it
+ * is packed into the protocol block.
+ *
+ * @fbinfo: Framebuffer information
+ * @memmap: L5 memory map
+ * @memmap_nent: Number of entries in `memmap'
+ * @memmap_cap: Number of entries `memmap' has room for
+ * @tsc_exit: TSC when boot services were exited
+ * @tsc_entry: TSC when the loader was entered
+ * @tsc_load: TSC once the kernel was loaded
+ */
+struct l5_bootinfo {
+    struct l5_fbinfo fbinfo;
+    struct l5_mementry *memmap;
+    size_t memmap_nent;
+    size_t memmap_cap;
+    uint64_t tsc_exit;
+    uint64_t tsc_entry;
+    uint64_t tsc_load;
+};
+
+extern struct l5_bootinfo g_lfive;
+
+/*
+ * Set aside room for a tag in the protocol block,
+ * this must be done for every tag before the block
+ * is allocated.
+ *
+ * @size: Size of the tag payload, excluding its header
+ */
+void handoff_reserve(size_t size);
+
+/*
+ * Allocate the protocol block with room for every
+ * tag reserved so far, boot services must be up.
+ *
+ * Returns NULL on failure
+ */
+struct l5_proto *handoff_alloc(void);
+
+/*
+ * Append a zeroed tag to the protocol block, this
+ * makes no firmware calls.
+ *
+ * @type: Tag type (L5_TAG_*)
+ * @size: Size of the tag payload, excluding its header
+ *
+ * Returns NULL if the tag is over budget
+ */
+void *handoff_tag(uint32_t type, size_t size);
+
+/*
+ * Close off the protocol block
+ *
+ * Returns the protocol header
+ */
+struct l5_proto *handoff_finish(void);
+
+#endif  /* !_LFIVE_HANDOFF_H_ */
@@ -31,10 +31,118 @@
 #define _LFIVE_LOG_H_ 1
 
 #include <efi.h>
+#include <stddef.h>
+#include <lfive/proto.h>
 
 extern EFI_SYSTEM_TABLE *g_systab;
 
-#define puts(...) \
-    g_systab->con_out->output_string(g_systab->con_out, __VA_ARGS__)
+/* Log levels, lower is more severe */
+#define LOG_ERR     0
+#define LOG_WARN    1
+#define LOG_INFO    2
+#define LOG_DEBUG   3
+
+/* Size of the log ring, a power of two */
+#define LOG_RING_SIZE   0x8000
+
+/* Bytes of console output held back before a flush */
+#define LOG_BATCH       0x400
+
+#define log_err(...)    log_write(LOG_ERR, __VA_ARGS__)
+#define log_warn(...)   log_write(LOG_WARN, __VA_ARGS__)
+#define log_info(...)   log_write(LOG_INFO, __VA_ARGS__)
+#define log_debug(...)  log_write(LOG_DEBUG, __VA_ARGS__)
+
+/* Console outputs */
+#define CON_SCREEN  0x01    /* Framebuffer console or firmware text */
+#define CON_SERIAL  0x02    /* UART, once set up */
+
+#define puts(...) con_puts(__VA_ARGS__)
+
+/*
+ * Write a string to the console, this is the
+ * framebuffer console once it is up and firmware
+ * text output before that.
+ *
+ * @s: NUL terminated UCS-2 string
+ */
+void con_puts(const uint16_t *s);
+
+/*
+ * Pick which outputs the console writes to
+ *
+ * @mask: CON_* bits
+ */
+void con_select(int mask);
+
+/*
+ * Log how fast each console output has been, in
+ * TSC cycles per byte written.
+ */
+void con_stat(void);
+
+/*
+ * Stop using firmware text output, called right
+ * after ExitBootServices(). Only the framebuffer
+ * console is written to from here on.
+ */
+void con_exit_bootsrv(void);
+
+/*
+ * Set how much of the log reaches the console
+ *
+ * @mode: "quiet" (errors only), "info" or "debug",
+ *        NULL keeps the default of "info"
+ */
+void log_init(const char *mode);
+
+/*
+ * Format a message into the log ring, one call
+ * is one line. Errors and warnings reach the
+ * console at once, the rest is batched.
+ *
+ * Takes %d, %i, %u, %x, %X, %c, %s, %ls (UCS-2),
+ * %p and %%, with the '0' and '-' flags and a
+ * width ('*' takes it as an int argument).
+ * Integers are 32 bits wide unless given an 'l',
+ * 'll' or 'z' modifier which all mean 64 bits.
+ *
+ * @level: Message level (LOG_*)
+ * @fmt: Format string
+ */
+void log_write(int level, const char *fmt, ...);
+
+/*
+ * Format into a buffer like log_write() does, output
+ * past `size' - 1 bytes is cut. The result is always
+ * NUL terminated.
+ *
+ * @buf: Buffer to format into
+ * @size: Size of `buf' in bytes
+ * @fmt: Format string
+ *
+ * Returns the length of the result
+ */
+size_t log_snprintf(char *buf, size_t size, const char *fmt, ...);
+
+/*
+ * Push everything held back out to the console
+ */
+void log_flush(void);
+
+/*
+ * Get the payload size of the L5_TAG_LOG tag for
+ * what has been logged so far, this never takes
+ * more than LOG_RING_SIZE bytes of text.
+ */
+size_t log_tag_size(void);
+
+/*
+ * Fill in an L5_TAG_LOG tag with the contents of
+ * the ring, this makes no firmware calls.
+ *
+ * @tag: Tag of log_tag_size() bytes
+ */
+void log_fill(struct l5_tag_log *tag);
 
 #endif  /* !_LFIVE_LOG_H_ */
@@ -30,6 +30,9 @@
 #ifndef _LFIVE_MEM_H_
 #define _LFIVE_MEM_H_ 1
 
+#include <stdint.h>
+#include <lfive/proto.h>
+
 /* Higher half (kernel) */
 #define KERNEL_BASE 0xFFFFFFFF80000000
 
@@ -37,4 +40,84 @@
 #define MEM_1GIB 0x40000000
 #define MEM_2MIB 0x200000
 
+/* Max number of ranges mem_report() gives back */
+#define MEM_MAX_RANGES 128
+
+/* Page size used by the allocators */
+#define MEM_PAGESIZE 4096
+
+/*
+ * Everything L5 allocates for itself stays below this
+ * so it is reachable through the identity map.
+ */
+#define MEM_IDENT_LIMIT 0x100000000ULL
+
+/*
+ * Allocate pages for a specific purpose, every
+ * allocation L5 makes should go through here so
+ * it can be accounted for.
+ *
+ * @purpose: What the memory is for (L5_MEMP_*)
+ * @npages: Number of pages to allocate
+ * @res: Physical base is written here
+ *
+ * Returns zero on success
+ */
+int mem_alloc_pages(uint32_t purpose, size_t npages, uintptr_t *res);
+
+/*
+ * Like mem_alloc_pages() but at a fixed physical
+ * address, only usable while boot services are up.
+ *
+ * @purpose: What the memory is for (L5_MEMP_*)
+ * @base: Physical base to allocate at
+ * @npages: Number of pages to allocate
+ *
+ * Returns zero on success
+ */
+int mem_alloc_at(uint32_t purpose, uintptr_t base, size_t npages);
+
+/*
+ * Like mem_alloc_pages() but takes a size in bytes
+ * and returns a pointer.
+ *
+ * @purpose: What the memory is for (L5_MEMP_*)
+ * @size: Number of bytes to allocate
+ *
+ * Returns NULL on failure
+ */
+void *mem_alloc(uint32_t purpose, size_t size);
+
+/*
+ * Free pages allocated by mem_alloc_pages()
+ * or mem_alloc().
+ *
+ * @base: Physical base
+ * @npages: Number of pages to free
+ */
+void mem_free_pages(uintptr_t base, size_t npages);
+
+/*
+ * Serve allocations from the physical allocator from
+ * now on, must be called once boot services are gone
+ * and phys_init() is done.
+ */
+void mem_exit_bootsrv(void);
+
+/*
+ * Report the L5 owned ranges the kernel can
+ * reclaim. No allocations may be done after this.
+ *
+ * @buf: Ranges are written here
+ * @max: Max number of ranges `buf' can take
+ *
+ * Returns the number of ranges written
+ */
+size_t mem_report(struct l5_memrange *buf, size_t max);
+
+/*
+ * Print the high-water mark of each purpose
+ */
+void mem_stat(void);
+
 #endif  /* !_LFIVE_MEM_H_ */
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _LFIVE_PHYS_H_
+#define _LFIVE_PHYS_H_ 1
+
+#include <stdint.h>
+#include <stddef.h>
+#include <lfive/proto.h>
+
+/* Max number of free and used ranges tracked */
+#define PHYS_MAX_RANGES 64
+
+/*
+ * Seed the physical allocator from the final memory
+ * map, this is meant to be used once boot services
+ * are gone and the firmware allocator with them.
+ *
+ * @map: Memory map to take free ranges from
+ * @nent: Number of entries in `map'
+ *
+ * Returns zero on success
+ */
+int phys_init(struct l5_mementry *map, size_t nent);
+
+/*
+ * Allocate physically contiguous pages
+ *
+ * @npages: Number of pages to allocate
+ * @align: Alignment in bytes, must be a power of two
+ * @res: Physical base is written here
+ *
+ * Returns zero on success
+ */
+int phys_alloc(size_t npages, size_t align, uintptr_t *res);
+
+/*
+ * Carve every range handed out by phys_alloc() out of
+ * the usable entries in the memory map so the kernel
+ * sees them as in use by L5.
+ *
+ * @map: Memory map to update
+ * @nent: Number of entries, updated on return
+ * @cap: Number of entries `map' has room for
+ *
+ * Returns zero on success
+ */
+int phys_commit(struct l5_mementry *map, size_t *nent, size_t cap);
+
+#endif  /* !_LFIVE_PHYS_H_ */
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _LFIVE_PROF_H_
+#define _LFIVE_PROF_H_ 1
+
+#include <stddef.h>
+#include <lfive/proto.h>
+
+/* Max number of phases recorded, later ones are dropped */
+#define PROF_MAX_PHASES 32
+
+/*
+ * Mark the start of a loader phase, phases may nest.
+ * This is a TSC read and a table store so it is fine
+ * to use anywhere, also past the exit.
+ *
+ * @name: Phase name, cut to L5_PHASE_NAMELEN - 1
+ * @flags: Phase flags (L5_PHASEF_*)
+ *
+ * Returns a handle for prof_end(), -1 if the table
+ * is full
+ */
+int prof_begin(const char *name, uint16_t flags);
+
+/*
+ * Mark the end of a loader phase
+ *
+ * @id: Handle from prof_begin()
+ */
+void prof_end(int id);
+
+/*
+ * Add a span to a job done in pieces, the first span
+ * makes an L5_PHASEF_SUM phase of `name' nested in
+ * whatever phase is running.
+ *
+ * @name: Phase name, shorter than L5_PHASE_NAMELEN
+ * @start: TSC when the span began
+ * @cycles: TSC ticks the span took
+ * @bytes: Bytes the span copied or zeroed
+ */
+void prof_sum(const char *name, uint64_t start, uint64_t cycles,
+    uint64_t bytes);
+
+/*
+ * Log a summary of the phases so far, time spent
+ * waiting on a human is left out of the total.
+ */
+void prof_stat(void);
+
+/*
+ * Get the payload size of the L5_TAG_PHASES tag,
+ * this is for a full table.
+ */
+size_t prof_tag_size(void);
+
+/*
+ * Fill in an L5_TAG_PHASES tag, this makes no
+ * firmware calls.
+ *
+ * @tag: Tag of prof_tag_size() bytes
+ */
+void prof_fill(struct l5_tag_phases *tag);
+
+#endif  /* !_LFIVE_PROF_H_ */
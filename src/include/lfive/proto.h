@@ -33,39 +33,790 @@
 #include <stdint.h>
 
 /*
- * Framebuffer information
+ * Framebuffer information, pixels are always 32 bits
+ * wide and laid out as given by the channel masks.
  *
  * @io: Framebuffer base
- * @pitch: Framebuffer pitch
- * @width: Framebuffer height
- * @height: Framebuffer height
+ * @pitch: Bytes per scanline
+ * @width: Framebuffer width in pixels
+ * @height: Framebuffer height in pixels
+ * @bpp: Bits per pixel
+ * @size: Framebuffer size in bytes
+ * @red_mask: Red channel bits of a pixel
+ * @green_mask: Green channel bits of a pixel
+ * @blue_mask: Blue channel bits of a pixel
+ * @reserved_mask: Unused bits of a pixel
  */
 struct l5_fbinfo {
     uint32_t *io;
     uint32_t pitch;
     uint32_t width;
     uint32_t height;
+    uint32_t bpp;
+    uint64_t size;
+    uint32_t red_mask;
+    uint32_t green_mask;
+    uint32_t blue_mask;
+    uint32_t reserved_mask;
 };
 
+/*
+ * Memory map entry types, normalized from the
+ * firmware specific types.
+ */
+#define L5_MEM_USABLE       0x00    /* Free for use */
+#define L5_MEM_RESERVED     0x01    /* Reserved, do not touch */
+#define L5_MEM_ACPI_RECLAIM 0x02    /* Usable once ACPI tables are parsed */
+#define L5_MEM_ACPI_NVS     0x03    /* ACPI non-volatile storage */
+#define L5_MEM_MMIO         0x04    /* Memory mapped I/O */
+#define L5_MEM_BAD          0x05    /* Faulty memory */
+#define L5_MEM_LOADER       0x06    /* In use by L5 or the kernel image */
+#define L5_MEM_PERSISTENT   0x07    /* Persistent (non-volatile) memory */
+
+/*
+ * Memory map entry flags, the low bits describe which
+ * cacheability attributes a region is capable of.
+ */
+#define L5_MEMF_UC          0x0001  /* Uncacheable */
+#define L5_MEMF_WC          0x0002  /* Write-combining */
+#define L5_MEMF_WT          0x0004  /* Write-through */
+#define L5_MEMF_WB          0x0008  /* Write-back */
+#define L5_MEMF_UCE         0x0010  /* Uncacheable, exported */
+#define L5_MEMF_CACHEMASK   0x001F
+#define L5_MEMF_BOOTSRV     0x4000  /* Boot services memory, L5 stack */
+#define L5_MEMF_RUNTIME     0x8000  /* Used by firmware runtime services */
+
+/*
+ * Preferred memory type, this is the fastest type
+ * that is legal for a region.
+ */
+#define L5_CACHE_WB         0x00    /* Write-back */
+#define L5_CACHE_WT         0x01    /* Write-through */
+#define L5_CACHE_WC         0x02    /* Write-combining */
+#define L5_CACHE_UC         0x03    /* Uncacheable */
+
 /*
  * Describes a memory map entry
  *
  * @base: Base address
  * @npages: Number of pages in this region
+ * @type: Region type (L5_MEM_*)
+ * @flags: Region flags (L5_MEMF_*)
+ * @cache: Preferred memory type (L5_CACHE_*)
  */
 struct l5_mementry {
     uintptr_t base;
     size_t npages;
+    uint32_t type;
+    uint16_t flags;
+    uint8_t cache;
+    uint8_t reserved;
+};
+
+/*
+ * Purpose of memory allocated by L5
+ */
+#define L5_MEMP_KERNEL      0x00    /* Kernel image */
+#define L5_MEMP_MODULE      0x01    /* Boot modules */
+#define L5_MEMP_PGTBL       0x02    /* Page tables, reclaim after own VAS */
+#define L5_MEMP_HANDOFF     0x03    /* Handoff data, reclaim once parsed */
+#define L5_MEMP_LOADER      0x04    /* Loader internal, reclaim at once */
+#define L5_MEMP_SCRATCH     0x05    /* Scratch, freed with boot services */
+#define L5_MEMP_SMP         0x06    /* AP trampoline, see L5_TAG_SMP */
+#define L5_MEMP_MAX         0x07
+
+/*
+ * Describes a range of memory allocated by L5
+ *
+ * @base: Base address
+ * @npages: Number of pages in this range
+ * @purpose: What the range is used for (L5_MEMP_*)
+ */
+struct l5_memrange {
+    uintptr_t base;
+    size_t npages;
+    uint32_t purpose;
+    uint32_t reserved;
+};
+
+/*
+ * The L5 protocol is a single page aligned block made
+ * of a header followed by typed, length prefixed tags
+ * and closed off by an L5_TAG_END tag. Tags the kernel
+ * does not know about can be skipped by their size.
+ */
+#define L5_PROTO_MAGIC      0x4F48354C  /* "L5HO" */
+#define L5_PROTO_VERSION    1
+
+/* Tags are aligned to this within the block */
+#define L5_TAG_ALIGN        8
+
+/* Tag types */
+#define L5_TAG_END          0x00    /* Last tag */
+#define L5_TAG_MEMMAP       0x01    /* struct l5_tag_memmap */
+#define L5_TAG_FB           0x02    /* struct l5_tag_fb */
+#define L5_TAG_MODULES      0x03    /* struct l5_tag_modules */
+#define L5_TAG_ACPI         0x04    /* struct l5_tag_acpi */
+#define L5_TAG_SMP          0x05    /* struct l5_tag_smp */
+#define L5_TAG_TIMING       0x06    /* struct l5_tag_timing */
+#define L5_TAG_RECLAIM      0x07    /* struct l5_tag_reclaim */
+#define L5_TAG_HHDM         0x08    /* struct l5_tag_hhdm */
+#define L5_TAG_TOPO         0x09    /* struct l5_tag_topo */
+#define L5_TAG_TSC          0x0A    /* struct l5_tag_tsc */
+#define L5_TAG_CPU          0x0B    /* struct l5_tag_cpu */
+#define L5_TAG_CMDLINE      0x0C    /* struct l5_tag_cmdline */
+#define L5_TAG_LOG          0x0D    /* struct l5_tag_log */
+#define L5_TAG_PHASES       0x0E    /* struct l5_tag_phases */
+
+/*
+ * The kernel tells L5 what it wants with an ELF note
+ * (PT_NOTE) named L5_NOTE_NAME of type L5_NOTE_REQUEST
+ * holding a struct l5_request. Anything not asked for
+ * is not done. Without the note L5 acts as if
+ * L5_REQ_DEFAULT was asked for.
+ */
+#define L5_NOTE_NAME        "L5"
+#define L5_NOTE_REQUEST     0x4C350001
+#define L5_REQUEST_VERSION  1
+
+/* Request flags */
+#define L5_REQ_FB           0x0001  /* Framebuffer wanted */
+#define L5_REQ_HHDM         0x0002  /* Higher half direct map wanted */
+#define L5_REQ_IDMAP        0x0004  /* Lower 4 GiB identity map wanted */
+#define L5_REQ_MEMMAP       0x0008  /* Memory map wanted */
+#define L5_REQ_SMP          0x0010  /* Application processors wanted */
+#define L5_REQ_TOPO         0x0020  /* CPU topology wanted */
+#define L5_REQ_ACPI         0x0040  /* ACPI table index wanted */
+#define L5_REQ_LOG          0x0080  /* Loader log wanted */
+#define L5_REQ_DEFAULT      (L5_REQ_FB | L5_REQ_IDMAP | L5_REQ_MEMMAP)
+
+/* Paging modes */
+#define L5_PAGING_4LVL      4
+#define L5_PAGING_5LVL      5
+
+/* Limits for boot modules */
+#define L5_MAX_MODULES      8
+#define L5_MODNAME_MAX      32
+
+/* Base of the higher half direct map */
+#define L5_HHDM_BASE        0xFFFF800000000000
+
+/*
+ * Kernel request, the payload of the request note
+ *
+ * @version: Always L5_REQUEST_VERSION
+ * @flags: What the kernel wants (L5_REQ_*)
+ * @stack_size: Size of the entry stack, zero for default
+ * @paging_mode: Paging mode wanted (L5_PAGING_*)
+ * @nmodules: Number of entries in `modules'
+ * @modules: NUL terminated file names of boot modules
+ */
+struct l5_request {
+    uint32_t version;
+    uint32_t flags;
+    uint64_t stack_size;
+    uint32_t paging_mode;
+    uint32_t nmodules;
+    char modules[L5_MAX_MODULES][L5_MODNAME_MAX];
+};
+
+/*
+ * Describes a boot module
+ *
+ * @base: Physical base
+ * @size: Size in bytes
+ * @name: File name the module was loaded from
+ */
+struct l5_module {
+    uint64_t base;
+    uint64_t size;
+    char name[L5_MODNAME_MAX];
 };
 
 /*
  * Describes the main L5 protocol handle from where
  * the bootloader can pass information to the OS
- * environment
+ * environment, this is the header of the block.
+ *
+ * @magic: Always L5_PROTO_MAGIC
+ * @version: Always L5_PROTO_VERSION
+ * @hdr_size: Size of this header
+ * @size: Bytes in use, including this header
+ * @budget: Bytes set aside for the block
+ * @ntags: Number of tags, not counting L5_TAG_END
  */
 struct l5_proto {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t hdr_size;
+    uint32_t size;
+    uint32_t budget;
+    uint32_t ntags;
+    uint32_t reserved;
+};
+
+/*
+ * Header common to every tag
+ *
+ * @type: Tag type (L5_TAG_*)
+ * @size: Size of the tag, including this header
+ */
+struct l5_tag {
+    uint32_t type;
+    uint32_t size;
+};
+
+/*
+ * Memory map
+ *
+ * @entsize: Size of each entry
+ * @nent: Number of entries
+ */
+struct l5_tag_memmap {
+    struct l5_tag tag;
+    uint32_t entsize;
+    uint32_t nent;
+    struct l5_mementry ent[];
+};
+
+/*
+ * Framebuffer
+ */
+struct l5_tag_fb {
+    struct l5_tag tag;
     struct l5_fbinfo fbinfo;
-    struct l5_mementry *memmap;
 };
 
+/*
+ * Loader owned ranges the kernel may reclaim
+ *
+ * @nent: Number of entries
+ */
+struct l5_tag_reclaim {
+    struct l5_tag tag;
+    uint32_t nent;
+    uint32_t reserved;
+    struct l5_memrange ent[];
+};
+
+/*
+ * Boot modules
+ *
+ * @nmod: Number of modules
+ */
+struct l5_tag_modules {
+    struct l5_tag tag;
+    uint32_t nmod;
+    uint32_t reserved;
+    struct l5_module mod[];
+};
+
+/*
+ * Higher half direct map, all of physical memory up
+ * to the last non-device region (at least 4 GiB) is
+ * mapped at `offset'.
+ */
+struct l5_tag_hhdm {
+    struct l5_tag tag;
+    uint64_t offset;
+};
+
+/*
+ * Every application processor is parked by L5 in long
+ * mode on the kernel page tables, spinning on its own
+ * cache line sized mailbox. To start an AP the kernel
+ * fills in `stack' and `arg' and then stores the entry
+ * point to `goto_address'. The AP jumps there with the
+ * mailbox in %rdi, interrupts off and on the L5 GDT.
+ *
+ * Parked APs still run in the trampoline page below
+ * 1 MiB and poll the mailboxes within this tag, so the
+ * kernel must not reuse either until every AP has been
+ * sent on through `goto_address'. The trampoline page
+ * is never in the reclaim list, the handoff block is
+ * only free once this is done.
+ */
+#define L5_MBOX_SIZE        64
+#define L5_MBOX_PARKED      0x0001  /* Parked, waiting on goto_address */
+#define L5_MBOX_BSP         0x0002  /* Bootstrap processor, never parked */
+
+/*
+ * Per-CPU mailbox
+ *
+ * @apic_id: Local APIC ID of the CPU
+ * @flags: Mailbox flags (L5_MBOX_*)
+ * @goto_address: Written last by the kernel to start the CPU
+ * @arg: Free for use by the kernel
+ * @stack: Stack pointer to start with, zero leaves %rsp alone
+ */
+struct l5_mailbox {
+    uint32_t apic_id;
+    uint32_t flags;
+    uint64_t goto_address;
+    uint64_t arg;
+    uint64_t stack;
+    uint64_t reserved[4];
+};
+
+/*
+ * Application processors, the mailboxes are L5_MBOX_SIZE
+ * aligned and start `mbox_offset' bytes into the tag.
+ *
+ * @ncpu: Number of CPUs, including the BSP
+ * @bsp_apic_id: Local APIC ID of the BSP
+ * @mbox_offset: Offset of the first mailbox from the tag
+ */
+struct l5_tag_smp {
+    struct l5_tag tag;
+    uint32_t ncpu;
+    uint32_t bsp_apic_id;
+    uint32_t mbox_offset;
+    uint32_t reserved;
+};
+
+/* Cache types */
+#define L5_CACHET_DATA      0x01    /* Data cache */
+#define L5_CACHET_INST      0x02    /* Instruction cache */
+#define L5_CACHET_UNIFIED   0x03    /* Unified cache */
+
+/* Max number of caches described */
+#define L5_MAX_CACHES       8
+
+/*
+ * Describes a cache, CPUs share an instance of it if
+ * their APIC IDs are the same under `share_mask'.
+ *
+ * @level: Cache level, starting at 1
+ * @type: Cache type (L5_CACHET_*)
+ * @line_size: Line size in bytes
+ * @size: Size in bytes
+ * @ways: Number of ways
+ * @share_mask: APIC ID mask of CPUs sharing an instance
+ */
+struct l5_cache {
+    uint8_t level;
+    uint8_t type;
+    uint16_t line_size;
+    uint32_t size;
+    uint32_t ways;
+    uint32_t share_mask;
+};
+
+/*
+ * Describes a CPU
+ *
+ * @apic_id: Local APIC (or x2APIC) ID
+ * @package: Package index
+ * @core: Core index within the package
+ * @thread: SMT thread index within the core
+ */
+struct l5_cpu {
+    uint32_t apic_id;
+    uint32_t package;
+    uint32_t core;
+    uint32_t thread;
+};
+
+/*
+ * CPU topology, the caches are read on the BSP and
+ * hold for every CPU.
+ *
+ * @ncache: Number of valid entries in `cache'
+ * @ncpu: Number of entries in `cpu'
+ */
+struct l5_tag_topo {
+    struct l5_tag tag;
+    uint32_t ncache;
+    uint32_t ncpu;
+    struct l5_cache cache[L5_MAX_CACHES];
+    struct l5_cpu cpu[];
+};
+
+/*
+ * Vendor GUID of the variables L5 keeps, as an EFI_GUID
+ * initializer
+ */
+#define L5_VENDOR_GUID \
+    {0x6c35d1a0, 0x8e4b, 0x4f27, {0x9d, 0x21, 0x5a, 0x0b, 0x7e, 0x4c, 0x13, 0x88}}
+
+/*
+ * L5 does not write flash once boot services are gone,
+ * so the exit to kernel latency is only tracked if the
+ * kernel stores it. It goes in this variable as a
+ * uint64_t of TSC cycles from tsc_exit to the kernel's
+ * first instruction, non-volatile with boot services
+ * and runtime access. L5 prints it on the next boot.
+ */
+#define L5_HANDOFF_VAR      u"L5HandoffCycles"
+
+/*
+ * Loader timestamps
+ *
+ * @tsc_exit: TSC when boot services were exited
+ * @tsc_handoff: TSC right before the jump to the kernel, the
+ *               last thing L5 does
+ * @tsc_entry: TSC when the loader was entered
+ * @tsc_load: TSC once the kernel was loaded
+ */
+struct l5_tag_timing {
+    struct l5_tag tag;
+    uint64_t tsc_exit;
+    uint64_t tsc_handoff;
+    uint64_t tsc_entry;
+    uint64_t tsc_load;
+};
+
+/* Longest loader phase name, including the NUL */
+#define L5_PHASE_NAMELEN    16
+
+/* Phase flags */
+#define L5_PHASEF_WAIT      0x0001  /* Waiting on a human */
+#define L5_PHASEF_SUM       0x0002  /* Sum of several spans */
+
+/*
+ * Loader phase, a phase still running at the packing
+ * has a zero `end'. With L5_PHASEF_SUM the phase is a
+ * job done in pieces, such as zeroing the kernel, and
+ * `end - start' is the time all of them took.
+ *
+ * @name: NUL terminated phase name
+ * @flags: Phase flags (L5_PHASEF_*)
+ * @depth: Nesting depth, zero for top level phases
+ * @start: TSC when the phase began
+ * @end: TSC when the phase ended
+ * @bytes: Bytes copied or zeroed, zero for other phases
+ */
+struct l5_phase {
+    char name[L5_PHASE_NAMELEN];
+    uint16_t flags;
+    uint16_t depth;
+    uint32_t reserved;
+    uint64_t start;
+    uint64_t end;
+    uint64_t bytes;
+};
+
+/*
+ * Where the loader spent its time, phases are in the
+ * order they began. The TSC frequency is in L5_TAG_TSC.
+ *
+ * @nphase: Number of entries in `phase'
+ */
+struct l5_tag_phases {
+    struct l5_tag tag;
+    uint32_t nphase;
+    uint32_t reserved;
+    struct l5_phase phase[];
+};
+
+/* How the TSC frequency was found */
+#define L5_TSC_STALL        0x00    /* Timed against boot services Stall() */
+#define L5_TSC_CPUID15      0x01    /* CPUID leaf 0x15 */
+#define L5_TSC_CPUID16      0x02    /* CPUID leaf 0x15 ratio, 0x16 base */
+#define L5_TSC_HYPERVISOR   0x03    /* Hypervisor CPUID leaf 0x40000010 */
+
+/* TSC flags */
+#define L5_TSCF_INVARIANT   0x0001  /* Constant rate in every P/C-state */
+
+/*
+ * TSC calibration, lets the kernel skip its own
+ *
+ * @freq: TSC frequency in Hz
+ * @method: How `freq' was found (L5_TSC_*)
+ * @flags: TSC flags (L5_TSCF_*)
+ */
+struct l5_tag_tsc {
+    struct l5_tag tag;
+    uint64_t freq;
+    uint32_t method;
+    uint32_t flags;
+};
+
+/*
+ * CPU features L5 turned on, these hold on the BSP
+ * and on every parked AP.
+ */
+#define L5_CPUF_SSE         0x0001  /* SSE, CR4.OSFXSR and OSXMMEXCPT */
+#define L5_CPUF_XSAVE       0x0002  /* CR4.OSXSAVE, see `xcr0' */
+#define L5_CPUF_AVX         0x0004  /* AVX state enabled in XCR0 */
+#define L5_CPUF_AVX512      0x0008  /* AVX-512 state enabled in XCR0 */
+#define L5_CPUF_PGE         0x0010  /* Global pages, kernel half is global */
+#define L5_CPUF_PCID        0x0020  /* CR4.PCIDE */
+#define L5_CPUF_SMEP        0x0040  /* CR4.SMEP */
+#define L5_CPUF_SMAP        0x0080  /* CR4.SMAP */
+#define L5_CPUF_NX          0x0100  /* EFER.NXE */
+
+/*
+ * CPU state the kernel is entered with
+ *
+ * @features: Enabled features (L5_CPUF_*)
+ * @xcr0: XCR0, zero without L5_CPUF_XSAVE
+ * @cr0: CR0
+ * @cr4: CR4
+ */
+struct l5_tag_cpu {
+    struct l5_tag tag;
+    uint32_t features;
+    uint32_t reserved;
+    uint64_t xcr0;
+    uint64_t cr0;
+    uint64_t cr4;
+};
+
+/* Build an ACPI signature from its four characters */
+#define L5_ACPI_SIG(a, b, c, d) \
+    ((uint32_t)(a) | ((uint32_t)(b) << 8) | \
+    ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+
+/*
+ * ACPI index slot, unused slots have a zero `sig'
+ *
+ * @sig: Table signature, see L5_ACPI_SIG()
+ * @instance: Index among tables with the same signature
+ * @addr: Physical address of the table
+ * @length: Length of the table in bytes
+ * @revision: Table revision
+ */
+struct l5_acpi_ent {
+    uint32_t sig;
+    uint32_t instance;
+    uint64_t addr;
+    uint32_t length;
+    uint8_t revision;
+    uint8_t reserved[3];
+};
+
+/*
+ * ACPI tables with a good checksum, in an open
+ * addressed hash table keyed by signature and
+ * instance. See l5_acpi_find().
+ *
+ * @rsdp: Physical address of the RSDP
+ * @revision: RSDP revision
+ * @nslot: Number of slots, a power of two
+ * @nent: Number of slots in use
+ */
+struct l5_tag_acpi {
+    struct l5_tag tag;
+    uint64_t rsdp;
+    uint32_t revision;
+    uint32_t nslot;
+    uint32_t nent;
+    uint32_t reserved;
+    struct l5_acpi_ent slot[];
+};
+
+/*
+ * Hash of an ACPI index key
+ *
+ * @sig: Table signature
+ * @instance: Index among tables with the same signature
+ */
+static inline uint32_t
+l5_acpi_hash(uint32_t sig, uint32_t instance)
+{
+    uint32_t h = sig * 0x9E3779B1 + instance * 0x85EBCA77;
+
+    return h ^ (h >> 15);
+}
+
+/*
+ * Look up an ACPI table
+ *
+ * @tag: ACPI tag
+ * @sig: Table signature, see L5_ACPI_SIG()
+ * @instance: Index among tables with the same signature
+ *
+ * Returns NULL if there is no such table
+ */
+static inline struct l5_acpi_ent *
+l5_acpi_find(struct l5_tag_acpi *tag, uint32_t sig, uint32_t instance)
+{
+    uint32_t mask = tag->nslot - 1;
+    uint32_t i = l5_acpi_hash(sig, instance) & mask;
+    struct l5_acpi_ent *ent;
+
+    for (uint32_t n = 0; n < tag->nslot; ++n, i = (i + 1) & mask) {
+        ent = &tag->slot[i];
+        if (ent->sig == 0) {
+            break;
+        }
+        if (ent->sig == sig && ent->instance == instance) {
+            return ent;
+        }
+    }
+
+    return (void *)0;
+}
+
+/* Longest command line passed on, including the NUL */
+#define L5_CMDLINE_MAX      4096
+
+/* Value offset of an option given without a value */
+#define L5_CMDLINE_NOVAL    0xFFFF
+
+/*
+ * Command line option slot, unused slots have a
+ * zero `hash'.
+ *
+ * @hash: Key hash, see l5_cmdline_hash()
+ * @key: Offset of the key in the option strings
+ * @value: Offset of the value, or L5_CMDLINE_NOVAL
+ */
+struct l5_cmdline_ent {
+    uint32_t hash;
+    uint16_t key;
+    uint16_t value;
+};
+
+/*
+ * Kernel command line, as given and split into
+ * `key' or `key=value' options. The options are in
+ * an open addressed hash table, see l5_cmdline_find().
+ * Later options win over earlier ones with the same
+ * key.
+ *
+ * @nslot: Number of slots, a power of two
+ * @nent: Number of slots in use
+ * @raw: Offset of the raw command line from the tag
+ * @strings: Offset of the NUL separated option strings
+ */
+struct l5_tag_cmdline {
+    struct l5_tag tag;
+    uint32_t nslot;
+    uint32_t nent;
+    uint32_t raw;
+    uint32_t strings;
+    struct l5_cmdline_ent slot[];
+};
+
+/*
+ * Hash of a command line key (FNV-1a), never zero
+ *
+ * @key: Key
+ * @len: Length of the key
+ */
+static inline uint32_t
+l5_cmdline_hash(const char *key, uint32_t len)
+{
+    uint32_t h = 0x811C9DC5;
+
+    for (uint32_t i = 0; i < len; ++i) {
+        h = (h ^ (uint8_t)key[i]) * 0x01000193;
+    }
+
+    return h | 0x80000000;
+}
+
+/*
+ * Look up a command line option
+ *
+ * @tag: Command line tag
+ * @key: NUL terminated key
+ *
+ * Returns NULL if the option was not given
+ */
+static inline struct l5_cmdline_ent *
+l5_cmdline_find(struct l5_tag_cmdline *tag, const char *key)
+{
+    const char *strings = (const char *)tag + tag->strings;
+    const char *p;
+    uint32_t len = 0, mask = tag->nslot - 1;
+    uint32_t h, i;
+
+    while (key[len] != '\0') {
+        ++len;
+    }
+
+    h = l5_cmdline_hash(key, len);
+    i = h & mask;
+    for (uint32_t n = 0; n < tag->nslot; ++n, i = (i + 1) & mask) {
+        if (tag->slot[i].hash == 0) {
+            break;
+        }
+        if (tag->slot[i].hash != h) {
+            continue;
+        }
+
+        /* Same hash, make sure it is the same key */
+        p = strings + tag->slot[i].key;
+        for (len = 0; key[len] != '\0' && p[len] == key[len]; ++len);
+        if (key[len] == p[len]) {
+            return &tag->slot[i];
+        }
+    }
+
+    return (void *)0;
+}
+
+/*
+ * Loader log, oldest line first. Every line starts
+ * with its level as "<N>" (0 = error ... 3 = debug)
+ * and ends with a newline.
+ *
+ * @len: Bytes of text in `text'
+ * @dropped: Bytes lost to the ring wrapping
+ * @text: Log text, not NUL terminated
+ */
+struct l5_tag_log {
+    struct l5_tag tag;
+    uint32_t len;
+    uint32_t dropped;
+    char text[];
+};
+
+/*
+ * Get the first tag of the block
+ *
+ * @proto: Protocol header
+ */
+static inline struct l5_tag *
+l5_tag_first(struct l5_proto *proto)
+{
+    return (struct l5_tag *)((uint8_t *)proto + proto->hdr_size);
+}
+
+/*
+ * Get the tag after `tag', returns NULL once
+ * L5_TAG_END is reached.
+ *
+ * @tag: Current tag
+ */
+static inline struct l5_tag *
+l5_tag_next(struct l5_tag *tag)
+{
+    if (tag->type == L5_TAG_END || tag->size < sizeof(*tag)) {
+        return (void *)0;
+    }
+
+    tag = (struct l5_tag *)((uint8_t *)tag + tag->size);
+    return (tag->type == L5_TAG_END) ? (void *)0 : tag;
+}
+
+/*
+ * Find the first tag of a type
+ *
+ * @proto: Protocol header
+ * @type: Tag type (L5_TAG_*)
+ *
+ * Returns NULL if there is no such tag
+ */
+static inline struct l5_tag *
+l5_tag_find(struct l5_proto *proto, uint32_t type)
+{
+    struct l5_tag *tag = l5_tag_first(proto);
+
+    if (tag->type == L5_TAG_END) {
+        return (void *)0;
+    }
+
+    for (; tag != (void *)0; tag = l5_tag_next(tag)) {
+        if (tag->type == type) {
+            return tag;
+        }
+    }
+
+    return (void *)0;
+}
+
 #endif  /* !_LFIVE_PROTO_H_ */
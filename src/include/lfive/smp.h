@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _LFIVE_SMP_H_
+#define _LFIVE_SMP_H_ 1
+
+#include <stdint.h>
+#include <stddef.h>
+#include <lfive/proto.h>
+
+/*
+ * Find every enabled CPU through MP services, done
+ * once. Boot services must be up.
+ *
+ * Returns zero on success, on failure only the BSP
+ * is known.
+ */
+int smp_probe(void);
+
+/*
+ * Find the application processors and set aside a
+ * page for the AP trampoline, boot services must
+ * be up.
+ *
+ * @map: L5 memory map
+ * @nent: Number of entries in `map'
+ *
+ * Returns zero on success
+ */
+int smp_init(struct l5_mementry *map, size_t nent);
+
+/*
+ * Get the trampoline page set aside by smp_init(),
+ * this must be identity mapped in the kernel VAS.
+ */
+uintptr_t smp_tramp(void);
+
+/*
+ * Get the payload size of the L5_TAG_SMP tag, this
+ * includes slack for aligning the mailboxes.
+ */
+size_t smp_tag_size(void);
+
+/*
+ * Fill in an L5_TAG_SMP tag, this makes no
+ * firmware calls.
+ *
+ * @tag: Zeroed tag of smp_tag_size() bytes
+ */
+void smp_fill(struct l5_tag_smp *tag);
+
+/*
+ * Wake every AP and wait for it to park on its
+ * mailbox. Must be called after boot services are
+ * gone and with the final PAT loaded.
+ *
+ * @tag: Tag filled by smp_fill()
+ * @cr3: Physical address of the kernel PML4
+ *
+ * Returns the number of parked APs
+ */
+size_t smp_start(struct l5_tag_smp *tag, uintptr_t cr3);
+
+/*
+ * Get the payload size of the L5_TAG_TOPO tag
+ */
+size_t smp_topo_size(void);
+
+/*
+ * Fill in an L5_TAG_TOPO tag, this makes no
+ * firmware calls.
+ *
+ * @tag: Zeroed tag of smp_topo_size() bytes
+ */
+void smp_topo_fill(struct l5_tag_topo *tag);
+
+#endif  /* !_LFIVE_SMP_H_ */
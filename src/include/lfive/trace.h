@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _LFIVE_TRACE_H_
+#define _LFIVE_TRACE_H_ 1
+
+#include <stdint.h>
+
+/* Traced firmware calls */
+#define TRACE_ALLOC_PAGES   0x00
+#define TRACE_FREE_PAGES    0x01
+#define TRACE_GET_MEMMAP    0x02
+#define TRACE_ALLOC_POOL    0x03
+#define TRACE_FREE_POOL     0x04
+#define TRACE_HANDLE_PROTO  0x05
+#define TRACE_LOCATE_PROTO  0x06
+#define TRACE_STALL         0x07
+#define TRACE_FILE_OPEN     0x08
+#define TRACE_FILE_INFO     0x09
+#define TRACE_FILE_READ     0x0A
+#define TRACE_NCALLS        0x0B
+
+/*
+ * Start tracing boot services calls, g_bootsrv is
+ * pointed at a copy of the table that wraps the
+ * calls we care about. Boot services must be up.
+ *
+ * @mode: "on" to count calls, "stream" to also send
+ *        every call to the UART as it happens
+ *
+ * Returns zero on success
+ */
+int trace_init(const char *mode);
+
+/*
+ * Get a timestamp for trace_end(), zero if tracing
+ * is off so untraced boots only pay for a branch.
+ */
+uint64_t trace_begin(void);
+
+/*
+ * Account for a traced call
+ *
+ * @call: Call that was made (TRACE_*)
+ * @start: Timestamp from trace_begin()
+ * @bytes: Bytes moved or allocated by the call
+ */
+void trace_end(uint32_t call, uint64_t start, uint64_t bytes);
+
+/*
+ * Log the per-call counts, latencies and bytes
+ */
+void trace_stat(void);
+
+#endif  /* !_LFIVE_TRACE_H_ */
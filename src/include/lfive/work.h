@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _LFIVE_WORK_H_
+#define _LFIVE_WORK_H_ 1
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Smallest share of a job handed to one CPU */
+#define WORK_GRAIN 0x10000
+
+/*
+ * Work function, called with a share [start, end)
+ * of the job. This runs on the APs too, so it must
+ * not touch boot services or the console.
+ *
+ * @arg: Job argument
+ * @start: First index of the share
+ * @end: Index past the last one of the share
+ */
+typedef void(*work_fn_t)(void *arg, size_t start, size_t end);
+
+/*
+ * Find the APs to spread work over, falls back to
+ * the BSP alone if there are none.
+ */
+void work_init(void);
+
+/*
+ * Split a job of `n' items over every CPU and wait
+ * for it to finish, boot services must be up. The
+ * time taken is accounted to `phase'.
+ *
+ * @phase: Name of the phase, for work_stat()
+ * @fn: Work function
+ * @arg: Argument passed to `fn'
+ * @n: Number of items
+ * @grain: Smallest share worth handing out
+ */
+void work_run(const uint16_t *phase, work_fn_t fn, void *arg, size_t n,
+    size_t grain);
+
+/*
+ * memcpy() spread over every CPU
+ *
+ * @phase: Name of the phase, for work_stat()
+ * @dst: Destination
+ * @src: Source
+ * @n: Number of bytes
+ */
+void work_memcpy(const uint16_t *phase, void *dst, const void *src, size_t n);
+
+/*
+ * memset() spread over every CPU
+ *
+ * @phase: Name of the phase, for work_stat()
+ * @dst: Destination
+ * @c: Byte to fill with
+ * @n: Number of bytes
+ */
+void work_memset(const uint16_t *phase, void *dst, int c, size_t n);
+
+/*
+ * Zero a region, small ones with plain stores on the
+ * calling CPU and big ones with non-temporal stores
+ * spread over every CPU.
+ *
+ * @phase: Name of the phase, for work_stat()
+ * @dst: Region to zero
+ * @n: Number of bytes
+ */
+void work_zero(const uint16_t *phase, void *dst, size_t n);
+
+/*
+ * Print the time and speedup of each phase, and the
+ * throughput of the memory ones.
+ */
+void work_stat(void);
+
+#endif  /* !_LFIVE_WORK_H_ */
@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _MACHINE_CPU_H_
+#define _MACHINE_CPU_H_ 1
+
+#include <stdint.h>
+#include <stddef.h>
+#include <cdefs.h>
+#include <lfive/proto.h>
+
+/* GDT selectors the kernel is entered with */
+#define GDT_KCODE   0x08
+#define GDT_KDATA   0x10
+
+/* XCR0 state components */
+#define XCR0_X87        BIT(0)
+#define XCR0_SSE        BIT(1)
+#define XCR0_AVX        BIT(2)
+#define XCR0_AVX512     (BIT(5) | BIT(6) | BIT(7))
+
+/*
+ * GDT register
+ *
+ * @limit: Size of the GDT minus one
+ * @base: Base address of the GDT
+ */
+struct __attribute__((packed)) gdtr {
+    uint16_t limit;
+    uint64_t base;
+};
+
+/*
+ * Everything needed to enter the kernel, this is filled
+ * in while boot services are still up so that what is
+ * left after the exit is a short fixed sequence.
+ *
+ * @cr3: Page tables to enter with
+ * @stack: Top of the kernel stack
+ * @entry: Kernel entry point
+ * @arg: Argument passed to the entry point
+ * @gdtr: GDT to enter with
+ */
+struct cpu_handoff {
+    uint64_t cr3;
+    uint64_t stack;
+    uint64_t entry;
+    uint64_t arg;
+    struct gdtr gdtr;
+};
+
+/*
+ * CPU state set up by cpu_enable()
+ *
+ * @features: Enabled features (L5_CPUF_*)
+ * @xcr0: XCR0, zero without L5_CPUF_XSAVE
+ * @cr0: CR0
+ * @cr4: CR4
+ */
+struct cpu_state {
+    uint32_t features;
+    uint64_t xcr0;
+    uint64_t cr0;
+    uint64_t cr4;
+};
+
+/*
+ * Read the timestamp counter
+ */
+static inline uint64_t
+rdtsc(void)
+{
+    uint32_t lo, hi;
+
+    __ASMV(
+        "rdtsc"
+        : "=a" (lo), "=d" (hi)
+    );
+
+    return ((uint64_t)hi << 32) | lo;
+}
+
+/*
+ * Execute CPUID
+ *
+ * @leaf: Leaf to query (EAX)
+ * @subleaf: Subleaf to query (ECX)
+ * @regs: EAX, EBX, ECX and EDX are written here
+ */
+static inline void
+cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4])
+{
+    __ASMV(
+        "cpuid"
+        : "=a" (regs[0]), "=b" (regs[1]), "=c" (regs[2]), "=d" (regs[3])
+        : "a" (leaf), "c" (subleaf)
+    );
+}
+
+/*
+ * Read an extended control register, only valid
+ * if CPUID reports OSXSAVE.
+ *
+ * @xcr: XCR to read
+ */
+static inline uint64_t
+xgetbv(uint32_t xcr)
+{
+    uint32_t lo, hi;
+
+    __ASMV(
+        "xgetbv"
+        : "=a" (lo), "=d" (hi)
+        : "c" (xcr)
+    );
+
+    return ((uint64_t)hi << 32) | lo;
+}
+
+/*
+ * Read a model specific register
+ *
+ * @msr: MSR to read
+ */
+static inline uint64_t
+rdmsr(uint32_t msr)
+{
+    uint32_t lo, hi;
+
+    __ASMV(
+        "rdmsr"
+        : "=a" (lo), "=d" (hi)
+        : "c" (msr)
+        : "memory"
+    );
+
+    return ((uint64_t)hi << 32) | lo;
+}
+
+/*
+ * Write a model specific register
+ *
+ * @msr: MSR to write
+ * @v: Value to write
+ */
+static inline void
+wrmsr(uint32_t msr, uint64_t v)
+{
+    __ASMV(
+        "wrmsr"
+        :
+        : "c" (msr),
+          "a" ((uint32_t)v),
+          "d" ((uint32_t)(v >> 32))
+        : "memory"
+    );
+}
+
+/*
+ * Read CR3
+ */
+static inline uint64_t
+rdcr3(void)
+{
+    uint64_t cr3;
+
+    __ASMV(
+        "mov %%cr3, %0"
+        : "=r" (cr3)
+        :
+        : "memory"
+    );
+
+    return cr3;
+}
+
+/*
+ * Write CR3, this switches address spaces
+ *
+ * @cr3: Value to write
+ */
+static inline void
+wrcr3(uint64_t cr3)
+{
+    __ASMV(
+        "mov %0, %%cr3"
+        :
+        : "r" (cr3)
+        : "memory"
+    );
+}
+
+/*
+ * Invalidate a page in the TLB
+ *
+ * @va: Any address within the page
+ */
+static inline void
+invlpg(uintptr_t va)
+{
+    __ASMV(
+        "invlpg (%0)"
+        :
+        : "r" (va)
+        : "memory"
+    );
+}
+
+/*
+ * Get the features cpu_enable() would turn on
+ *
+ * Returns a mask of L5_CPUF_*
+ */
+uint32_t cpu_features(void);
+
+/*
+ * Turn on every supported feature, call this once
+ * boot services are gone.
+ *
+ * @res: What was turned on is written here
+ */
+void cpu_enable(struct cpu_state *res);
+
+/*
+ * Get the TSC frequency from CPUID
+ *
+ * @method: How it was found is written here (L5_TSC_*)
+ *
+ * Returns zero if CPUID does not tell
+ */
+uint64_t cpu_tsc_freq(uint32_t *method);
+
+/*
+ * Check if the TSC runs at a constant rate in
+ * every P-state and C-state.
+ */
+int cpu_tsc_invariant(void);
+
+/*
+ * Get the APIC ID of the calling CPU, the x2APIC ID
+ * if the CPU has one.
+ */
+uint32_t cpu_apic_id(void);
+
+/*
+ * Describe the caches of the calling CPU
+ *
+ * @buf: Caches are written here
+ * @max: Max number of entries `buf' can take
+ *
+ * Returns the number of entries written
+ */
+size_t cpu_caches(struct l5_cache *buf, size_t max);
+
+/*
+ * Prepare a handoff to the kernel
+ *
+ * @hp: Handoff to prepare
+ * @cr3: Physical address of the PML4
+ * @stack: Top of the kernel stack
+ * @entry: Kernel entry point
+ * @arg: Argument passed to the entry point
+ *
+ * Returns zero on success
+ */
+int cpu_handoff_init(struct cpu_handoff *hp, uint64_t cr3, uintptr_t stack,
+    uintptr_t entry, void *arg);
+
+/*
+ * Enter the kernel, this loads the GDT, switches
+ * stacks, loads CR3 and jumps to the entry point
+ * with `arg' as its first argument. Must run from
+ * identity mapped memory.
+ *
+ * @hp: Handoff from cpu_handoff_init()
+ */
+__attribute__((noreturn)) void cpu_handoff(struct cpu_handoff *hp);
+
+#endif  /* !_MACHINE_CPU_H_ */
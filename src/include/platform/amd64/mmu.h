@@ -32,9 +32,19 @@
 
 #include <efi.h>
 #include <cdefs.h>
+#include <lfive/proto.h>
 
 #define PROT_READ   BIT(0)
 #define PROT_WRITE  BIT(1)
+#define PROT_EXEC   BIT(2)
+
+/*
+ * Memory type for mmu_map(), write-back is used if
+ * none of these are given.
+ */
+#define PROT_WC     BIT(4)      /* Write-combining */
+#define PROT_WT     BIT(5)      /* Write-through */
+#define PROT_UC     BIT(6)      /* Uncacheable */
 
 /* Huge values for mmu_map() */
 #define MAP_SMALL_4K  0x0000
@@ -66,6 +76,13 @@ int mmu_get_vas(struct mmu_vas *res_p);
  */
 int mmu_set_vas(struct mmu_vas *vas);
 
+/*
+ * Program the page attribute table with the layout
+ * our page tables expect, this must be done before
+ * they are loaded.
+ */
+void mmu_init_pat(void);
+
 /*
  * Initialize a virtual address space
  *
@@ -79,6 +96,24 @@ int mmu_set_vas(struct mmu_vas *vas);
  */
 int mmu_map(struct mmu_vas *vas, vaddr_t va, paddr_t pa, int prot, int size);
 
+/*
+ * Map physical memory [0, len) at `va' using the
+ * largest pages that keep the preferred memory type
+ * of each region in the memory map. Pages that are
+ * already mapped keep their mapping.
+ *
+ * @vas: VAS to map into
+ * @va: Virtual base (1 GiB aligned)
+ * @len: Length to map (2 MiB aligned)
+ * @prot: Protection flags, the memory type is added
+ * @map: Memory map to take memory types from
+ * @nent: Number of entries in `map'
+ *
+ * Returns zero on success
+ */
+int mmu_map_direct(struct mmu_vas *vas, vaddr_t va, size_t len, int prot,
+    struct l5_mementry *map, size_t nent);
+
 /*
  * Initialize a page to be used as a PML4
  *
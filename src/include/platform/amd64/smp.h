@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _MACHINE_SMP_H_
+#define _MACHINE_SMP_H_ 1
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* The AP trampoline must sit in a page below this */
+#define AP_TRAMP_LIMIT  0x100000
+
+/*
+ * Copy the AP trampoline to a low page and point it
+ * at the kernel page tables and the mailboxes. The
+ * control registers, EFER, PAT and XCR0 are taken
+ * from the calling CPU.
+ *
+ * @page: Physical base of the page, below AP_TRAMP_LIMIT
+ * @cr3: Physical address of the PML4, below 4 GiB
+ * @mbox: Physical base of the mailboxes
+ * @nmbox: Number of mailboxes
+ *
+ * Returns zero on success
+ */
+int ap_tramp_install(uintptr_t page, uintptr_t cr3, uintptr_t mbox,
+    size_t nmbox);
+
+/*
+ * Wake every other CPU with a single broadcast
+ * INIT-SIPI-SIPI into the trampoline.
+ *
+ * @page: Page the trampoline was installed at
+ * @tsc_per_us: TSC ticks per microsecond, for the delays
+ */
+void ap_start_all(uintptr_t page, uint64_t tsc_per_us);
+
+#endif  /* !_MACHINE_SMP_H_ */
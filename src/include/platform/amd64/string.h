@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _MACHINE_STRING_H_
+#define _MACHINE_STRING_H_ 1
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Copy and fill variants, see string_init() */
+#define STRING_SSE2     0   /* Baseline, every x86-64 CPU has it */
+#define STRING_AVX2     1   /* 32 byte loops */
+#define STRING_ERMS     2   /* rep movsb / rep stosb */
+#define STRING_NVARIANT 3
+
+/* Anything up to this is done inline without a loop */
+#define STRING_SMALL    64
+
+/* Non-temporal fills without a last level cache size */
+#define STRING_NT_DEFAULT   (8 * 1024 * 1024)
+
+/*
+ * A set of copy and fill loops, these are only
+ * called with more than STRING_SMALL bytes.
+ *
+ * @name: Name for the logs
+ * @copy: Forward copy, the buffers must not overlap
+ * @fill: Fill with a byte repeated in `pat'
+ * @fill_nt: Fill that bypasses the caches
+ */
+struct string_variant {
+    const char *name;
+    void (*copy)(uint8_t *dst, const uint8_t *src, size_t n);
+    void (*fill)(uint8_t *dst, uint64_t pat, size_t n);
+    void (*fill_nt)(uint8_t *dst, uint64_t pat, size_t n);
+};
+
+extern const struct string_variant string_variants[STRING_NVARIANT];
+
+/*
+ * memset() that always bypasses the caches, for
+ * memory nobody is going to touch again soon.
+ *
+ * @s: Memory to fill
+ * @c: Byte to fill with
+ * @n: Number of bytes
+ */
+void *memset_nt(void *s, int c, size_t n);
+
+/*
+ * Pick the fastest variant the CPU can run and the
+ * size non-temporal fills start at. Until this is
+ * called memcpy() and friends use STRING_SSE2.
+ *
+ * Returns the variant picked (STRING_*)
+ */
+int string_init(void);
+
+/*
+ * Check if the calling CPU can run a variant, a CPU
+ * might have AVX2 without the OS turning it on.
+ *
+ * @variant: Variant to check (STRING_*)
+ *
+ * Returns 1 if it can
+ */
+int string_usable(int variant);
+
+/*
+ * Use a variant from now on, this is for benchmarks,
+ * everyone else wants string_init().
+ *
+ * @variant: Variant to use (STRING_*)
+ * @nt_min: Fills from this size on are non-temporal
+ *
+ * Returns zero on success
+ */
+int string_select(int variant, size_t nt_min);
+
+/*
+ * Get the variant in use
+ *
+ * @nt_min: Non-temporal fill threshold is written here
+ *          if not NULL
+ *
+ * Returns the variant (STRING_*)
+ */
+int string_current(size_t *nt_min);
+
+#endif  /* !_MACHINE_STRING_H_ */
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _MACHINE_UART_H_
+#define _MACHINE_UART_H_ 1
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Baud rate used when none is given */
+#define UART_BAUD_DEFAULT   115200
+
+/*
+ * Set up a 16550 compatible UART for output, 8N1
+ * with the FIFO on if there is one. This makes no
+ * firmware calls and works past the exit.
+ *
+ * @port: "com1" to "com4", or an I/O port number
+ * @baud: Baud rate, zero for UART_BAUD_DEFAULT
+ *
+ * Returns zero on success, -1 if there is no UART
+ */
+int uart_init(const char *port, uint32_t baud);
+
+/*
+ * Write a string to the UART, filling the FIFO
+ * each time it runs dry.
+ *
+ * @s: NUL terminated UCS-2 string
+ */
+void uart_puts(const uint16_t *s);
+
+/*
+ * Write raw bytes to the UART
+ *
+ * @s: Bytes to write
+ * @len: Number of bytes
+ */
+void uart_write(const char *s, size_t len);
+
+/*
+ * Returns non-zero if the UART is set up
+ */
+int uart_active(void);
+
+#endif  /* !_MACHINE_UART_H_ */
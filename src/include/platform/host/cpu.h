@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _HOST_CPU_H_
+#define _HOST_CPU_H_ 1
+
+/*
+ * The host build runs the loader as a user process,
+ * so everything but the privileged helpers is taken
+ * from amd64. Those are renamed out of the way and
+ * replaced with ones backed by an emulated register
+ * file, see platform/host/cpu.c.
+ */
+#define rdmsr   __amd64_rdmsr
+#define wrmsr   __amd64_wrmsr
+#define rdcr3   __amd64_rdcr3
+#define wrcr3   __amd64_wrcr3
+#define invlpg  __amd64_invlpg
+#include <platform/amd64/cpu.h>
+#undef rdmsr
+#undef wrmsr
+#undef rdcr3
+#undef wrcr3
+#undef invlpg
+
+/*
+ * Read an emulated model specific register, ones
+ * never written read as zero.
+ *
+ * @msr: MSR to read
+ */
+uint64_t rdmsr(uint32_t msr);
+
+/*
+ * Write an emulated model specific register
+ *
+ * @msr: MSR to write
+ * @v: Value to write
+ */
+void wrmsr(uint32_t msr, uint64_t v);
+
+/*
+ * Read the emulated CR3
+ */
+uint64_t rdcr3(void);
+
+/*
+ * Write the emulated CR3, nothing is switched
+ *
+ * @cr3: Value to write
+ */
+void wrcr3(uint64_t cr3);
+
+/*
+ * Count a TLB invalidation
+ *
+ * @va: Any address within the page
+ */
+void invlpg(uintptr_t va);
+
+/*
+ * What the loader did to the emulated CPU
+ *
+ * @pat: IA32_PAT as last written
+ * @cr3: CR3 as last written
+ * @ninvlpg: Number of invlpg() calls
+ */
+struct host_cpu_stat {
+    uint64_t pat;
+    uint64_t cr3;
+    size_t ninvlpg;
+};
+
+/*
+ * Get the emulated CPU state
+ *
+ * @res: State is written here
+ */
+void host_cpu_stat(struct host_cpu_stat *res);
+
+#endif  /* !_HOST_CPU_H_ */
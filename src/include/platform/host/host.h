@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _HOST_HOST_H_
+#define _HOST_HOST_H_ 1
+
+#include <efi.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/* Physical memory starts here, the first MiB is a hole */
+#define HOST_RAM_BASE       0x100000
+
+/* The framebuffer sits here, outside of the memory map */
+#define HOST_FB_BASE        0xC0000000
+
+/* Default size of physical memory */
+#define HOST_RAM_DEFAULT    (512ULL << 20)
+
+/*
+ * Firmware the loader is run against
+ *
+ * @root: Host directory standing in for the boot volume
+ * @ram_size: Bytes of physical memory
+ * @desc_size: Memory descriptor size to report
+ * @churn: Number of exit_boot_services() calls to fail
+ *         with a stale map key
+ * @fb_width: Native GOP mode width, zero for no GOP
+ * @fb_height: Native GOP mode height
+ */
+struct host_fw {
+    const char *root;
+    uint64_t ram_size;
+    uintn_t desc_size;
+    uint32_t churn;
+    uint32_t fb_width;
+    uint32_t fb_height;
+};
+
+/*
+ * Bring up the mock firmware, this maps the host
+ * memory standing in for physical memory.
+ *
+ * @fw: Firmware to emulate
+ * @image: Loader image handle is written here
+ *
+ * Returns the system table, NULL on failure
+ */
+EFI_SYSTEM_TABLE *host_efi_init(const struct host_fw *fw,
+    efi_handle_t *image);
+
+/*
+ * Print what the loader asked of the firmware
+ */
+void host_efi_stat(void);
+
+struct cpu_handoff;
+
+/*
+ * Take over from cpu_handoff(), the kernel is never
+ * run. What the loader built is checked and the run
+ * ends.
+ *
+ * @hp: Handoff the kernel would be entered with
+ */
+__attribute__((noreturn)) void host_handoff(struct cpu_handoff *hp);
+
+#endif  /* !_HOST_HOST_H_ */
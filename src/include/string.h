@@ -31,7 +31,13 @@
 #define _STRING_H_ 1
 
 #include <stdint.h>
+#include <stddef.h>
 
 int memcmp(const void *s1, const void *s2, size_t n);
+void *memcpy(void *dest, const void *src, size_t n);
+void *memmove(void *dest, const void *src, size_t n);
+void *memset(void *s, int c, size_t n);
+size_t strlen(const char *s);
+int strcmp(const char *s1, const char *s2);
 
 #endif  /* !_STRING_H_ */
@@ -29,17 +29,64 @@
 
 #include <string.h>
 
+/*
+ * memcpy(), memmove() and memset() pick a variant
+ * for the CPU at runtime and live with the platform
+ * code, see <machine/string.h>.
+ */
+
+typedef uint64_t __attribute__((may_alias, aligned(1))) word_t;
+
 int
 memcmp(const void *s1, const void *s2, size_t n)
 {
-    if (n != 0) {
-        const unsigned char *p1 = s1, *p2 = s2;
-
-        do {
-            if (*p1++ != *p2++) {
-                return (*--p1 - *--p2);
-            }
-        } while (--n != 0);
+    const unsigned char *p1 = s1, *p2 = s2;
+    uint64_t w1, w2;
+
+    /* A word at a time until one differs */
+    while (n >= sizeof(word_t)) {
+        w1 = *(const word_t *)p1;
+        w2 = *(const word_t *)p2;
+        if (w1 != w2) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            /* The first byte in memory has to be the most significant */
+            w1 = __builtin_bswap64(w1);
+            w2 = __builtin_bswap64(w2);
+#endif
+            return (w1 < w2) ? -1 : 1;
+        }
+
+        p1 += sizeof(word_t);
+        p2 += sizeof(word_t);
+        n -= sizeof(word_t);
+    }
+
+    while (n-- != 0) {
+        if (*p1++ != *p2++) {
+            return (*--p1 - *--p2);
+        }
     }
     return 0;
 }
+
+size_t
+strlen(const char *s)
+{
+    const char *p = s;
+
+    while (*p != '\0') {
+        ++p;
+    }
+    return p - s;
+}
+
+int
+strcmp(const char *s1, const char *s2)
+{
+    while (*s1 == *s2++) {
+        if (*s1++ == '\0') {
+            return 0;
+        }
+    }
+    return (*(const unsigned char *)s1 - *(const unsigned char *)(s2 - 1));
+}
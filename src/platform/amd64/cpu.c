@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <machine/cpu.h>
+#include <cdefs.h>
+
+/* Control register bits */
+#define CR0_MP          BIT(1)      /* Monitor coprocessor */
+#define CR0_EM          BIT(2)      /* x87 emulation */
+#define CR0_TS          BIT(3)      /* Task switched */
+#define CR0_NE          BIT(5)      /* Native x87 errors */
+#define CR4_PGE         BIT(7)      /* Global pages */
+#define CR4_OSFXSR      BIT(9)      /* FXSAVE and SSE */
+#define CR4_OSXMMEXCPT  BIT(10)     /* SSE exceptions */
+#define CR4_PCIDE       BIT(17)     /* Process context IDs */
+#define CR4_OSXSAVE     BIT(18)     /* XSAVE and XCR0 */
+#define CR4_SMEP        BIT(20)     /* Supervisor execute prevention */
+#define CR4_SMAP        BIT(21)     /* Supervisor access prevention */
+
+#define IA32_EFER       0xC0000080
+#define EFER_NXE        BIT(11)
+
+/*
+ * The kernel is entered on this GDT until it brings
+ * up its own, it lives in the loader image which is
+ * never given back. The accessed bits are preset so
+ * the CPU never writes to it, it may be mapped read
+ * only.
+ */
+static uint64_t gdt[] __attribute__((aligned(16))) = {
+    0x0000000000000000,     /* Null */
+    0x00AF9B000000FFFF,     /* Kernel code (64-bit) */
+    0x00CF93000000FFFF      /* Kernel data */
+};
+
+void
+cpu_enable(struct cpu_state *res)
+{
+    uint32_t feat = cpu_features();
+    uint64_t cr0, cr3, cr4, xcr0 = 0;
+
+    __ASMV("mov %%cr0, %0" : "=r" (cr0));
+    __ASMV("mov %%cr4, %0" : "=r" (cr4));
+
+    /* x87 and SSE run natively */
+    cr0 &= ~(CR0_EM | CR0_TS);
+    cr0 |= CR0_MP | CR0_NE;
+
+    if (ISSET(feat, L5_CPUF_SSE))
+        cr4 |= CR4_OSFXSR | CR4_OSXMMEXCPT;
+    if (ISSET(feat, L5_CPUF_XSAVE))
+        cr4 |= CR4_OSXSAVE;
+    if (ISSET(feat, L5_CPUF_PGE))
+        cr4 |= CR4_PGE;
+    if (ISSET(feat, L5_CPUF_SMEP))
+        cr4 |= CR4_SMEP;
+    if (ISSET(feat, L5_CPUF_SMAP))
+        cr4 |= CR4_SMAP;
+
+    __ASMV("mov %0, %%cr0" :: "r" (cr0) : "memory");
+    __ASMV("mov %0, %%cr4" :: "r" (cr4) : "memory");
+
+    /* PCIDE needs PCID zero in CR3 */
+    if (ISSET(feat, L5_CPUF_PCID)) {
+        cr3 = rdcr3();
+        if (ISSET(cr3, 0xFFF)) {
+            feat &= ~L5_CPUF_PCID;
+        } else {
+            cr4 |= CR4_PCIDE;
+            __ASMV("mov %0, %%cr4" :: "r" (cr4) : "memory");
+        }
+    }
+
+    if (ISSET(feat, L5_CPUF_XSAVE)) {
+        xcr0 = XCR0_X87 | XCR0_SSE;
+        if (ISSET(feat, L5_CPUF_AVX))
+            xcr0 |= XCR0_AVX;
+        if (ISSET(feat, L5_CPUF_AVX512))
+            xcr0 |= XCR0_AVX512;
+
+        __ASMV(
+            "xsetbv"
+            :
+            : "c" (0),
+              "a" ((uint32_t)xcr0),
+              "d" ((uint32_t)(xcr0 >> 32))
+            : "memory"
+        );
+    }
+
+    if (ISSET(feat, L5_CPUF_NX)) {
+        wrmsr(IA32_EFER, rdmsr(IA32_EFER) | EFER_NXE);
+    }
+
+    res->features = feat;
+    res->xcr0 = xcr0;
+    res->cr0 = cr0;
+    res->cr4 = cr4;
+}
+
+int
+cpu_handoff_init(struct cpu_handoff *hp, uint64_t cr3, uintptr_t stack,
+    uintptr_t entry, void *arg)
+{
+    if (hp == NULL || cr3 == 0 || stack == 0) {
+        return -1;
+    }
+
+    hp->cr3 = cr3;
+    hp->entry = entry;
+    hp->arg = (uint64_t)arg;
+    hp->gdtr.limit = sizeof(gdt) - 1;
+    hp->gdtr.base = (uint64_t)gdt;
+
+    /*
+     * Enter as if called, keep the stack 16 byte
+     * aligned before the return address is pushed.
+     */
+    hp->stack = ALIGN_DOWN(stack, 16);
+    return 0;
+}
+
+void
+cpu_handoff(struct cpu_handoff *hp)
+{
+    __ASMV(
+        "cli\n\t"
+        "lgdt (%0)\n\t"
+
+        /* Reload CS with a far return */
+        "pushq %5\n\t"
+        "leaq 1f(%%rip), %%rax\n\t"
+        "pushq %%rax\n\t"
+        "lretq\n\t"
+        "1:\n\t"
+        "movw %6, %%ax\n\t"
+        "movw %%ax, %%ds\n\t"
+        "movw %%ax, %%es\n\t"
+        "movw %%ax, %%ss\n\t"
+        "movw %%ax, %%fs\n\t"
+        "movw %%ax, %%gs\n\t"
+
+        /* Kernel stack is identity mapped on both sides */
+        "movq %2, %%rsp\n\t"
+        "movq %1, %%cr3\n\t"
+        "pushq $0\n\t"
+        "jmp *%3"
+        :
+        : "r" (&hp->gdtr),
+          "r" (hp->cr3),
+          "r" (hp->stack),
+          "r" (hp->entry),
+          "D" (hp->arg),
+          "i" (GDT_KCODE),
+          "i" (GDT_KDATA)
+        : "rax", "memory"
+    );
+
+    __builtin_unreachable();
+}
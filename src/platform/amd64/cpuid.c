@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <machine/cpu.h>
+#include <cdefs.h>
+
+/*
+ * Read a CPUID cache leaf, the Intel and AMD leaves
+ * share one layout.
+ *
+ * @leaf: Cache leaf
+ * @subleaf: Cache index
+ * @res: Cache is written here
+ *
+ * Returns -1 once there are no more caches
+ */
+static int
+cpu_cache_leaf(uint32_t leaf, uint32_t subleaf, struct l5_cache *res)
+{
+    uint32_t regs[4];
+    uint32_t nshare, shift = 0;
+
+    cpuid(leaf, subleaf, regs);
+    res->type = regs[0] & 0x1F;
+    if (res->type == 0) {
+        return -1;
+    }
+
+    res->level = (regs[0] >> 5) & 0x7;
+    res->line_size = (regs[1] & 0xFFF) + 1;
+    res->ways = ((regs[1] >> 22) & 0x3FF) + 1;
+    res->size = res->ways * res->line_size *
+        (((regs[1] >> 12) & 0x3FF) + 1) * (regs[2] + 1);
+
+    /* Sharing CPUs differ only in the low APIC ID bits */
+    nshare = ((regs[0] >> 14) & 0xFFF) + 1;
+    while ((1U << shift) < nshare) {
+        ++shift;
+    }
+
+    res->share_mask = ~0U << shift;
+    return 0;
+}
+
+uint32_t
+cpu_features(void)
+{
+    uint32_t regs[4];
+    uint32_t max, feat = 0;
+    uint64_t xcr0_ok;
+
+    cpuid(0, 0, regs);
+    max = regs[0];
+
+    cpuid(1, 0, regs);
+    if (ISSET(regs[3], BIT(25)) && ISSET(regs[3], BIT(26)))
+        feat |= L5_CPUF_SSE;
+    if (ISSET(regs[3], BIT(13)))
+        feat |= L5_CPUF_PGE;
+    if (ISSET(regs[2], BIT(17)))
+        feat |= L5_CPUF_PCID;
+    if (ISSET(regs[2], BIT(26)) && max >= 0xD) {
+        feat |= L5_CPUF_XSAVE;
+
+        /* AVX needs its state supported by XSAVE too */
+        cpuid(0xD, 0, regs);
+        xcr0_ok = regs[0];
+        cpuid(1, 0, regs);
+        if (ISSET(regs[2], BIT(28)) && ISSET(xcr0_ok, XCR0_AVX))
+            feat |= L5_CPUF_AVX;
+        if (max >= 7) {
+            cpuid(7, 0, regs);
+            if (ISSET(regs[1], BIT(16)) &&
+                (xcr0_ok & XCR0_AVX512) == XCR0_AVX512 &&
+                ISSET(feat, L5_CPUF_AVX))
+                feat |= L5_CPUF_AVX512;
+        }
+    }
+
+    if (max >= 7) {
+        cpuid(7, 0, regs);
+        if (ISSET(regs[1], BIT(7)))
+            feat |= L5_CPUF_SMEP;
+        if (ISSET(regs[1], BIT(20)))
+            feat |= L5_CPUF_SMAP;
+    }
+
+    cpuid(0x80000000, 0, regs);
+    if (regs[0] >= 0x80000001) {
+        cpuid(0x80000001, 0, regs);
+        if (ISSET(regs[3], BIT(20)))
+            feat |= L5_CPUF_NX;
+    }
+
+    return feat;
+}
+
+uint64_t
+cpu_tsc_freq(uint32_t *method)
+{
+    uint32_t regs[4];
+    uint32_t max, denom, numer;
+
+    /* Hypervisors may hand it over in kHz */
+    cpuid(1, 0, regs);
+    if (ISSET(regs[2], BIT(31))) {
+        cpuid(0x40000000, 0, regs);
+        if (regs[0] >= 0x40000010) {
+            cpuid(0x40000010, 0, regs);
+            if (regs[0] != 0) {
+                *method = L5_TSC_HYPERVISOR;
+                return (uint64_t)regs[0] * 1000;
+            }
+        }
+    }
+
+    cpuid(0, 0, regs);
+    max = regs[0];
+    if (max < 0x15) {
+        return 0;
+    }
+
+    /* TSC / crystal ratio */
+    cpuid(0x15, 0, regs);
+    denom = regs[0];
+    numer = regs[1];
+    if (denom == 0 || numer == 0) {
+        return 0;
+    }
+
+    if (regs[2] != 0) {
+        *method = L5_TSC_CPUID15;
+        return (uint64_t)regs[2] * numer / denom;
+    }
+
+    /*
+     * No crystal frequency, on these parts the TSC
+     * runs at the base frequency.
+     */
+    if (max < 0x16) {
+        return 0;
+    }
+
+    cpuid(0x16, 0, regs);
+    if ((regs[0] & 0xFFFF) == 0) {
+        return 0;
+    }
+
+    *method = L5_TSC_CPUID16;
+    return (uint64_t)(regs[0] & 0xFFFF) * 1000000;
+}
+
+int
+cpu_tsc_invariant(void)
+{
+    uint32_t regs[4];
+
+    cpuid(0x80000000, 0, regs);
+    if (regs[0] < 0x80000007) {
+        return 0;
+    }
+
+    cpuid(0x80000007, 0, regs);
+    return ISSET(regs[3], BIT(8)) != 0;
+}
+
+uint32_t
+cpu_apic_id(void)
+{
+    uint32_t regs[4];
+
+    cpuid(0, 0, regs);
+    if (regs[0] >= 0xB) {
+        cpuid(0xB, 0, regs);
+        if (regs[1] != 0) {
+            return regs[3];
+        }
+    }
+
+    cpuid(1, 0, regs);
+    return regs[1] >> 24;
+}
+
+size_t
+cpu_caches(struct l5_cache *buf, size_t max)
+{
+    uint32_t regs[4];
+    uint32_t leaf = 0;
+    size_t n = 0;
+
+    /* Intel has leaf 4, AMD has 0x8000001D with topology extensions */
+    cpuid(0, 0, regs);
+    if (regs[0] >= 4) {
+        cpuid(4, 0, regs);
+        if ((regs[0] & 0x1F) != 0) {
+            leaf = 4;
+        }
+    }
+
+    if (leaf == 0) {
+        cpuid(0x80000000, 0, regs);
+        if (regs[0] >= 0x8000001D) {
+            cpuid(0x80000001, 0, regs);
+            leaf = ISSET(regs[2], BIT(22)) ? 0x8000001D : 0;
+        }
+    }
+
+    if (leaf == 0) {
+        return 0;
+    }
+
+    while (n < max && cpu_cache_leaf(leaf, n, &buf[n]) == 0) {
+        ++n;
+    }
+
+    return n;
+}
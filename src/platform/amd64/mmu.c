@@ -28,6 +28,7 @@
  */
 
 #include <machine/mmu.h>
+#include <machine/cpu.h>
 #include <lfive/mem.h>
 #include <cdefs.h>
 #include <efi.h>
@@ -36,12 +37,38 @@
 #define PTE_ADDR_MASK   0x000FFFFFFFFFF000
 #define PTE_P           BIT(0)        /* Present */
 #define PTE_RW          BIT(1)        /* Writable */
+#define PTE_PWT         BIT(3)        /* Page-level write-through */
+#define PTE_PCD         BIT(4)        /* Page-level cache disable */
 #define PTE_PS          BIT(7)        /* Page size */
+#define PTE_G           BIT(8)        /* Global */
+#define PTE_PAT         BIT(7)        /* PAT index bit (4K pages) */
+#define PTE_PAT_LG      BIT(12)       /* PAT index bit (huge pages) */
 #define PTE_NX          BIT(63)       /* Execute-disable */
 
 /* Default page size */
 #define PAGE_SIZE 4096
 
+/*
+ * Page attribute table layout, index 1 is turned into
+ * write-combining and index 7 into write-through so
+ * that every memory type is reachable.
+ *
+ * [0]: WB, [1]: WC, [2]: UC-, [3]: UC
+ * [4]: WB, [5]: WP, [6]: UC-, [7]: WT
+ */
+#define IA32_PAT        0x277
+#define PAT_LAYOUT      0x0407050600070106ULL
+
+/*
+ * Mappings from here up belong to the kernel half and
+ * are made global, they stay the same in every VAS.
+ */
+#define KERNEL_HALF     0xFFFF800000000000
+
+/* Features cpu_enable() turns on before the handoff */
+static int nx_enabled = -1;
+static int pge_enabled = -1;
+
 typedef enum {
     PMAP_OFFSET,
     PMAP_TBL,
@@ -53,20 +80,56 @@ typedef enum {
 /*
  * Convert MI protection flags to MD
  * page table flags
+ *
+ * @prot: Protection flags
+ * @size: Mapping size (MAP_*)
  */
-static uint32_t
-prot_to_pte(uint32_t prot)
+static uint64_t
+prot_to_pte(uint32_t prot, int size)
 {
-    uint32_t pte_flags = 0;
+    uint64_t pte_flags = 0;
+    uint64_t pat;
 
     if (ISSET(prot, PROT_READ))
         pte_flags |= PTE_P;
     if (ISSET(prot, PROT_WRITE))
         pte_flags |= PTE_RW;
+    if (!ISSET(prot, PROT_EXEC) && nx_enabled > 0)
+        pte_flags |= PTE_NX;
+
+    /* The PAT bit moves for huge pages */
+    pat = (size == MAP_SMALL_4K) ? PTE_PAT : PTE_PAT_LG;
+
+    /* See PAT_LAYOUT for the indices */
+    if (ISSET(prot, PROT_UC))
+        pte_flags |= PTE_PCD | PTE_PWT;
+    else if (ISSET(prot, PROT_WT))
+        pte_flags |= pat | PTE_PCD | PTE_PWT;
+    else if (ISSET(prot, PROT_WC))
+        pte_flags |= PTE_PWT;
 
     return pte_flags;
 }
 
+/*
+ * Convert a preferred L5 memory type to
+ * MI protection flags.
+ */
+static int
+cache_to_prot(uint8_t cache)
+{
+    switch (cache) {
+    case L5_CACHE_WT:
+        return PROT_WT;
+    case L5_CACHE_WC:
+        return PROT_WC;
+    case L5_CACHE_UC:
+        return PROT_UC;
+    }
+
+    return 0;
+}
+
 /*
  * Invalidate a page in the TLB. We use this to prevent
  * stale entries when remapping or changing attributes
@@ -80,12 +143,7 @@ __invlpg(void *ptr)
     uintptr_t v = (uintptr_t)ptr;
 
     v = ALIGN_UP(v, PAGE_SIZE);
-    __ASMV(
-        "invlpg (%0)"
-        :
-        : "r" (v)
-        : "memory"
-    );
+    invlpg(v);
 }
 
 /*
@@ -128,8 +186,7 @@ mmu_level_index(vaddr_t va, pmap_lvt_t level)
 static int
 mmu_get_level(struct mmu_vas *vas, vaddr_t va, pmap_lvt_t lvl, uintptr_t **res)
 {
-    efi_status_t status;
-    uintptr_t *cur, tmp_va, addr;
+    uintptr_t *cur, addr;
     size_t index;
     pmap_lvt_t cur_level = PMAP_PML4;
 
@@ -154,26 +211,28 @@ mmu_get_level(struct mmu_vas *vas, vaddr_t va, pmap_lvt_t lvl, uintptr_t **res)
 
         /* Is this present? */
         if (ISSET(addr, PTE_P)) {
+            /* Can't descend through a huge page */
+            if (ISSET(addr, PTE_PS)) {
+                return -1;
+            }
+
             cur = (void *)(cur[index] & PTE_ADDR_MASK);
             --cur_level;
             continue;
         }
 
         /* Allocate new frame */
-        status = g_bootsrv->allocate_pages(
-            AllocateAnyPages,
-            EfiLoaderData,
-            1,
-            &addr
-        );
-        if (EFI_ERROR(status)) {
-            puts(L"out of memory\r\n");
+        if (mem_alloc_pages(L5_MEMP_PGTBL, 1, &addr) != 0) {
+            log_err("out of memory\n");
             die();
         }
 
         /* Write the new entry */
         cur[index] = (addr | PTE_P | PTE_RW);
         cur = (void *)addr;
+        for (int i = 0; i < 512; ++i) {
+            cur[i] = 0;
+        }
 
         /*
          * To be certain that we will see every change
@@ -190,21 +249,11 @@ mmu_get_level(struct mmu_vas *vas, vaddr_t va, pmap_lvt_t lvl, uintptr_t **res)
 int
 mmu_get_vas(struct mmu_vas *res_p)
 {
-    uint64_t cr3;
-
     if (res_p == NULL) {
         return -1;
     }
 
-    /* Read the CR3 value */
-    __ASMV(
-        "mov %%cr3, %0"
-        : "=r" (cr3)
-        :
-        : "memory"
-    );
-
-    res_p->pml4 = cr3 & PTE_ADDR_MASK;
+    res_p->pml4 = rdcr3() & PTE_ADDR_MASK;
     return 0;
 }
 
@@ -215,21 +264,28 @@ mmu_set_vas(struct mmu_vas *vas)
         return -1;
     }
 
-    __ASMV(
-        "mov %0, %%cr3"
-        :
-        : "r" (vas->pml4)
-        : "memory"
-    );
+    mmu_init_pat();
+    wrcr3(vas->pml4);
 
     return 0;
 }
 
+void
+mmu_init_pat(void)
+{
+    /*
+     * Our page tables pick memory types by
+     * PAT_LAYOUT, so it must be live before
+     * they are.
+     */
+    wrmsr(IA32_PAT, PAT_LAYOUT);
+}
+
 int
 mmu_map(struct mmu_vas *vas, vaddr_t va, paddr_t pa, int prot, int size)
 {
     uintptr_t *tbl;
-    uint32_t pte_flags = 0;
+    uint64_t pte_flags = 0;
     uintn_t index;
     int error;
 
@@ -237,6 +293,11 @@ mmu_map(struct mmu_vas *vas, vaddr_t va, paddr_t pa, int prot, int size)
         return -1;
     }
 
+    if (nx_enabled < 0) {
+        nx_enabled = ISSET(cpu_features(), L5_CPUF_NX) != 0;
+        pge_enabled = ISSET(cpu_features(), L5_CPUF_PGE) != 0;
+    }
+
     /* Grab the page table */
     switch (size) {
     case MAP_HUGE_2MIB:
@@ -273,12 +334,15 @@ mmu_map(struct mmu_vas *vas, vaddr_t va, paddr_t pa, int prot, int size)
     }
 
     if (error != 0) {
-        puts(L"mmu_map page table fetch failure\r\n");
+        log_err("mmu_map page table fetch failure\n");
         return -1;
     }
 
     /* Grab the MD flags and PTE index */
-    pte_flags |= prot_to_pte(prot);
+    pte_flags |= prot_to_pte(prot, size);
+    if (va >= KERNEL_HALF && pge_enabled > 0) {
+        pte_flags |= PTE_G;
+    }
 
     /* Create the mapping */
     tbl[index] = pa | pte_flags;
@@ -286,19 +350,182 @@ mmu_map(struct mmu_vas *vas, vaddr_t va, paddr_t pa, int prot, int size)
     return 0;
 }
 
+/*
+ * Get the preferred memory type of a physical range,
+ * regions the memory map does not describe are left
+ * write-back so the MTRRs decide for them.
+ *
+ * @map: Memory map
+ * @nent: Number of entries in `map'
+ * @pa: Physical base of range
+ * @len: Length of range
+ * @res: Resulting memory type (L5_CACHE_*)
+ *
+ * Returns zero if the range has a single memory type,
+ * otherwise a less than zero value.
+ */
+static int
+mmu_range_cache(struct l5_mementry *map, size_t nent, paddr_t pa,
+    size_t len, uint8_t *res)
+{
+    struct l5_mementry *ent;
+    paddr_t start, end;
+    size_t covered = 0;
+    int ntypes = 0;
+    uint8_t cache = L5_CACHE_WB;
+
+    for (size_t i = 0; i < nent; ++i) {
+        ent = &map[i];
+        start = ent->base;
+        end = ent->base + ent->npages * PAGE_SIZE;
+
+        /* Skip regions outside of this range */
+        if (end <= pa || start >= pa + len) {
+            continue;
+        }
+
+        if (ntypes++ > 0 && ent->cache != cache) {
+            return -1;
+        }
+
+        start = (start < pa) ? pa : start;
+        end = (end > pa + len) ? pa + len : end;
+        covered += end - start;
+        cache = ent->cache;
+    }
+
+    /* Holes are write-back */
+    if (covered < len && cache != L5_CACHE_WB) {
+        return -1;
+    }
+
+    *res = cache;
+    return 0;
+}
+
+/*
+ * Check if anything is mapped at a level, without
+ * allocating any page tables.
+ *
+ * @vas: Address space to look in
+ * @va: Virtual address to look up
+ * @lvl: Level the mapping would go in
+ *
+ * Returns non-zero if the entry is present, or if a
+ * huge page above the level covers `va'
+ */
+static int
+mmu_present(struct mmu_vas *vas, vaddr_t va, pmap_lvt_t lvl)
+{
+    uintptr_t *cur, ent;
+    pmap_lvt_t cur_level = PMAP_PML4;
+
+    cur = (void *)(vas->pml4 & PTE_ADDR_MASK);
+    for (;;) {
+        ent = cur[mmu_level_index(va, cur_level)];
+        if (!ISSET(ent, PTE_P)) {
+            return 0;
+        }
+        if (cur_level == lvl || ISSET(ent, PTE_PS)) {
+            return 1;
+        }
+
+        cur = (void *)(ent & PTE_ADDR_MASK);
+        --cur_level;
+    }
+}
+
+/*
+ * Check if the CPU can do 1 GiB pages
+ */
+static int
+mmu_has_1gib(void)
+{
+    uint32_t regs[4];
+
+    cpuid(0x80000001, 0, regs);
+    return ISSET(regs[3], BIT(26)) != 0;
+}
+
+int
+mmu_map_direct(struct mmu_vas *vas, vaddr_t va, size_t len, int prot,
+    struct l5_mementry *map, size_t nent)
+{
+    paddr_t pa = 0;
+    uint8_t cache;
+    int error, huge_1gib;
+
+    if (vas == NULL) {
+        return -1;
+    }
+
+    /*
+     * Use the biggest page that has a single memory
+     * type, 1 GiB first, then 2 MiB and at last 4K.
+     */
+    huge_1gib = mmu_has_1gib();
+    while (pa < len) {
+        /*
+         * Anything mapped already, such as the handoff path,
+         * breaks the huge page up around it.
+         */
+        if (huge_1gib && (pa & (MEM_1GIB - 1)) == 0 && pa + MEM_1GIB <= len &&
+            !mmu_present(vas, va + pa, PMAP_PDPT)) {
+            if (mmu_range_cache(map, nent, pa, MEM_1GIB, &cache) == 0) {
+                error = mmu_map(vas, va + pa, pa,
+                    prot | cache_to_prot(cache), MAP_HUGE_1GIB);
+                if (error != 0) {
+                    return error;
+                }
+
+                pa += MEM_1GIB;
+                continue;
+            }
+        }
+
+        if (!mmu_present(vas, va + pa, PMAP_PD) &&
+            mmu_range_cache(map, nent, pa, MEM_2MIB, &cache) == 0) {
+            error = mmu_map(vas, va + pa, pa, prot | cache_to_prot(cache),
+                MAP_HUGE_2MIB);
+            if (error != 0) {
+                return error;
+            }
+
+            pa += MEM_2MIB;
+            continue;
+        }
+
+        for (paddr_t off = 0; off < MEM_2MIB; off += PAGE_SIZE) {
+            if (mmu_present(vas, va + pa + off, PMAP_TBL)) {
+                continue;
+            }
+
+            /* Overlapping regions disagree, play it safe */
+            cache = L5_CACHE_UC;
+            mmu_range_cache(map, nent, pa + off, PAGE_SIZE, &cache);
+            error = mmu_map(vas, va + pa + off, pa + off,
+                prot | cache_to_prot(cache), MAP_SMALL_4K);
+            if (error != 0) {
+                return error;
+            }
+        }
+
+        pa += MEM_2MIB;
+    }
+
+    return 0;
+}
+
 int
 mmu_init_vas(uintptr_t pg)
 {
-    struct mmu_vas vas;
     uint64_t *pml4;
-    int error, prot = PROT_READ | PROT_WRITE;
 
-    if (pg == NULL) {
+    if (pg == 0) {
         return -1;
     }
 
     pml4 = (void *)pg;
-    vas.pml4 = pg;
 
     /*
      * Zero everything initially
@@ -307,14 +534,5 @@ mmu_init_vas(uintptr_t pg)
         pml4[i] = 0;
     }
 
-    /* Identity map the lower 4 GiB */
-    for (uintn_t i = 0; i < MEM_1GIB * 4; i += MAP_HUGE_1GIB) {
-        error = mmu_map(&vas, i, i, prot, MAP_HUGE_1GIB);
-        if (error != 0) {
-            puts(L"failed to map lower 4 GiB\r\n");
-            die();
-        }
-    }
-
     return 0;
 }
@@ -0,0 +1,369 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <machine/smp.h>
+#include <machine/cpu.h>
+#include <cdefs.h>
+#include <string.h>
+
+/* MSRs */
+#define IA32_APIC_BASE  0x1B
+#define IA32_PAT        0x277
+#define IA32_EFER       0xC0000080
+#define X2APIC_ICR      0x830
+
+#define APIC_BASE_EXTD  BIT(10)     /* x2APIC mode */
+#define EFER_LMA        BIT(10)     /* Long mode active, read only */
+#define CR4_OSXSAVE     BIT(18)     /* XSAVE and XCR0 */
+
+/* xAPIC registers */
+#define LAPIC_ICR_LO    0x300
+#define LAPIC_ICR_HI    0x310
+
+/* Interrupt command register bits */
+#define ICR_INIT        0x00000500
+#define ICR_STARTUP     0x00000600
+#define ICR_PENDING     BIT(12)
+#define ICR_ASSERT      BIT(14)
+#define ICR_ALL_BUT_SELF 0x000C0000
+
+/* Delays from the MP specification */
+#define INIT_DELAY_US   10000
+#define SIPI_DELAY_US   200
+
+/*
+ * Filled in by ap_tramp_install(), laid out like the
+ * ap_tramp_boot block of the trampoline below.
+ *
+ * @cr0: CR0 to enter long mode with
+ * @cr3: PML4 to enter long mode with
+ * @cr4: CR4 once in long mode
+ * @efer: EFER to enter long mode with
+ * @pat: PAT to use, must match the BSP
+ * @mbox: Physical base of the mailboxes
+ * @nmbox: Number of mailboxes
+ * @xcr0: XCR0 to load, zero to leave it
+ */
+struct ap_boot {
+    uint64_t cr0;
+    uint64_t cr3;
+    uint64_t cr4;
+    uint64_t efer;
+    uint64_t pat;
+    uint64_t mbox;
+    uint64_t nmbox;
+    uint64_t xcr0;
+};
+
+/*
+ * AP trampoline, copied to a page below 1 MiB. The APs
+ * come up in real mode at the start of the page, go
+ * through protected mode into long mode, look up their
+ * mailbox by APIC ID and spin on it. No stack is used
+ * so every AP can share the page.
+ *
+ * %ebp holds the physical base of the page throughout.
+ */
+__asm__(
+    ".text\n"
+    ".globl ap_tramp_start\n"
+    ".globl ap_tramp_gdt\n"
+    ".globl ap_tramp_gdtr\n"
+    ".globl ap_tramp_far32\n"
+    ".globl ap_tramp_far64\n"
+    ".globl ap_tramp_pm32\n"
+    ".globl ap_tramp_lm64\n"
+    ".globl ap_tramp_boot\n"
+    ".globl ap_tramp_end\n"
+    ".balign 16\n"
+    ".code16\n"
+    "ap_tramp_start:\n"
+    "    cli\n"
+    "    cld\n"
+    "    movw %cs, %ax\n"
+    "    movw %ax, %ds\n"
+    "    movzwl %ax, %ebp\n"
+    "    shll $4, %ebp\n"
+    "    lgdtl (ap_tramp_gdtr - ap_tramp_start)\n"
+    "    movl %cr0, %eax\n"
+    "    orl $1, %eax\n"
+    "    movl %eax, %cr0\n"
+    "    ljmpl *(ap_tramp_far32 - ap_tramp_start)\n"
+    ".code32\n"
+    "ap_tramp_pm32:\n"
+    "    movw $0x10, %ax\n"
+    "    movw %ax, %ds\n"
+    "    movw %ax, %es\n"
+    "    movw %ax, %ss\n"
+
+    /* PCIDE may only be set once in long mode */
+    "    movl (ap_tramp_cr4 - ap_tramp_start)(%ebp), %eax\n"
+    "    andl $~0x20000, %eax\n"
+    "    movl %eax, %cr4\n"
+    "    movl (ap_tramp_cr3 - ap_tramp_start)(%ebp), %eax\n"
+    "    movl %eax, %cr3\n"
+    "    movl $0xC0000080, %ecx\n"
+    "    movl (ap_tramp_efer - ap_tramp_start)(%ebp), %eax\n"
+    "    movl (ap_tramp_efer - ap_tramp_start + 4)(%ebp), %edx\n"
+    "    wrmsr\n"
+    "    movl $0x277, %ecx\n"
+    "    movl (ap_tramp_pat - ap_tramp_start)(%ebp), %eax\n"
+    "    movl (ap_tramp_pat - ap_tramp_start + 4)(%ebp), %edx\n"
+    "    wrmsr\n"
+    "    movl (ap_tramp_cr0 - ap_tramp_start)(%ebp), %eax\n"
+    "    movl %eax, %cr0\n"
+    "    ljmpl *(ap_tramp_far64 - ap_tramp_start)(%ebp)\n"
+    ".code64\n"
+    "ap_tramp_lm64:\n"
+    "    movw $0x10, %ax\n"
+    "    movw %ax, %ds\n"
+    "    movw %ax, %es\n"
+    "    movw %ax, %ss\n"
+    "    movw %ax, %fs\n"
+    "    movw %ax, %gs\n"
+    "    movl %ebp, %ebp\n"
+    "    movq (ap_tramp_cr4 - ap_tramp_start)(%rbp), %rax\n"
+    "    movq %rax, %cr4\n"
+
+    /* Same extended state as the BSP */
+    "    movq (ap_tramp_xcr0 - ap_tramp_start)(%rbp), %rax\n"
+    "    testq %rax, %rax\n"
+    "    jz 1f\n"
+    "    movq %rax, %rdx\n"
+    "    shrq $32, %rdx\n"
+    "    xorl %ecx, %ecx\n"
+    "    xsetbv\n"
+    "1:\n"
+
+    /* x2APIC ID if there is one, else the xAPIC ID */
+    "    xorl %eax, %eax\n"
+    "    cpuid\n"
+    "    cmpl $0xB, %eax\n"
+    "    jb 8f\n"
+    "    movl $0xB, %eax\n"
+    "    xorl %ecx, %ecx\n"
+    "    cpuid\n"
+    "    testl %ebx, %ebx\n"
+    "    jz 8f\n"
+    "    movl %edx, %esi\n"
+    "    jmp 2f\n"
+    "8:\n"
+    "    movl $1, %eax\n"
+    "    cpuid\n"
+    "    shrl $24, %ebx\n"
+    "    movl %ebx, %esi\n"
+
+    /* Find our mailbox */
+    "2:\n"
+    "    movq (ap_tramp_mbox - ap_tramp_start)(%rbp), %rdi\n"
+    "    movq (ap_tramp_nmbox - ap_tramp_start)(%rbp), %rcx\n"
+    "3:\n"
+    "    testq %rcx, %rcx\n"
+    "    jz 6f\n"
+    "    cmpl %esi, (%rdi)\n"
+    "    je 4f\n"
+    "    addq $64, %rdi\n"
+    "    decq %rcx\n"
+    "    jmp 3b\n"
+
+    /* Park until the kernel gives us somewhere to go */
+    "4:\n"
+    "    lock orl $1, 4(%rdi)\n"
+    "5:\n"
+    "    pause\n"
+    "    movq 8(%rdi), %rax\n"
+    "    testq %rax, %rax\n"
+    "    jz 5b\n"
+    "    movq 24(%rdi), %rdx\n"
+    "    testq %rdx, %rdx\n"
+    "    jz 7f\n"
+    "    movq %rdx, %rsp\n"
+    "    pushq $0\n"
+    "7:\n"
+    "    jmpq *%rax\n"
+
+    /* Not ours to start */
+    "6:\n"
+    "    cli\n"
+    "    hlt\n"
+    "    jmp 6b\n"
+    ".balign 16\n"
+    "ap_tramp_gdt:\n"
+    "    .quad 0x0000000000000000\n"     /* Null */
+    "    .quad 0x00AF9A000000FFFF\n"     /* Code (64-bit) */
+    "    .quad 0x00CF92000000FFFF\n"     /* Data */
+    "    .quad 0x00CF9A000000FFFF\n"     /* Code (32-bit) */
+    "ap_tramp_gdtr:\n"
+    "    .word 31\n"
+    "    .long 0\n"
+    "ap_tramp_far32:\n"
+    "    .long 0\n"
+    "    .word 0x18\n"
+    "ap_tramp_far64:\n"
+    "    .long 0\n"
+    "    .word 0x08\n"
+    ".balign 8\n"
+    "ap_tramp_boot:\n"
+    "ap_tramp_cr0:\n"
+    "    .quad 0\n"
+    "ap_tramp_cr3:\n"
+    "    .quad 0\n"
+    "ap_tramp_cr4:\n"
+    "    .quad 0\n"
+    "ap_tramp_efer:\n"
+    "    .quad 0\n"
+    "ap_tramp_pat:\n"
+    "    .quad 0\n"
+    "ap_tramp_mbox:\n"
+    "    .quad 0\n"
+    "ap_tramp_nmbox:\n"
+    "    .quad 0\n"
+    "ap_tramp_xcr0:\n"
+    "    .quad 0\n"
+    "ap_tramp_end:\n"
+);
+
+extern char ap_tramp_start[];
+extern char ap_tramp_gdt[];
+extern char ap_tramp_gdtr[];
+extern char ap_tramp_far32[];
+extern char ap_tramp_far64[];
+extern char ap_tramp_pm32[];
+extern char ap_tramp_lm64[];
+extern char ap_tramp_boot[];
+extern char ap_tramp_end[];
+
+/*
+ * Patch a 32-bit physical address into the
+ * copied trampoline.
+ *
+ * @page: Trampoline page
+ * @at: Field in the original trampoline
+ * @v: Value to store
+ */
+static inline void
+ap_tramp_patch(uintptr_t page, char *at, uint32_t v)
+{
+    uint8_t *p = (uint8_t *)page + (at - ap_tramp_start);
+
+    memcpy(p, &v, sizeof(v));
+}
+
+/*
+ * Spin for a number of microseconds
+ *
+ * @us: Microseconds to wait
+ * @tsc_per_us: TSC ticks per microsecond
+ */
+static void
+ap_delay(uint64_t us, uint64_t tsc_per_us)
+{
+    uint64_t end = rdtsc() + us * tsc_per_us;
+
+    while (rdtsc() < end) {
+        __ASMV("pause");
+    }
+}
+
+/*
+ * Send an IPI to every CPU but ourselves
+ *
+ * @icr: Low half of the interrupt command register
+ */
+static void
+lapic_ipi_others(uint32_t icr)
+{
+    uint64_t apic_base = rdmsr(IA32_APIC_BASE);
+    volatile uint32_t *lapic;
+
+    icr |= ICR_ALL_BUT_SELF;
+    if (ISSET(apic_base, APIC_BASE_EXTD)) {
+        wrmsr(X2APIC_ICR, icr);
+        return;
+    }
+
+    lapic = (volatile uint32_t *)ALIGN_DOWN(apic_base, 4096);
+    lapic[LAPIC_ICR_HI / 4] = 0;
+    lapic[LAPIC_ICR_LO / 4] = icr;
+    while (ISSET(lapic[LAPIC_ICR_LO / 4], ICR_PENDING)) {
+        __ASMV("pause");
+    }
+}
+
+int
+ap_tramp_install(uintptr_t page, uintptr_t cr3, uintptr_t mbox,
+    size_t nmbox)
+{
+    struct ap_boot boot;
+    size_t size = ap_tramp_end - ap_tramp_start;
+
+    if (page == 0 || page >= AP_TRAMP_LIMIT || cr3 >= 0x100000000ULL) {
+        return -1;
+    }
+
+    if (ISSET(page, 4096 - 1) || size > 4096) {
+        return -1;
+    }
+
+    memcpy((void *)page, ap_tramp_start, size);
+    ap_tramp_patch(page, ap_tramp_gdtr + 2, page + (ap_tramp_gdt -
+        ap_tramp_start));
+    ap_tramp_patch(page, ap_tramp_far32, page + (ap_tramp_pm32 -
+        ap_tramp_start));
+    ap_tramp_patch(page, ap_tramp_far64, page + (ap_tramp_lm64 -
+        ap_tramp_start));
+
+    __ASMV("mov %%cr0, %0" : "=r" (boot.cr0));
+    __ASMV("mov %%cr4, %0" : "=r" (boot.cr4));
+    boot.cr3 = cr3;
+    boot.efer = rdmsr(IA32_EFER) & ~EFER_LMA;
+    boot.pat = rdmsr(IA32_PAT);
+    boot.xcr0 = 0;
+    if (ISSET(boot.cr4, CR4_OSXSAVE)) {
+        boot.xcr0 = xgetbv(0);
+    }
+    boot.mbox = mbox;
+    boot.nmbox = nmbox;
+
+    memcpy((uint8_t *)page + (ap_tramp_boot - ap_tramp_start), &boot,
+        sizeof(boot));
+    return 0;
+}
+
+void
+ap_start_all(uintptr_t page, uint64_t tsc_per_us)
+{
+    uint32_t vector = (page >> 12) & 0xFF;
+
+    lapic_ipi_others(ICR_INIT | ICR_ASSERT);
+    ap_delay(INIT_DELAY_US, tsc_per_us);
+    lapic_ipi_others(ICR_STARTUP | ICR_ASSERT | vector);
+    ap_delay(SIPI_DELAY_US, tsc_per_us);
+    lapic_ipi_others(ICR_STARTUP | ICR_ASSERT | vector);
+}
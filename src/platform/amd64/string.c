@@ -0,0 +1,577 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <cdefs.h>
+#include <machine/cpu.h>
+#include <machine/string.h>
+
+/* Copies from here on use rep movsb with ERMS */
+#define ERMS_MIN        512
+
+/* Most caches a CPU reports, see cpu_caches() */
+#define MAX_CACHES      8
+
+typedef uint64_t __attribute__((may_alias, aligned(1))) u64_unaligned_t;
+typedef uint32_t __attribute__((may_alias, aligned(1))) u32_unaligned_t;
+
+#define LOAD64(p)       (*(const u64_unaligned_t *)(p))
+#define STORE64(p, v)   (*(u64_unaligned_t *)(p) = (v))
+#define LOAD32(p)       (*(const u32_unaligned_t *)(p))
+#define STORE32(p, v)   (*(u32_unaligned_t *)(p) = (v))
+
+static const struct string_variant *cur = &string_variants[STRING_SSE2];
+static int cur_variant = STRING_SSE2;
+static size_t nt_min = STRING_NT_DEFAULT;
+
+/*
+ * Copy up to STRING_SMALL bytes with overlapping
+ * loads and stores from both ends. Everything is
+ * loaded before anything is stored, so the buffers
+ * may overlap.
+ */
+static inline void
+copy_small(uint8_t *d, const uint8_t *s, size_t n)
+{
+    uint64_t w0, w1, w2, w3, w4, w5, w6, w7;
+
+    if (n >= 32) {
+        w0 = LOAD64(s);
+        w1 = LOAD64(s + 8);
+        w2 = LOAD64(s + 16);
+        w3 = LOAD64(s + 24);
+        w4 = LOAD64(s + n - 32);
+        w5 = LOAD64(s + n - 24);
+        w6 = LOAD64(s + n - 16);
+        w7 = LOAD64(s + n - 8);
+        STORE64(d, w0);
+        STORE64(d + 8, w1);
+        STORE64(d + 16, w2);
+        STORE64(d + 24, w3);
+        STORE64(d + n - 32, w4);
+        STORE64(d + n - 24, w5);
+        STORE64(d + n - 16, w6);
+        STORE64(d + n - 8, w7);
+    } else if (n >= 16) {
+        w0 = LOAD64(s);
+        w1 = LOAD64(s + 8);
+        w2 = LOAD64(s + n - 16);
+        w3 = LOAD64(s + n - 8);
+        STORE64(d, w0);
+        STORE64(d + 8, w1);
+        STORE64(d + n - 16, w2);
+        STORE64(d + n - 8, w3);
+    } else if (n >= 8) {
+        w0 = LOAD64(s);
+        w1 = LOAD64(s + n - 8);
+        STORE64(d, w0);
+        STORE64(d + n - 8, w1);
+    } else if (n >= 4) {
+        w0 = LOAD32(s);
+        w1 = LOAD32(s + n - 4);
+        STORE32(d, w0);
+        STORE32(d + n - 4, w1);
+    } else if (n != 0) {
+        w0 = s[0];
+        w1 = s[n / 2];
+        w2 = s[n - 1];
+        d[0] = w0;
+        d[n / 2] = w1;
+        d[n - 1] = w2;
+    }
+}
+
+/*
+ * Fill up to STRING_SMALL bytes with overlapping
+ * stores from both ends.
+ */
+static inline void
+fill_small(uint8_t *d, uint64_t pat, size_t n)
+{
+    if (n >= 32) {
+        STORE64(d, pat);
+        STORE64(d + 8, pat);
+        STORE64(d + 16, pat);
+        STORE64(d + 24, pat);
+        STORE64(d + n - 32, pat);
+        STORE64(d + n - 24, pat);
+        STORE64(d + n - 16, pat);
+        STORE64(d + n - 8, pat);
+    } else if (n >= 16) {
+        STORE64(d, pat);
+        STORE64(d + 8, pat);
+        STORE64(d + n - 16, pat);
+        STORE64(d + n - 8, pat);
+    } else if (n >= 8) {
+        STORE64(d, pat);
+        STORE64(d + n - 8, pat);
+    } else if (n >= 4) {
+        STORE32(d, (uint32_t)pat);
+        STORE32(d + n - 4, (uint32_t)pat);
+    } else if (n != 0) {
+        d[0] = (uint8_t)pat;
+        d[n / 2] = (uint8_t)pat;
+        d[n - 1] = (uint8_t)pat;
+    }
+}
+
+/*
+ * Copy forwards in unaligned 32 byte blocks, each
+ * block is loaded before it is stored so this is
+ * safe for overlaps with `d' below `s'.
+ */
+static void
+copy_fwd(uint8_t *d, const uint8_t *s, size_t n)
+{
+    __ASMV(
+        "1:\n\t"
+        "movdqu (%1), %%xmm0\n\t"
+        "movdqu 16(%1), %%xmm1\n\t"
+        "movdqu %%xmm0, (%0)\n\t"
+        "movdqu %%xmm1, 16(%0)\n\t"
+        "add $32, %0\n\t"
+        "add $32, %1\n\t"
+        "sub $32, %2\n\t"
+        "cmp $32, %2\n\t"
+        "jae 1b"
+        : "+r" (d), "+r" (s), "+r" (n)
+        :
+        : "xmm0", "xmm1", "cc", "memory"
+    );
+
+    copy_small(d, s, n);
+}
+
+/*
+ * Copy backwards in unaligned 32 byte blocks, safe
+ * for overlaps with `d' above `s'.
+ */
+static void
+copy_back(uint8_t *d, const uint8_t *s, size_t n)
+{
+    __ASMV(
+        "1:\n\t"
+        "sub $32, %2\n\t"
+        "movdqu (%1,%2), %%xmm0\n\t"
+        "movdqu 16(%1,%2), %%xmm1\n\t"
+        "movdqu %%xmm0, (%0,%2)\n\t"
+        "movdqu %%xmm1, 16(%0,%2)\n\t"
+        "cmp $32, %2\n\t"
+        "jae 1b"
+        : "+r" (d), "+r" (s), "+r" (n)
+        :
+        : "xmm0", "xmm1", "cc", "memory"
+    );
+
+    copy_small(d, s, n);
+}
+
+/*
+ * The loops below store the unaligned head first,
+ * then go over whole aligned blocks and leave the
+ * rest (less than a block) to copy_small() or
+ * fill_small().
+ */
+
+static void
+copy_sse2(uint8_t *d, const uint8_t *s, size_t n)
+{
+    uint8_t *end = d + n;
+    uint8_t *p = (uint8_t *)ALIGN_UP((uintptr_t)d, 16);
+    const uint8_t *q = s + (p - d);
+    size_t body = ALIGN_DOWN((size_t)(end - p), 64);
+
+    __ASMV(
+        "movdqu (%3), %%xmm0\n\t"
+        "movdqu %%xmm0, (%4)\n\t"
+        "test %2, %2\n\t"
+        "jz 2f\n\t"
+        "1:\n\t"
+        "movdqu (%1), %%xmm0\n\t"
+        "movdqu 16(%1), %%xmm1\n\t"
+        "movdqu 32(%1), %%xmm2\n\t"
+        "movdqu 48(%1), %%xmm3\n\t"
+        "movdqa %%xmm0, (%0)\n\t"
+        "movdqa %%xmm1, 16(%0)\n\t"
+        "movdqa %%xmm2, 32(%0)\n\t"
+        "movdqa %%xmm3, 48(%0)\n\t"
+        "add $64, %0\n\t"
+        "add $64, %1\n\t"
+        "sub $64, %2\n\t"
+        "jnz 1b\n\t"
+        "2:"
+        : "+r" (p), "+r" (q), "+r" (body)
+        : "r" (s), "r" (d)
+        : "xmm0", "xmm1", "xmm2", "xmm3", "cc", "memory"
+    );
+
+    copy_small(p, q, end - p);
+}
+
+static void
+copy_avx2(uint8_t *d, const uint8_t *s, size_t n)
+{
+    uint8_t *end = d + n;
+    uint8_t *p = (uint8_t *)ALIGN_UP((uintptr_t)d, 32);
+    const uint8_t *q = s + (p - d);
+    size_t body = ALIGN_DOWN((size_t)(end - p), 64);
+
+    __ASMV(
+        "vmovdqu (%3), %%ymm0\n\t"
+        "vmovdqu %%ymm0, (%4)\n\t"
+        "test %2, %2\n\t"
+        "jz 2f\n\t"
+        "1:\n\t"
+        "vmovdqu (%1), %%ymm0\n\t"
+        "vmovdqu 32(%1), %%ymm1\n\t"
+        "vmovdqa %%ymm0, (%0)\n\t"
+        "vmovdqa %%ymm1, 32(%0)\n\t"
+        "add $64, %0\n\t"
+        "add $64, %1\n\t"
+        "sub $64, %2\n\t"
+        "jnz 1b\n\t"
+        "2:\n\t"
+        "vzeroupper"
+        : "+r" (p), "+r" (q), "+r" (body)
+        : "r" (s), "r" (d)
+        : "xmm0", "xmm1", "cc", "memory"
+    );
+
+    copy_small(p, q, end - p);
+}
+
+static void
+copy_erms(uint8_t *d, const uint8_t *s, size_t n)
+{
+    /* rep movsb takes a while to get going */
+    if (n < ERMS_MIN) {
+        copy_sse2(d, s, n);
+        return;
+    }
+
+    __ASMV(
+        "rep movsb"
+        : "+D" (d), "+S" (s), "+c" (n)
+        :
+        : "memory"
+    );
+}
+
+static void
+fill_sse2(uint8_t *d, uint64_t pat, size_t n)
+{
+    uint8_t *end = d + n;
+    uint8_t *p = (uint8_t *)ALIGN_UP((uintptr_t)d, 16);
+    size_t body = ALIGN_DOWN((size_t)(end - p), 64);
+
+    __ASMV(
+        "movq %2, %%xmm0\n\t"
+        "punpcklqdq %%xmm0, %%xmm0\n\t"
+        "movdqu %%xmm0, (%3)\n\t"
+        "test %1, %1\n\t"
+        "jz 2f\n\t"
+        "1:\n\t"
+        "movdqa %%xmm0, (%0)\n\t"
+        "movdqa %%xmm0, 16(%0)\n\t"
+        "movdqa %%xmm0, 32(%0)\n\t"
+        "movdqa %%xmm0, 48(%0)\n\t"
+        "add $64, %0\n\t"
+        "sub $64, %1\n\t"
+        "jnz 1b\n\t"
+        "2:"
+        : "+r" (p), "+r" (body)
+        : "r" (pat), "r" (d)
+        : "xmm0", "cc", "memory"
+    );
+
+    fill_small(p, pat, end - p);
+}
+
+static void
+fill_nt_sse2(uint8_t *d, uint64_t pat, size_t n)
+{
+    uint8_t *end = d + n;
+    uint8_t *p = (uint8_t *)ALIGN_UP((uintptr_t)d, 16);
+    size_t body = ALIGN_DOWN((size_t)(end - p), 64);
+
+    __ASMV(
+        "movq %2, %%xmm0\n\t"
+        "punpcklqdq %%xmm0, %%xmm0\n\t"
+        "movdqu %%xmm0, (%3)\n\t"
+        "test %1, %1\n\t"
+        "jz 2f\n\t"
+        "1:\n\t"
+        "movntdq %%xmm0, (%0)\n\t"
+        "movntdq %%xmm0, 16(%0)\n\t"
+        "movntdq %%xmm0, 32(%0)\n\t"
+        "movntdq %%xmm0, 48(%0)\n\t"
+        "add $64, %0\n\t"
+        "sub $64, %1\n\t"
+        "jnz 1b\n\t"
+        "sfence\n\t"
+        "2:"
+        : "+r" (p), "+r" (body)
+        : "r" (pat), "r" (d)
+        : "xmm0", "cc", "memory"
+    );
+
+    fill_small(p, pat, end - p);
+}
+
+static void
+fill_avx2(uint8_t *d, uint64_t pat, size_t n)
+{
+    uint8_t *end = d + n;
+    uint8_t *p = (uint8_t *)ALIGN_UP((uintptr_t)d, 32);
+    size_t body = ALIGN_DOWN((size_t)(end - p), 64);
+
+    __ASMV(
+        "vmovq %2, %%xmm0\n\t"
+        "vpbroadcastq %%xmm0, %%ymm0\n\t"
+        "vmovdqu %%ymm0, (%3)\n\t"
+        "test %1, %1\n\t"
+        "jz 2f\n\t"
+        "1:\n\t"
+        "vmovdqa %%ymm0, (%0)\n\t"
+        "vmovdqa %%ymm0, 32(%0)\n\t"
+        "add $64, %0\n\t"
+        "sub $64, %1\n\t"
+        "jnz 1b\n\t"
+        "2:\n\t"
+        "vzeroupper"
+        : "+r" (p), "+r" (body)
+        : "r" (pat), "r" (d)
+        : "xmm0", "cc", "memory"
+    );
+
+    fill_small(p, pat, end - p);
+}
+
+static void
+fill_nt_avx2(uint8_t *d, uint64_t pat, size_t n)
+{
+    uint8_t *end = d + n;
+    uint8_t *p = (uint8_t *)ALIGN_UP((uintptr_t)d, 32);
+    size_t body = ALIGN_DOWN((size_t)(end - p), 64);
+
+    __ASMV(
+        "vmovq %2, %%xmm0\n\t"
+        "vpbroadcastq %%xmm0, %%ymm0\n\t"
+        "vmovdqu %%ymm0, (%3)\n\t"
+        "test %1, %1\n\t"
+        "jz 2f\n\t"
+        "1:\n\t"
+        "vmovntdq %%ymm0, (%0)\n\t"
+        "vmovntdq %%ymm0, 32(%0)\n\t"
+        "add $64, %0\n\t"
+        "sub $64, %1\n\t"
+        "jnz 1b\n\t"
+        "sfence\n\t"
+        "2:\n\t"
+        "vzeroupper"
+        : "+r" (p), "+r" (body)
+        : "r" (pat), "r" (d)
+        : "xmm0", "cc", "memory"
+    );
+
+    fill_small(p, pat, end - p);
+}
+
+static void
+fill_erms(uint8_t *d, uint64_t pat, size_t n)
+{
+    if (n < ERMS_MIN) {
+        fill_sse2(d, pat, n);
+        return;
+    }
+
+    __ASMV(
+        "rep stosb"
+        : "+D" (d), "+c" (n)
+        : "a" (pat)
+        : "memory"
+    );
+}
+
+const struct string_variant string_variants[STRING_NVARIANT] = {
+    [STRING_SSE2] = { "sse2", copy_sse2, fill_sse2, fill_nt_sse2 },
+    [STRING_AVX2] = { "avx2", copy_avx2, fill_avx2, fill_nt_avx2 },
+    [STRING_ERMS] = { "erms", copy_erms, fill_erms, fill_nt_sse2 }
+};
+
+void *
+memcpy(void *dest, const void *src, size_t n)
+{
+    if (n <= STRING_SMALL) {
+        copy_small(dest, src, n);
+    } else {
+        cur->copy(dest, src, n);
+    }
+    return dest;
+}
+
+void *
+memmove(void *dest, const void *src, size_t n)
+{
+    uint8_t *d = dest;
+    const uint8_t *s = src;
+
+    if (n <= STRING_SMALL) {
+        copy_small(d, s, n);
+    } else if ((uintptr_t)d - (uintptr_t)s >= n &&
+        (uintptr_t)s - (uintptr_t)d >= n) {
+        cur->copy(d, s, n);
+    } else if (d < s) {
+        copy_fwd(d, s, n);
+    } else if (d > s) {
+        copy_back(d, s, n);
+    }
+    return dest;
+}
+
+void *
+memset(void *s, int c, size_t n)
+{
+    uint64_t pat = (uint8_t)c * 0x0101010101010101ULL;
+
+    if (n <= STRING_SMALL) {
+        fill_small(s, pat, n);
+    } else if (n >= nt_min) {
+        cur->fill_nt(s, pat, n);
+    } else {
+        cur->fill(s, pat, n);
+    }
+    return s;
+}
+
+void *
+memset_nt(void *s, int c, size_t n)
+{
+    uint64_t pat = (uint8_t)c * 0x0101010101010101ULL;
+
+    if (n <= STRING_SMALL) {
+        fill_small(s, pat, n);
+    } else {
+        cur->fill_nt(s, pat, n);
+    }
+    return s;
+}
+
+int
+string_usable(int variant)
+{
+    uint32_t regs[4];
+    uint32_t max;
+
+    cpuid(0, 0, regs);
+    max = regs[0];
+
+    switch (variant) {
+    case STRING_SSE2:
+        return 1;
+    case STRING_AVX2:
+        if (max < 7) {
+            return 0;
+        }
+
+        /* The OS has to save the YMM state for us */
+        cpuid(1, 0, regs);
+        if (!ISSET(regs[2], BIT(27)) || !ISSET(regs[2], BIT(28))) {
+            return 0;
+        }
+        if ((xgetbv(0) & (XCR0_SSE | XCR0_AVX)) != (XCR0_SSE | XCR0_AVX)) {
+            return 0;
+        }
+
+        cpuid(7, 0, regs);
+        return ISSET(regs[1], BIT(5)) != 0;
+    case STRING_ERMS:
+        if (max < 7) {
+            return 0;
+        }
+
+        cpuid(7, 0, regs);
+        return ISSET(regs[1], BIT(9)) != 0;
+    }
+
+    return 0;
+}
+
+int
+string_select(int variant, size_t nt_min_new)
+{
+    if (variant < 0 || variant >= STRING_NVARIANT) {
+        return -1;
+    }
+    if (!string_usable(variant) || nt_min_new <= STRING_SMALL) {
+        return -1;
+    }
+
+    cur = &string_variants[variant];
+    cur_variant = variant;
+    nt_min = nt_min_new;
+    return 0;
+}
+
+int
+string_current(size_t *nt_min_res)
+{
+    if (nt_min_res != NULL) {
+        *nt_min_res = nt_min;
+    }
+    return cur_variant;
+}
+
+int
+string_init(void)
+{
+    struct l5_cache caches[MAX_CACHES];
+    size_t ncache, llc = 0;
+    int variant = STRING_SSE2;
+
+    if (string_usable(STRING_ERMS)) {
+        variant = STRING_ERMS;
+    } else if (string_usable(STRING_AVX2)) {
+        variant = STRING_AVX2;
+    }
+
+    /*
+     * A fill bigger than the last level cache would
+     * only evict everything else on its way through.
+     */
+    ncache = cpu_caches(caches, MAX_CACHES);
+    for (size_t i = 0; i < ncache; ++i) {
+        if (caches[i].size > llc) {
+            llc = caches[i].size;
+        }
+    }
+
+    string_select(variant, (llc != 0) ? llc : STRING_NT_DEFAULT);
+    return variant;
+}
@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cdefs.h>
+#include <machine/uart.h>
+#include <machine/pio.h>
+
+/* Register offsets */
+#define UART_THR    0x00    /* Transmit holding (DLAB = 0) */
+#define UART_DLL    0x00    /* Divisor latch low (DLAB = 1) */
+#define UART_IER    0x01    /* Interrupt enable (DLAB = 0) */
+#define UART_DLM    0x01    /* Divisor latch high (DLAB = 1) */
+#define UART_FCR    0x02    /* FIFO control (write) */
+#define UART_IIR    0x02    /* Interrupt identification (read) */
+#define UART_LCR    0x03    /* Line control */
+#define UART_MCR    0x04    /* Modem control */
+#define UART_LSR    0x05    /* Line status */
+#define UART_SCR    0x07    /* Scratch */
+
+#define UART_LCR_8N1    0x03
+#define UART_LCR_DLAB   BIT(7)
+#define UART_MCR_DTR    BIT(0)
+#define UART_MCR_RTS    BIT(1)
+#define UART_MCR_OUT2   BIT(3)
+#define UART_MCR_LOOP   BIT(4)
+#define UART_LSR_THRE   BIT(5)  /* Holding register (and FIFO) empty */
+#define UART_IIR_FIFO   (BIT(6) | BIT(7))
+#define UART_IIR_FIFO64 BIT(5)
+
+/* Enable and clear the FIFOs, 64 bytes deep if possible */
+#define UART_FCR_INIT   0x27
+
+/* Input clock over 16 */
+#define UART_CLOCK      115200
+
+/* Give up on a stuck transmitter after this many polls */
+#define UART_SPIN_MAX   1000000
+
+static uint16_t uart_port;
+static uint32_t uart_depth;
+static int uart_ok;
+
+/*
+ * Turn a port name into an I/O port
+ */
+static uint16_t
+uart_parse_port(const char *port)
+{
+    static const uint16_t com[] = { 0x3F8, 0x2F8, 0x3E8, 0x2E8 };
+    uint32_t v = 0;
+    char c;
+
+    if (port == NULL) {
+        return com[0];
+    }
+
+    if ((port[0] | 0x20) == 'c' && (port[1] | 0x20) == 'o' &&
+        (port[2] | 0x20) == 'm' && port[3] >= '1' && port[3] <= '4' &&
+        port[4] == '\0') {
+        return com[port[3] - '1'];
+    }
+
+    /* Hex with a 0x prefix, decimal otherwise */
+    if (port[0] == '0' && (port[1] == 'x' || port[1] == 'X')) {
+        for (port += 2; (c = *port) != '\0'; ++port) {
+            if (c >= '0' && c <= '9') {
+                v = (v << 4) | (c - '0');
+            } else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') {
+                v = (v << 4) | ((c | 0x20) - 'a' + 10);
+            } else {
+                return 0;
+            }
+        }
+    } else {
+        for (; (c = *port) >= '0' && c <= '9'; ++port) {
+            v = v * 10 + (c - '0');
+        }
+        if (*port != '\0') {
+            return 0;
+        }
+    }
+
+    return (v > 0xFFFF) ? 0 : v;
+}
+
+/*
+ * Check if there is a UART at `uart_port' by
+ * sending a byte to ourselves in loopback mode.
+ */
+static int
+uart_probe(void)
+{
+    outb(uart_port + UART_SCR, 0x5A);
+    if (inb(uart_port + UART_SCR) != 0x5A) {
+        return -1;
+    }
+
+    outb(uart_port + UART_MCR, UART_MCR_LOOP | UART_MCR_RTS);
+    outb(uart_port + UART_THR, 0xAE);
+    for (uint32_t i = 0; i < UART_SPIN_MAX; ++i) {
+        if (ISSET(inb(uart_port + UART_LSR), BIT(0))) {
+            return (inb(uart_port + UART_THR) == 0xAE) ? 0 : -1;
+        }
+    }
+
+    return -1;
+}
+
+int
+uart_init(const char *port, uint32_t baud)
+{
+    uint32_t div;
+    uint8_t iir;
+
+    if (baud == 0) {
+        baud = UART_BAUD_DEFAULT;
+    }
+
+    div = UART_CLOCK / baud;
+    if (div == 0 || div > 0xFFFF || UART_CLOCK % baud != 0) {
+        return -1;
+    }
+
+    uart_port = uart_parse_port(port);
+    if (uart_port == 0) {
+        return -1;
+    }
+
+    /*
+     * Polled output only. The 64 byte FIFO bit of a 16750
+     * only sticks while DLAB is set.
+     */
+    outb(uart_port + UART_IER, 0x00);
+    outb(uart_port + UART_LCR, UART_LCR_DLAB);
+    outb(uart_port + UART_DLL, div & 0xFF);
+    outb(uart_port + UART_DLM, div >> 8);
+    outb(uart_port + UART_FCR, UART_FCR_INIT);
+    outb(uart_port + UART_LCR, UART_LCR_8N1);
+    inb(uart_port + UART_THR);
+
+    if (uart_probe() != 0) {
+        return -1;
+    }
+
+    /*
+     * A 16550A reports a working FIFO in IIR, a 16750
+     * also says if it took the 64 byte mode.
+     */
+    iir = inb(uart_port + UART_IIR);
+    if ((iir & UART_IIR_FIFO) != UART_IIR_FIFO) {
+        uart_depth = 1;
+    } else {
+        uart_depth = ISSET(iir, UART_IIR_FIFO64) ? 64 : 16;
+    }
+
+    outb(uart_port + UART_MCR, UART_MCR_DTR | UART_MCR_RTS | UART_MCR_OUT2);
+    uart_ok = 1;
+    return 0;
+}
+
+/*
+ * Wait for the FIFO to run dry
+ *
+ * Returns -1 if it never does
+ */
+static int
+uart_wait(void)
+{
+    for (uint32_t i = 0; i < UART_SPIN_MAX; ++i) {
+        if (ISSET(inb(uart_port + UART_LSR), UART_LSR_THRE)) {
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+void
+uart_puts(const uint16_t *s)
+{
+    uint32_t n;
+
+    if (!uart_ok) {
+        return;
+    }
+
+    /* One line status read per FIFO load */
+    while (*s != '\0') {
+        if (uart_wait() != 0) {
+            uart_ok = 0;
+            return;
+        }
+
+        for (n = 0; n < uart_depth && *s != '\0'; ++n, ++s) {
+            outb(uart_port + UART_THR, (*s < 0x7F) ? *s : '?');
+        }
+    }
+}
+
+void
+uart_write(const char *s, size_t len)
+{
+    uint32_t n;
+
+    if (!uart_ok) {
+        return;
+    }
+
+    while (len > 0) {
+        if (uart_wait() != 0) {
+            uart_ok = 0;
+            return;
+        }
+
+        for (n = 0; n < uart_depth && len > 0; ++n, --len) {
+            outb(uart_port + UART_THR, *s++);
+        }
+    }
+}
+
+int
+uart_active(void)
+{
+    return uart_ok;
+}
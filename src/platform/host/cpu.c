@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <machine/cpu.h>
+#include <machine/host.h>
+#include <cdefs.h>
+
+/* Max number of MSRs the emulated CPU keeps */
+#define HOST_MAX_MSR    16
+
+#define IA32_PAT        0x277
+
+/*
+ * An emulated MSR, unused when `valid' is zero
+ */
+struct host_msr {
+    uint32_t msr;
+    int valid;
+    uint64_t v;
+};
+
+/* Same layout as on amd64, the contents never matter */
+static uint64_t gdt[] __attribute__((aligned(16))) = {
+    0x0000000000000000,
+    0x00AF9A000000FFFF,
+    0x00CF92000000FFFF
+};
+
+static struct host_msr msrs[HOST_MAX_MSR];
+static uint64_t cr3 = 0;
+static size_t ninvlpg = 0;
+
+/*
+ * Find an emulated MSR
+ *
+ * @msr: MSR to find
+ * @alloc: Take a free slot if it has none
+ */
+static struct host_msr *
+host_msr(uint32_t msr, int alloc)
+{
+    struct host_msr *free_mp = NULL;
+
+    for (size_t i = 0; i < HOST_MAX_MSR; ++i) {
+        if (msrs[i].valid && msrs[i].msr == msr) {
+            return &msrs[i];
+        }
+        if (!msrs[i].valid && free_mp == NULL) {
+            free_mp = &msrs[i];
+        }
+    }
+
+    if (!alloc || free_mp == NULL) {
+        return NULL;
+    }
+
+    free_mp->msr = msr;
+    free_mp->valid = 1;
+    free_mp->v = 0;
+    return free_mp;
+}
+
+uint64_t
+rdmsr(uint32_t msr)
+{
+    struct host_msr *mp = host_msr(msr, 0);
+
+    return (mp != NULL) ? mp->v : 0;
+}
+
+void
+wrmsr(uint32_t msr, uint64_t v)
+{
+    struct host_msr *mp = host_msr(msr, 1);
+
+    if (mp != NULL) {
+        mp->v = v;
+    }
+}
+
+uint64_t
+rdcr3(void)
+{
+    return cr3;
+}
+
+void
+wrcr3(uint64_t v)
+{
+    cr3 = v;
+}
+
+void
+invlpg(uintptr_t va)
+{
+    ++ninvlpg;
+}
+
+void
+host_cpu_stat(struct host_cpu_stat *res)
+{
+    res->pat = rdmsr(IA32_PAT);
+    res->cr3 = cr3;
+    res->ninvlpg = ninvlpg;
+}
+
+void
+cpu_enable(struct cpu_state *res)
+{
+    /*
+     * The features are what the host CPU has, none
+     * of them are turned on here.
+     */
+    res->features = cpu_features();
+    res->xcr0 = 0;
+    res->cr0 = 0;
+    res->cr4 = 0;
+}
+
+int
+cpu_handoff_init(struct cpu_handoff *hp, uint64_t cr3, uintptr_t stack,
+    uintptr_t entry, void *arg)
+{
+    if (hp == NULL || cr3 == 0 || stack == 0) {
+        return -1;
+    }
+
+    hp->cr3 = cr3;
+    hp->entry = entry;
+    hp->arg = (uint64_t)arg;
+    hp->gdtr.limit = sizeof(gdt) - 1;
+    hp->gdtr.base = (uint64_t)gdt;
+    hp->stack = ALIGN_DOWN(stack, 16);
+    return 0;
+}
+
+void
+cpu_handoff(struct cpu_handoff *hp)
+{
+    /* The run ends here, see platform/host/host.c */
+    wrcr3(hp->cr3);
+    host_handoff(hp);
+}
@@ -0,0 +1,1291 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Mock firmware for the host build. Just enough of the
+ * boot services, runtime services and protocols that
+ * the loader uses is emulated, the rest answer with
+ * EFI_UNSUPPORTED. Physical memory is a block of host
+ * memory mapped at its own physical address, so the
+ * loader can use the addresses it gets as pointers
+ * like it does on real firmware.
+ *
+ * The firmware is strict where real firmware may be
+ * lax: boot services used past the exit, or anything
+ * but the memory services between a failed exit and
+ * the retry, end the run.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <efi.h>
+#include <string.h>
+#include <cdefs.h>
+#include <machine/host.h>
+
+#define PAGESIZE        4096
+
+/* Max number of memory descriptors */
+#define MOCK_MAXDESC    512
+
+/* Max number of variables and their sizes */
+#define MOCK_MAXVAR     16
+#define MOCK_VARNAME    64
+#define MOCK_VARDATA    256
+
+/* Max length of a file name */
+#define MOCK_NAMELEN    256
+
+/* Firmware hands out pages as it left them, not zeroed */
+#define MOCK_POISON     0xAF
+
+/* Every pool block starts with this */
+#define POOL_MAGIC      0x4C35504F4F4C0000ULL
+#define POOL_HDRSIZE    16
+
+/* Memory attributes of RAM */
+#define MEM_ATTR        (EFI_MEMORY_UC | EFI_MEMORY_WC | EFI_MEMORY_WT | \
+                         EFI_MEMORY_WB)
+
+/* Calls that are counted */
+#define MOCK_ALLOC_PAGES    0
+#define MOCK_FREE_PAGES     1
+#define MOCK_GET_MEMMAP     2
+#define MOCK_ALLOC_POOL     3
+#define MOCK_FREE_POOL      4
+#define MOCK_EXIT           5
+#define MOCK_FILE_OPEN      6
+#define MOCK_FILE_READ      7
+#define MOCK_STALL          8
+#define MOCK_NCALLS         9
+
+static const char *mock_names[MOCK_NCALLS] = {
+    [MOCK_ALLOC_PAGES] = "allocate_pages",
+    [MOCK_FREE_PAGES] = "free_pages",
+    [MOCK_GET_MEMMAP] = "get_memory_map",
+    [MOCK_ALLOC_POOL] = "allocate_pool",
+    [MOCK_FREE_POOL] = "free_pool",
+    [MOCK_EXIT] = "exit_boot_services",
+    [MOCK_FILE_OPEN] = "file_open",
+    [MOCK_FILE_READ] = "file_read",
+    [MOCK_STALL] = "stall"
+};
+
+/*
+ * A memory descriptor, the map is kept sorted and
+ * neighbours of the same kind are merged.
+ */
+struct mock_desc {
+    uint32_t type;
+    uint64_t base;
+    uint64_t npages;
+    uint64_t attr;
+};
+
+/*
+ * A variable kept by the runtime services, these
+ * are gone once the run ends.
+ */
+struct mock_var {
+    uint16_t name[MOCK_VARNAME];
+    EFI_GUID guid;
+    uint32_t attr;
+    uintn_t size;
+    uint8_t data[MOCK_VARDATA];
+};
+
+/*
+ * An open file on the boot volume
+ *
+ * @proto: What the loader sees, must come first
+ * @fd: Host file descriptor
+ * @name: Name as opened
+ */
+struct mock_file {
+    EFI_FILE_PROTOCOL proto;
+    int fd;
+    uint16_t name[MOCK_NAMELEN];
+};
+
+/*
+ * A GOP mode
+ *
+ * @info: What query_mode() reports
+ * @fb_size: Bytes of framebuffer the mode uses
+ */
+struct mock_mode {
+    EFI_GRAPHICS_OUTPUT_MODE_INFORMATION info;
+    uintn_t fb_size;
+};
+
+static struct host_fw fw;
+static struct mock_desc map[MOCK_MAXDESC];
+static size_t nmap = 0;
+static size_t map_peak = 0;
+static uintn_t map_key = 1;
+static struct mock_var vars[MOCK_MAXVAR];
+static uint64_t counts[MOCK_NCALLS];
+static uint64_t read_bytes = 0;
+static uint64_t stall_us = 0;
+static int exiting = 0;
+static int gone = 0;
+
+static EFI_SYSTEM_TABLE systab;
+static EFI_BOOT_SERVICES bootsrv;
+static EFI_RUNTIME_SERVICES rtsrv;
+static EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL con_out;
+static EFI_SIMPLE_TEXT_INPUT_PROTOCOL con_in;
+static SIMPLE_TEXT_OUTPUT_MODE con_mode;
+static EFI_LOADED_IMAGE_PROTOCOL image;
+static EFI_SIMPLE_FILE_SYSTEM_PROTOCOL sfs;
+static EFI_GRAPHICS_OUTPUT_PROTOCOL gop;
+static EFI_GRAPHICS_OUTPUT_PROTOCOL_MODE gop_mode;
+static struct mock_mode modes[8];
+static uint32_t nmodes = 0;
+static EFI_EDID_PROTOCOL edid;
+static uint8_t edid_block[128];
+static char image_handle, device_handle, gop_handle;
+
+/*
+ * End the run on a firmware rule the loader broke
+ *
+ * @what: What was done
+ * @call: Service it was done with
+ */
+static void
+mock_abort(const char *what, const char *call)
+{
+    fflush(stdout);
+    fprintf(stderr, "host: %s: %s\n", call, what);
+    exit(1);
+}
+
+/*
+ * Check that a boot service may be used right now
+ *
+ * @call: Name of the service
+ * @mem: If the service is a memory service
+ */
+static void
+mock_live(const char *call, int mem)
+{
+    if (gone) {
+        mock_abort("boot service used after exit", call);
+    }
+
+    if (exiting && !mem) {
+        mock_abort("only memory services may follow a failed exit", call);
+    }
+}
+
+static int
+guid_eq(const EFI_GUID *a, const EFI_GUID *b)
+{
+    return memcmp(a, b, sizeof(*a)) == 0;
+}
+
+static size_t
+ucs2_len(const uint16_t *s)
+{
+    size_t n = 0;
+
+    while (s[n] != 0) {
+        ++n;
+    }
+    return n;
+}
+
+static int
+ucs2_eq(const uint16_t *a, const uint16_t *b)
+{
+    while (*a != 0 && *a == *b) {
+        ++a;
+        ++b;
+    }
+    return *a == *b;
+}
+
+/*
+ * Merge neighbouring descriptors of the same kind
+ */
+static void
+map_merge(void)
+{
+    struct mock_desc *a, *b;
+    size_t i = 0, j;
+
+    while (i + 1 < nmap) {
+        a = &map[i];
+        b = &map[i + 1];
+        if (a->type != b->type || a->attr != b->attr ||
+            a->base + a->npages * PAGESIZE != b->base) {
+            ++i;
+            continue;
+        }
+
+        a->npages += b->npages;
+        for (j = i + 1; j + 1 < nmap; ++j) {
+            map[j] = map[j + 1];
+        }
+        --nmap;
+    }
+}
+
+/*
+ * Insert a descriptor in order
+ *
+ * Returns zero on success
+ */
+static int
+map_insert(uint32_t type, uint64_t base, uint64_t npages, uint64_t attr)
+{
+    size_t i, pos = 0;
+
+    if (nmap >= MOCK_MAXDESC) {
+        return -1;
+    }
+
+    while (pos < nmap && map[pos].base < base) {
+        ++pos;
+    }
+    for (i = nmap; i > pos; --i) {
+        map[i] = map[i - 1];
+    }
+
+    map[pos].type = type;
+    map[pos].base = base;
+    map[pos].npages = npages;
+    map[pos].attr = attr;
+    ++nmap;
+    return 0;
+}
+
+/*
+ * Find the descriptor holding a range
+ *
+ * Returns its index, -1 if no single one does
+ */
+static ssize_t
+map_find(uint64_t base, uint64_t npages)
+{
+    uint64_t end = base + npages * PAGESIZE;
+
+    for (size_t i = 0; i < nmap; ++i) {
+        if (base >= map[i].base &&
+            end <= map[i].base + map[i].npages * PAGESIZE) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/*
+ * Change the type of a range, the range must be
+ * within one descriptor. Any change to the map
+ * gives it a new key.
+ *
+ * Returns zero on success
+ */
+static int
+map_set(uint64_t base, uint64_t npages, uint32_t type)
+{
+    struct mock_desc old;
+    uint64_t end, old_end;
+    ssize_t i;
+
+    if ((i = map_find(base, npages)) < 0) {
+        return -1;
+    }
+
+    /* Worst case splits one into three */
+    if (nmap + 2 > MOCK_MAXDESC) {
+        return -1;
+    }
+
+    old = map[i];
+    end = base + npages * PAGESIZE;
+    old_end = old.base + old.npages * PAGESIZE;
+
+    map[i].type = type;
+    map[i].base = base;
+    map[i].npages = npages;
+    if (base > old.base) {
+        map_insert(old.type, old.base, (base - old.base) / PAGESIZE,
+            old.attr);
+    }
+    if (end < old_end) {
+        map_insert(old.type, end, (old_end - end) / PAGESIZE, old.attr);
+    }
+
+    map_merge();
+    if (nmap > map_peak) {
+        map_peak = nmap;
+    }
+
+    ++map_key;
+    return 0;
+}
+
+/*
+ * Allocate pages top-down like most firmware does
+ *
+ * @type: EFI_ALLOCATE_TYPE
+ * @memtype: Memory type to give the pages
+ * @npages: Number of pages
+ * @addr: Limit or address in, base out
+ */
+static efi_status_t
+mock_alloc(EFI_ALLOCATE_TYPE type, EFI_MEMORY_TYPE memtype, uintn_t npages,
+    efi_phys_addr_t *addr)
+{
+    uint64_t top, base, len = npages * PAGESIZE;
+    uint64_t limit = UINT64_MAX;
+    struct mock_desc *ent;
+    ssize_t i;
+
+    if (npages == 0 || addr == NULL || memtype == EfiConventionalMemory ||
+        (memtype >= EfiMaxMemoryType && memtype < 0x70000000)) {
+        return EFI_INVALID_PARAMETER;
+    }
+
+    switch (type) {
+    case AllocateAddress:
+        if (ISSET(*addr, PAGESIZE - 1)) {
+            return EFI_INVALID_PARAMETER;
+        }
+
+        i = map_find(*addr, npages);
+        if (i < 0 || map[i].type != EfiConventionalMemory) {
+            return EFI_NOT_FOUND;
+        }
+
+        map_set(*addr, npages, memtype);
+        return EFI_SUCCESS;
+    case AllocateMaxAddress:
+        limit = *addr;
+        break;
+    case AllocateAnyPages:
+        break;
+    default:
+        return EFI_INVALID_PARAMETER;
+    }
+
+    for (i = nmap - 1; i >= 0; --i) {
+        ent = &map[i];
+        if (ent->type != EfiConventionalMemory) {
+            continue;
+        }
+
+        top = ent->base + ent->npages * PAGESIZE;
+        if (limit < top - 1) {
+            top = ALIGN_DOWN(limit + 1, PAGESIZE);
+        }
+        if (top < ent->base + len) {
+            continue;
+        }
+
+        base = top - len;
+        if (map_set(base, npages, memtype) != 0) {
+            return EFI_OUT_OF_RESOURCES;
+        }
+
+        *addr = base;
+        return EFI_SUCCESS;
+    }
+
+    return EFI_OUT_OF_RESOURCES;
+}
+
+static efi_status_t __efiapi
+mock_unsupported(void)
+{
+    return EFI_UNSUPPORTED;
+}
+
+/*
+ * Point every service of a table at mock_unsupported(),
+ * the ones that are emulated are set afterwards.
+ *
+ * @tbl: First service of the table
+ * @end: End of the table
+ */
+static void
+mock_fill(void *tbl, void *end)
+{
+    efi_status_t (__efiapi **fn)(void) = tbl;
+
+    while ((void *)fn < end) {
+        *fn++ = mock_unsupported;
+    }
+}
+
+static efi_status_t __efiapi
+mock_allocate_pages(EFI_ALLOCATE_TYPE type, EFI_MEMORY_TYPE memtype,
+    uintn_t npages, efi_phys_addr_t *addr)
+{
+    efi_status_t status;
+
+    mock_live("allocate_pages", 1);
+    ++counts[MOCK_ALLOC_PAGES];
+    status = mock_alloc(type, memtype, npages, addr);
+    if (!EFI_ERROR(status)) {
+        memset((void *)*addr, MOCK_POISON, npages * PAGESIZE);
+    }
+    return status;
+}
+
+static efi_status_t __efiapi
+mock_free_pages(efi_phys_addr_t addr, uintn_t npages)
+{
+    ssize_t i;
+
+    mock_live("free_pages", 1);
+    ++counts[MOCK_FREE_PAGES];
+
+    i = map_find(addr, npages);
+    if (i < 0 || ISSET(addr, PAGESIZE - 1) ||
+        map[i].type == EfiConventionalMemory) {
+        return EFI_NOT_FOUND;
+    }
+
+    map_set(addr, npages, EfiConventionalMemory);
+    return EFI_SUCCESS;
+}
+
+static efi_status_t __efiapi
+mock_get_memory_map(uintn_t *size, EFI_MEMORY_DESCRIPTOR *buf,
+    uintn_t *key, uintn_t *desc_size, uint32_t *desc_version)
+{
+    EFI_MEMORY_DESCRIPTOR *desc;
+    uintn_t need = nmap * fw.desc_size;
+
+    mock_live("get_memory_map", 1);
+    ++counts[MOCK_GET_MEMMAP];
+
+    if (size == NULL) {
+        return EFI_INVALID_PARAMETER;
+    }
+    if (desc_size != NULL) {
+        *desc_size = fw.desc_size;
+    }
+    if (desc_version != NULL) {
+        *desc_version = EFI_MEMORY_DESCRIPTOR_VERSION;
+    }
+
+    if (*size < need || buf == NULL) {
+        *size = need;
+        return EFI_BUFFER_TOO_SMALL;
+    }
+
+    /* Descriptors may be larger than the struct, zero the rest */
+    memset(buf, 0, need);
+    for (size_t i = 0; i < nmap; ++i) {
+        desc = (void *)((uint8_t *)buf + i * fw.desc_size);
+        desc->type = map[i].type;
+        desc->physical_start = map[i].base;
+        desc->virtual_start = 0;
+        desc->number_of_pages = map[i].npages;
+        desc->attribute = map[i].attr;
+    }
+
+    *size = need;
+    if (key != NULL) {
+        *key = map_key;
+    }
+    return EFI_SUCCESS;
+}
+
+static efi_status_t __efiapi
+mock_allocate_pool(EFI_MEMORY_TYPE type, uintn_t size, void **buf)
+{
+    efi_phys_addr_t addr;
+    efi_status_t status;
+    uintn_t npages;
+    uint64_t *hdr;
+
+    mock_live("allocate_pool", 1);
+    ++counts[MOCK_ALLOC_POOL];
+
+    if (buf == NULL) {
+        return EFI_INVALID_PARAMETER;
+    }
+
+    /* Each block gets pages of its own, which churns the map */
+    npages = ALIGN_UP(size + POOL_HDRSIZE, PAGESIZE) / PAGESIZE;
+    status = mock_alloc(AllocateAnyPages, type, npages, &addr);
+    if (EFI_ERROR(status)) {
+        return status;
+    }
+
+    hdr = (uint64_t *)addr;
+    hdr[0] = POOL_MAGIC;
+    hdr[1] = npages;
+    *buf = (uint8_t *)hdr + POOL_HDRSIZE;
+    return EFI_SUCCESS;
+}
+
+static efi_status_t __efiapi
+mock_free_pool(void *buf)
+{
+    uint64_t *hdr;
+
+    mock_live("free_pool", 1);
+    ++counts[MOCK_FREE_POOL];
+
+    if (buf == NULL) {
+        return EFI_INVALID_PARAMETER;
+    }
+
+    hdr = (uint64_t *)((uint8_t *)buf - POOL_HDRSIZE);
+    if (ISSET((uintptr_t)hdr, PAGESIZE - 1) || hdr[0] != POOL_MAGIC) {
+        mock_abort("not a pool block", "free_pool");
+    }
+
+    hdr[0] = 0;
+    map_set((uintptr_t)hdr, hdr[1], EfiConventionalMemory);
+    return EFI_SUCCESS;
+}
+
+static efi_status_t __efiapi
+mock_handle_protocol(efi_handle_t handle, EFI_GUID *proto, void **iface)
+{
+    EFI_GUID lip_guid = EFI_LOADED_IMAGE_PROTOCOL_GUID;
+    EFI_GUID sfs_guid = EFI_SIMPLE_FILE_SYSTEM_PROTOCOL_GUID;
+    EFI_GUID edid_guid = EFI_EDID_DISCOVERED_PROTOCOL_GUID;
+
+    mock_live("handle_protocol", 0);
+    if (handle == &image_handle && guid_eq(proto, &lip_guid)) {
+        *iface = &image;
+        return EFI_SUCCESS;
+    }
+    if (handle == &device_handle && guid_eq(proto, &sfs_guid)) {
+        *iface = &sfs;
+        return EFI_SUCCESS;
+    }
+    if (handle == &gop_handle && guid_eq(proto, &edid_guid)) {
+        *iface = &edid;
+        return EFI_SUCCESS;
+    }
+
+    return EFI_UNSUPPORTED;
+}
+
+static efi_status_t __efiapi
+mock_locate_handle_buffer(EFI_LOCATE_SEARCH_TYPE type, EFI_GUID *proto,
+    void *key, uintn_t *nhandles, efi_handle_t **buf)
+{
+    EFI_GUID gop_guid = EFI_GRAPHICS_OUTPUT_PROTOCOL_GUID;
+    efi_status_t status;
+
+    mock_live("locate_handle_buffer", 0);
+    if (type != ByProtocol || nmodes == 0 || !guid_eq(proto, &gop_guid)) {
+        return EFI_NOT_FOUND;
+    }
+
+    /* The caller frees this with free_pool() */
+    status = mock_allocate_pool(EfiBootServicesData, sizeof(**buf),
+        (void **)buf);
+    if (EFI_ERROR(status)) {
+        return status;
+    }
+
+    (*buf)[0] = &gop_handle;
+    *nhandles = 1;
+    return EFI_SUCCESS;
+}
+
+static efi_status_t __efiapi
+mock_locate_protocol(EFI_GUID *proto, void *reg, void **iface)
+{
+    EFI_GUID gop_guid = EFI_GRAPHICS_OUTPUT_PROTOCOL_GUID;
+
+    mock_live("locate_protocol", 0);
+    if (nmodes > 0 && guid_eq(proto, &gop_guid)) {
+        *iface = &gop;
+        return EFI_SUCCESS;
+    }
+
+    /* No MP services, the loader runs on one CPU */
+    return EFI_NOT_FOUND;
+}
+
+static efi_status_t __efiapi
+mock_exit_boot_services(efi_handle_t handle, uintn_t key)
+{
+    efi_phys_addr_t addr;
+
+    mock_live("exit_boot_services", 1);
+    ++counts[MOCK_EXIT];
+    exiting = 1;
+
+    /*
+     * Pretend a timer event allocated memory between
+     * the last get_memory_map() and now.
+     */
+    if (fw.churn > 0) {
+        --fw.churn;
+        mock_alloc(AllocateAnyPages, EfiBootServicesData, 1, &addr);
+        return EFI_INVALID_PARAMETER;
+    }
+
+    if (handle != &image_handle || key != map_key) {
+        return EFI_INVALID_PARAMETER;
+    }
+
+    gone = 1;
+    return EFI_SUCCESS;
+}
+
+static efi_status_t __efiapi
+mock_stall(uintn_t us)
+{
+    struct timespec ts;
+
+    mock_live("stall", 0);
+    ++counts[MOCK_STALL];
+    stall_us += us;
+
+    ts.tv_sec = us / 1000000;
+    ts.tv_nsec = (us % 1000000) * 1000;
+    while (nanosleep(&ts, &ts) != 0);
+    return EFI_SUCCESS;
+}
+
+static efi_status_t __efiapi
+mock_set_watchdog_timer(uintn_t timeout, uint64_t code, uintn_t size,
+    uint16_t *data)
+{
+    mock_live("set_watchdog_timer", 0);
+    return EFI_SUCCESS;
+}
+
+static efi_status_t __efiapi
+mock_get_variable(uint16_t *name, EFI_GUID *guid, uint32_t *attr,
+    uintn_t *size, void *data)
+{
+    struct mock_var *vp;
+
+    for (size_t i = 0; i < MOCK_MAXVAR; ++i) {
+        vp = &vars[i];
+        if (vp->size == 0 || !ucs2_eq(vp->name, name) ||
+            !guid_eq(&vp->guid, guid)) {
+            continue;
+        }
+
+        if (attr != NULL) {
+            *attr = vp->attr;
+        }
+        if (*size < vp->size || data == NULL) {
+            *size = vp->size;
+            return EFI_BUFFER_TOO_SMALL;
+        }
+
+        memcpy(data, vp->data, vp->size);
+        *size = vp->size;
+        return EFI_SUCCESS;
+    }
+
+    return EFI_NOT_FOUND;
+}
+
+static efi_status_t __efiapi
+mock_set_variable(uint16_t *name, EFI_GUID *guid, uint32_t attr,
+    uintn_t size, void *data)
+{
+    struct mock_var *vp, *free_vp = NULL;
+    size_t len = ucs2_len(name);
+
+    if (size > MOCK_VARDATA || len >= MOCK_VARNAME) {
+        return EFI_OUT_OF_RESOURCES;
+    }
+
+    for (size_t i = 0; i < MOCK_MAXVAR; ++i) {
+        vp = &vars[i];
+        if (vp->size == 0) {
+            if (free_vp == NULL) {
+                free_vp = vp;
+            }
+            continue;
+        }
+
+        if (ucs2_eq(vp->name, name) && guid_eq(&vp->guid, guid)) {
+            free_vp = vp;
+            break;
+        }
+    }
+
+    /* A size of zero deletes */
+    if (free_vp == NULL) {
+        return (size == 0) ? EFI_NOT_FOUND : EFI_OUT_OF_RESOURCES;
+    }
+
+    memcpy(free_vp->name, name, (len + 1) * sizeof(uint16_t));
+    free_vp->guid = *guid;
+    free_vp->attr = attr;
+    free_vp->size = size;
+    memcpy(free_vp->data, data, size);
+    return EFI_SUCCESS;
+}
+
+static efi_status_t __efiapi
+mock_con_reset(EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL *this, BOOLEAN ext)
+{
+    mock_live("con_out->reset", 0);
+    return EFI_SUCCESS;
+}
+
+static efi_status_t __efiapi
+mock_con_output(EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL *this, uint16_t *s)
+{
+    int panic = ucs2_eq(s, L"\r\n!! l5 panic !!\r\n");
+
+    mock_live("con_out->output_string", 0);
+    for (; *s != 0; ++s) {
+        if (*s == '\r') {
+            continue;
+        }
+        putchar(*s < 0x80 ? *s : '?');
+    }
+
+    /* die() spins forever, no use waiting for the watchdog */
+    if (panic) {
+        fflush(stdout);
+        exit(1);
+    }
+
+    return EFI_SUCCESS;
+}
+
+static efi_status_t __efiapi
+mock_con_in_reset(EFI_SIMPLE_TEXT_INPUT_PROTOCOL *this, BOOLEAN ext)
+{
+    mock_live("con_in->reset", 0);
+    return EFI_SUCCESS;
+}
+
+static efi_status_t __efiapi
+mock_read_key(EFI_SIMPLE_TEXT_INPUT_PROTOCOL *this, EFI_INPUT_KEY *key)
+{
+    /* Someone is always at the keyboard pressing enter */
+    mock_live("con_in->read_key_stroke", 0);
+    key->scan_code = 0;
+    key->unicode_char = L'\r';
+    return EFI_SUCCESS;
+}
+
+static struct mock_file *mock_file_new(int fd, const uint16_t *name);
+
+static efi_status_t __efiapi
+mock_file_open(EFI_FILE_PROTOCOL *this, EFI_FILE_PROTOCOL **res,
+    uint16_t *name, uint64_t mode, uint64_t attr)
+{
+    struct mock_file *dir = (struct mock_file *)this, *fp;
+    const uint16_t *start;
+    char path[MOCK_NAMELEN];
+    size_t len = 0;
+    int fd;
+
+    mock_live("file->open", 0);
+    ++counts[MOCK_FILE_OPEN];
+
+    if (ISSET(mode, EFI_FILE_MODE_WRITE | EFI_FILE_MODE_CREATE)) {
+        return EFI_WRITE_PROTECTED;
+    }
+
+    /* Paths are relative to the volume root either way */
+    while (*name == L'\\') {
+        ++name;
+    }
+    for (start = name; *name != 0; ++name) {
+        if (*name >= 0x80 || len >= sizeof(path) - 1) {
+            return EFI_NOT_FOUND;
+        }
+        path[len++] = (*name == L'\\') ? '/' : *name;
+    }
+    path[len] = '\0';
+
+    if (len == 0 || path[0] == '.') {
+        return EFI_NOT_FOUND;
+    }
+
+    fd = openat(dir->fd, path, O_RDONLY);
+    if (fd < 0) {
+        return EFI_NOT_FOUND;
+    }
+
+    if ((fp = mock_file_new(fd, start)) == NULL) {
+        close(fd);
+        return EFI_OUT_OF_RESOURCES;
+    }
+
+    *res = &fp->proto;
+    return EFI_SUCCESS;
+}
+
+static efi_status_t __efiapi
+mock_file_close(EFI_FILE_PROTOCOL *this)
+{
+    struct mock_file *fp = (struct mock_file *)this;
+
+    mock_live("file->close", 0);
+    close(fp->fd);
+    free(fp);
+    return EFI_SUCCESS;
+}
+
+static efi_status_t __efiapi
+mock_file_read(EFI_FILE_PROTOCOL *this, uintn_t *size, void *buf)
+{
+    struct mock_file *fp = (struct mock_file *)this;
+    uintn_t done = 0;
+    ssize_t n;
+
+    mock_live("file->read", 0);
+    ++counts[MOCK_FILE_READ];
+
+    while (done < *size) {
+        n = read(fp->fd, (uint8_t *)buf + done, *size - done);
+        if (n < 0) {
+            return EFI_DEVICE_ERROR;
+        }
+        if (n == 0) {
+            break;
+        }
+        done += n;
+    }
+
+    read_bytes += done;
+    *size = done;
+    return EFI_SUCCESS;
+}
+
+static efi_status_t __efiapi
+mock_file_get_position(EFI_FILE_PROTOCOL *this, uint64_t *pos)
+{
+    struct mock_file *fp = (struct mock_file *)this;
+    off_t off;
+
+    mock_live("file->get_position", 0);
+    if ((off = lseek(fp->fd, 0, SEEK_CUR)) < 0) {
+        return EFI_UNSUPPORTED;
+    }
+
+    *pos = off;
+    return EFI_SUCCESS;
+}
+
+static efi_status_t __efiapi
+mock_file_set_position(EFI_FILE_PROTOCOL *this, uint64_t pos)
+{
+    struct mock_file *fp = (struct mock_file *)this;
+
+    mock_live("file->set_position", 0);
+    if (pos == UINT64_MAX) {
+        return (lseek(fp->fd, 0, SEEK_END) < 0) ? EFI_UNSUPPORTED : 0;
+    }
+
+    return (lseek(fp->fd, pos, SEEK_SET) < 0) ? EFI_UNSUPPORTED : 0;
+}
+
+static efi_status_t __efiapi
+mock_file_get_info(EFI_FILE_PROTOCOL *this, EFI_GUID *type, uintn_t *size,
+    void *buf)
+{
+    EFI_GUID info_guid = EFI_FILE_INFO_ID;
+    struct mock_file *fp = (struct mock_file *)this;
+    EFI_FILE_INFO *info = buf;
+    size_t len = ucs2_len(fp->name);
+    uintn_t need;
+    struct stat st;
+
+    mock_live("file->get_info", 0);
+    if (!guid_eq(type, &info_guid)) {
+        return EFI_UNSUPPORTED;
+    }
+
+    /* The name makes the info variable length */
+    need = sizeof(*info) + (len + 1) * sizeof(uint16_t);
+    if (*size < need || buf == NULL) {
+        *size = need;
+        return EFI_BUFFER_TOO_SMALL;
+    }
+
+    if (fstat(fp->fd, &st) != 0) {
+        return EFI_DEVICE_ERROR;
+    }
+
+    memset(info, 0, need);
+    info->size = need;
+    info->file_size = st.st_size;
+    info->physical_size = ALIGN_UP(st.st_size, 512);
+    info->attribute = EFI_FILE_READ_ONLY;
+    if (S_ISDIR(st.st_mode)) {
+        info->attribute |= EFI_FILE_DIRECTORY;
+    }
+
+    memcpy(info->filename, fp->name, (len + 1) * sizeof(uint16_t));
+    *size = need;
+    return EFI_SUCCESS;
+}
+
+/*
+ * Wrap a host file descriptor in a file protocol
+ *
+ * @fd: Host file descriptor
+ * @name: Name it was opened with
+ */
+static struct mock_file *
+mock_file_new(int fd, const uint16_t *name)
+{
+    struct mock_file *fp;
+    size_t len = ucs2_len(name);
+
+    if (len >= MOCK_NAMELEN || (fp = calloc(1, sizeof(*fp))) == NULL) {
+        return NULL;
+    }
+
+    mock_fill(&fp->proto.open, &fp->proto + 1);
+    fp->proto.revision = EFI_FILE_PROTOCOL_REVISION2;
+    fp->proto.open = mock_file_open;
+    fp->proto.close = mock_file_close;
+    fp->proto.read = mock_file_read;
+    fp->proto.get_position = mock_file_get_position;
+    fp->proto.set_position = mock_file_set_position;
+    fp->proto.get_info = mock_file_get_info;
+    fp->fd = fd;
+    memcpy(fp->name, name, (len + 1) * sizeof(uint16_t));
+    return fp;
+}
+
+static efi_status_t __efiapi
+mock_open_volume(EFI_SIMPLE_FILE_SYSTEM_PROTOCOL *this,
+    EFI_FILE_PROTOCOL **res)
+{
+    struct mock_file *fp;
+    int fd;
+
+    mock_live("open_volume", 0);
+    fd = open(fw.root, O_RDONLY | O_DIRECTORY);
+    if (fd < 0) {
+        return EFI_VOLUME_CORRUPTED;
+    }
+
+    if ((fp = mock_file_new(fd, L"\\")) == NULL) {
+        close(fd);
+        return EFI_OUT_OF_RESOURCES;
+    }
+
+    *res = &fp->proto;
+    return EFI_SUCCESS;
+}
+
+static efi_status_t __efiapi
+mock_gop_query(EFI_GRAPHICS_OUTPUT_PROTOCOL *this, uint32_t mode,
+    uintn_t *size, EFI_GRAPHICS_OUTPUT_MODE_INFORMATION **info)
+{
+    efi_status_t status;
+
+    mock_live("gop->query_mode", 0);
+    if (mode >= nmodes) {
+        return EFI_INVALID_PARAMETER;
+    }
+
+    /* The caller frees this with free_pool() */
+    status = mock_allocate_pool(EfiBootServicesData, sizeof(**info),
+        (void **)info);
+    if (EFI_ERROR(status)) {
+        return status;
+    }
+
+    **info = modes[mode].info;
+    *size = sizeof(**info);
+    return EFI_SUCCESS;
+}
+
+static efi_status_t __efiapi
+mock_gop_set(EFI_GRAPHICS_OUTPUT_PROTOCOL *this, uint32_t mode)
+{
+    mock_live("gop->set_mode", 0);
+    if (mode >= nmodes ||
+        modes[mode].info.pixel_format == PixelBltOnly) {
+        return EFI_UNSUPPORTED;
+    }
+
+    /* Mode sets clear the screen */
+    gop_mode.mode = mode;
+    gop_mode.info = &modes[mode].info;
+    gop_mode.frame_buffer_size = modes[mode].fb_size;
+    memset((void *)gop_mode.frame_buffer_base, 0, modes[mode].fb_size);
+    return EFI_SUCCESS;
+}
+
+/*
+ * Add a GOP mode, the scanline is padded to 64 pixels
+ * as on a good deal of real hardware.
+ */
+static void
+mock_add_mode(uint32_t w, uint32_t h, EFI_GRAPHICS_PIXEL_FORMAT fmt)
+{
+    struct mock_mode *mp;
+
+    for (uint32_t i = 0; i < nmodes; ++i) {
+        mp = &modes[i];
+        if (mp->info.horizontal_resolution == w &&
+            mp->info.vertical_resolution == h) {
+            return;
+        }
+    }
+
+    if (nmodes >= ARRAY_SIZE(modes)) {
+        return;
+    }
+
+    mp = &modes[nmodes++];
+    mp->info.version = 0;
+    mp->info.horizontal_resolution = w;
+    mp->info.vertical_resolution = h;
+    mp->info.pixel_format = fmt;
+    mp->info.pixels_per_scan_line = ALIGN_UP(w, 64);
+    mp->fb_size = (uintn_t)mp->info.pixels_per_scan_line * h * 4;
+}
+
+/*
+ * Build an EDID base block whose preferred timing
+ * is the native mode.
+ */
+static void
+mock_edid_init(void)
+{
+    uint8_t *dtd = &edid_block[54];
+    uint8_t sum = 0;
+
+    memset(edid_block, 0, sizeof(edid_block));
+    memset(&edid_block[1], 0xFF, 6);
+    edid_block[18] = 1;             /* Version 1.4 */
+    edid_block[19] = 4;
+
+    dtd[0] = 0x02;                  /* Any non-zero pixel clock */
+    dtd[1] = 0x3A;
+    dtd[2] = fw.fb_width & 0xFF;
+    dtd[4] = (fw.fb_width >> 4) & 0xF0;
+    dtd[5] = fw.fb_height & 0xFF;
+    dtd[7] = (fw.fb_height >> 4) & 0xF0;
+
+    for (size_t i = 0; i < sizeof(edid_block) - 1; ++i) {
+        sum += edid_block[i];
+    }
+    edid_block[sizeof(edid_block) - 1] = -sum;
+
+    edid.size_of_edid = sizeof(edid_block);
+    edid.edid = edid_block;
+}
+
+/*
+ * Set up GOP with the native mode current, along with
+ * some common ones and one the loader must pass on.
+ * The display's EDID prefers the native mode.
+ *
+ * Returns zero on success
+ */
+static int
+mock_gop_init(void)
+{
+    uintn_t fb_size = 0;
+    void *fb;
+
+    mock_edid_init();
+
+    mock_add_mode(fw.fb_width, fw.fb_height,
+        PixelBlueGreenRedReserved8BitPerColor);
+    mock_add_mode(640, 480, PixelBlueGreenRedReserved8BitPerColor);
+    mock_add_mode(800, 600, PixelBltOnly);
+    mock_add_mode(1024, 768, PixelBlueGreenRedReserved8BitPerColor);
+    mock_add_mode(1280, 720, PixelRedGreenBlueReserved8BitPerColor);
+    mock_add_mode(1920, 1080, PixelBlueGreenRedReserved8BitPerColor);
+
+    for (uint32_t i = 0; i < nmodes; ++i) {
+        if (modes[i].fb_size > fb_size) {
+            fb_size = modes[i].fb_size;
+        }
+    }
+
+    fb_size = ALIGN_UP(fb_size, PAGESIZE);
+    fb = mmap((void *)HOST_FB_BASE, fb_size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if (fb != (void *)HOST_FB_BASE) {
+        return -1;
+    }
+
+    gop_mode.max_mode = nmodes;
+    gop_mode.mode = 0;
+    gop_mode.info = &modes[0].info;
+    gop_mode.size_of_info = sizeof(modes[0].info);
+    gop_mode.frame_buffer_base = HOST_FB_BASE;
+    gop_mode.frame_buffer_size = modes[0].fb_size;
+    mock_fill(&gop.query_mode, &gop.mode);
+    gop.query_mode = mock_gop_query;
+    gop.set_mode = mock_gop_set;
+    gop.mode = &gop_mode;
+    return 0;
+}
+
+/*
+ * Lay out physical memory like a small OVMF machine,
+ * firmware holds the top and the loader image sits
+ * at the bottom.
+ *
+ * Returns zero on success
+ */
+static int
+mock_mem_init(void)
+{
+    uint64_t top, npages = fw.ram_size / PAGESIZE;
+    void *ram;
+
+    ram = mmap((void *)HOST_RAM_BASE, fw.ram_size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED_NOREPLACE,
+        -1, 0);
+    if (ram != (void *)HOST_RAM_BASE) {
+        return -1;
+    }
+
+    map_insert(EfiConventionalMemory, HOST_RAM_BASE, npages, MEM_ATTR);
+    top = HOST_RAM_BASE + fw.ram_size;
+
+    map_set(HOST_RAM_BASE, 64, EfiLoaderCode);
+    map_set(top - 0x400000, 256, EfiBootServicesCode);
+    map_set(top - 0x300000, 512, EfiBootServicesData);
+    map_set(top - 0x100000, 64, EfiACPIReclaimMemory);
+    map_set(top - 0xC0000, 32, EfiACPIMemoryNVS);
+    map_set(top - 0xA0000, 80, EfiRuntimeServicesData);
+    map[map_find(top - 0xA0000, 80)].attr |= EFI_MEMORY_RUNTIME;
+
+    /* Device memory, never backed */
+    map_insert(EfiMemoryMappedIO, 0xFEC00000, 1, EFI_MEMORY_UC);
+    map_insert(EfiMemoryMappedIO, 0xFFC00000, 1024,
+        EFI_MEMORY_UC | EFI_MEMORY_RUNTIME);
+
+    image.image_base = ram;
+    image.image_size = 64 * PAGESIZE;
+    map_peak = nmap;
+    return 0;
+}
+
+EFI_SYSTEM_TABLE *
+host_efi_init(const struct host_fw *fwp, efi_handle_t *res)
+{
+    fw = *fwp;
+    if (mock_mem_init() != 0) {
+        fprintf(stderr, "host: could not map %lu MiB at %#x\n",
+            (unsigned long)(fw.ram_size >> 20), HOST_RAM_BASE);
+        return NULL;
+    }
+
+    if (fw.fb_width != 0 && mock_gop_init() != 0) {
+        fprintf(stderr, "host: could not map the framebuffer at %#x\n",
+            HOST_FB_BASE);
+        return NULL;
+    }
+
+    mock_fill(&bootsrv.raise_tpl, &bootsrv + 1);
+    bootsrv.hdr.signature = EFI_BOOT_SERVICES_SIGNATURE;
+    bootsrv.hdr.revision = EFI_BOOT_SERVICES_REVISION;
+    bootsrv.hdr.headerSize = sizeof(bootsrv);
+    bootsrv.allocate_pages = mock_allocate_pages;
+    bootsrv.free_pages = mock_free_pages;
+    bootsrv.get_memory_map = mock_get_memory_map;
+    bootsrv.allocate_pool = mock_allocate_pool;
+    bootsrv.free_pool = mock_free_pool;
+    bootsrv.handle_protocol = mock_handle_protocol;
+    bootsrv.locate_handle_buffer = mock_locate_handle_buffer;
+    bootsrv.locate_protocol = mock_locate_protocol;
+    bootsrv.exit_boot_services = mock_exit_boot_services;
+    bootsrv.Stall = mock_stall;
+    bootsrv.set_watchdog_timer = mock_set_watchdog_timer;
+
+    mock_fill(&rtsrv.get_time, &rtsrv + 1);
+    rtsrv.hdr.signature = EFI_RUNTIME_SERVICES_SIGNATURE;
+    rtsrv.hdr.revision = EFI_RUNTIME_SERVICES_REVISION;
+    rtsrv.hdr.headerSize = sizeof(rtsrv);
+    rtsrv.get_variable = mock_get_variable;
+    rtsrv.set_variable = mock_set_variable;
+
+    mock_fill(&con_out.reset, &con_out.node);
+    con_out.reset = mock_con_reset;
+    con_out.output_string = mock_con_output;
+    con_out.node = &con_mode;
+    con_in.reset = mock_con_in_reset;
+    con_in.read_key_stroke = mock_read_key;
+
+    sfs.revision = EFI_SIMPLE_FILE_SYSTEM_PROTOCOL_REVISION;
+    sfs.open_volume = mock_open_volume;
+    image.revision = EFI_LOADED_IMAGE_PROTOCOL_REVISION;
+    image.system_table = &systab;
+    image.device_handle = &device_handle;
+    image.image_code_type = EfiLoaderCode;
+    image.image_data_type = EfiLoaderData;
+
+    systab.hdr.signature = EFI_SYSTEM_TABLE_SIGNATURE;
+    systab.hdr.revision = EFI_SYSTEM_TABLE_REVISION;
+    systab.hdr.headerSize = sizeof(systab);
+    systab.firmware_vendor = L"L5 host";
+    systab.con_in = &con_in;
+    systab.con_out = &con_out;
+    systab.std_err = &con_out;
+    systab.runtime_services = &rtsrv;
+    systab.boot_services = &bootsrv;
+    systab.number_of_table_entries = 0;
+    systab.configuration_table = NULL;
+
+    *res = &image_handle;
+    return &systab;
+}
+
+void
+host_efi_stat(void)
+{
+    fprintf(stderr, "host: firmware calls:\n");
+    for (int i = 0; i < MOCK_NCALLS; ++i) {
+        if (counts[i] != 0) {
+            fprintf(stderr, "  %-20s %lu\n", mock_names[i],
+                (unsigned long)counts[i]);
+        }
+    }
+
+    fprintf(stderr, "host: %lu bytes read, %lu us stalled\n",
+        (unsigned long)read_bytes, (unsigned long)stall_us);
+    fprintf(stderr, "host: map key %lu, %zu descriptors (peak %zu)\n",
+        (unsigned long)map_key, nmap, map_peak);
+}
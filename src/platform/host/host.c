@@ -0,0 +1,397 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Runs the loader as a Linux process against the mock
+ * firmware in efi.c, for profiling it and for firmware
+ * edge cases that are hard to get out of QEMU:
+ *
+ *   l5-host [-m mib] [-d descsize] [-c churn] [-g WxH]
+ *           [-t seconds] root
+ *
+ * `root' stands in for the boot volume and must hold
+ * the kernel as `l5', and optionally an l5.cfg. The
+ * firmware console goes to stdout and the serial port
+ * to stderr. Instead of entering the kernel the page
+ * tables, the kernel image and protocol block are
+ * checked.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <unistd.h>
+#include <efi.h>
+#include <elf.h>
+#include <cdefs.h>
+#include <lfive/proto.h>
+#include <machine/cpu.h>
+#include <machine/host.h>
+
+/* Page table entry bits the walk looks at */
+#define PTE_ADDR_MASK   0x000FFFFFFFFFF000ULL
+#define PTE_P           BIT(0)
+#define PTE_PS          BIT(7)
+
+/* Default watchdog, die() spins forever */
+#define HOST_TIMEOUT    30
+
+#define PAGESIZE        4096
+
+int efi_main(efi_handle_t *hand, EFI_SYSTEM_TABLE *systab);
+
+static const char *root;
+
+static void
+usage(void)
+{
+    fprintf(stderr, "usage: l5-host [-m mib] [-d descsize] [-c churn] "
+        "[-g WxH] [-t seconds] root\n");
+    exit(2);
+}
+
+static void
+watchdog(int sig)
+{
+    static const char msg[] = "host: watchdog expired\n";
+
+    write(STDERR_FILENO, msg, sizeof(msg) - 1);
+    _exit(3);
+}
+
+/*
+ * Walk the page tables the kernel would be entered
+ * with, like the MMU would.
+ *
+ * @cr3: Physical address of the PML4
+ * @va: Virtual address to look up
+ * @pa: Physical address is written here
+ *
+ * Returns zero if `va' is mapped
+ */
+static int
+walk(uint64_t cr3, uint64_t va, uint64_t *pa)
+{
+    uint64_t *tbl, pte = cr3;
+    int shift = 39;
+
+    for (int level = 4; level > 0; --level, shift -= 9) {
+        tbl = (uint64_t *)(pte & PTE_ADDR_MASK);
+        pte = tbl[(va >> shift) & 0x1FF];
+        if (!ISSET(pte, PTE_P)) {
+            return -1;
+        }
+
+        if (level == 1 || (level < 4 && ISSET(pte, PTE_PS))) {
+            break;
+        }
+    }
+
+    *pa = (pte & PTE_ADDR_MASK & ~(BIT(shift) - 1)) | (va & (BIT(shift) - 1));
+    return 0;
+}
+
+/*
+ * Check that an address is mapped, printing where
+ *
+ * @cr3: Physical address of the PML4
+ * @what: What lives there
+ * @va: Virtual address to check
+ *
+ * Returns zero if it is mapped
+ */
+static int
+check_mapped(uint64_t cr3, const char *what, uint64_t va)
+{
+    uint64_t pa;
+
+    if (walk(cr3, va, &pa) != 0) {
+        fprintf(stderr, "host: %s at %#lx is not mapped\n", what,
+            (unsigned long)va);
+        return -1;
+    }
+
+    fprintf(stderr, "host: %-8s %#018lx -> %#lx\n", what,
+        (unsigned long)va, (unsigned long)pa);
+    return 0;
+}
+
+/*
+ * Read the kernel back from the boot volume
+ *
+ * @size_res: File size is written here
+ *
+ * Returns NULL on failure
+ */
+static uint8_t *
+read_kernel(size_t *size_res)
+{
+    char path[4096];
+    uint8_t *img;
+    FILE *fp;
+    long size;
+
+    snprintf(path, sizeof(path), "%s/l5", root);
+    fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return NULL;
+    }
+
+    if (fseek(fp, 0, SEEK_END) != 0 || (size = ftell(fp)) <= 0) {
+        fclose(fp);
+        return NULL;
+    }
+
+    img = malloc(size);
+    rewind(fp);
+    if (img == NULL || fread(img, 1, size, fp) != (size_t)size) {
+        free(img);
+        fclose(fp);
+        return NULL;
+    }
+
+    fclose(fp);
+    *size_res = size;
+    return img;
+}
+
+/*
+ * Check every loaded segment through the page tables,
+ * the file data must be there and the BSS must be zero
+ * even though the mock firmware hands out poisoned pages.
+ *
+ * @cr3: Physical address of the PML4
+ *
+ * Returns zero if it is sane
+ */
+static int
+check_kernel(uint64_t cr3)
+{
+    Elf64_Ehdr *ehdr;
+    Elf64_Phdr *phdr;
+    uint8_t *img, *p, want;
+    uint64_t va, pa;
+    size_t size, off, len, data = 0, bss = 0;
+
+    img = read_kernel(&size);
+    if (img == NULL) {
+        fprintf(stderr, "host: could not read the kernel back\n");
+        return -1;
+    }
+
+    ehdr = (Elf64_Ehdr *)img;
+    for (size_t i = 0; i < ehdr->e_phnum; ++i) {
+        phdr = (Elf64_Phdr *)(img + ehdr->e_phoff) + i;
+        if (phdr->p_type != PT_LOAD) {
+            continue;
+        }
+
+        for (off = 0; off < phdr->p_memsz; off += len) {
+            va = phdr->p_vaddr + off;
+            len = PAGESIZE - (va & (PAGESIZE - 1));
+            if (len > phdr->p_memsz - off) {
+                len = phdr->p_memsz - off;
+            }
+
+            if (walk(cr3, va, &pa) != 0) {
+                fprintf(stderr, "host: kernel at %#lx is not mapped\n",
+                    (unsigned long)va);
+                free(img);
+                return -1;
+            }
+
+            p = (uint8_t *)pa;
+            for (size_t j = 0; j < len; ++j) {
+                want = (off + j < phdr->p_filesz) ?
+                    img[phdr->p_offset + off + j] : 0;
+                if (p[j] != want) {
+                    fprintf(stderr, "host: kernel at %#lx is %#x, not %#x\n",
+                        (unsigned long)(va + j), p[j], want);
+                    free(img);
+                    return -1;
+                }
+            }
+        }
+
+        data += phdr->p_filesz;
+        bss += phdr->p_memsz - phdr->p_filesz;
+    }
+
+    fprintf(stderr, "host: kernel   %zu bytes of data, %zu of BSS\n", data,
+        bss);
+    free(img);
+    return 0;
+}
+
+/*
+ * Check the protocol block and list its tags
+ *
+ * Returns zero if it is sane
+ */
+static int
+check_proto(struct l5_proto *proto)
+{
+    struct l5_tag *tag;
+    uint8_t *end;
+
+    if (proto->magic != L5_PROTO_MAGIC ||
+        proto->version != L5_PROTO_VERSION) {
+        fprintf(stderr, "host: bad protocol header\n");
+        return -1;
+    }
+
+    if (proto->size > proto->budget) {
+        fprintf(stderr, "host: protocol block overran, %u of %u bytes\n",
+            proto->size, proto->budget);
+        return -1;
+    }
+
+    fprintf(stderr, "host: protocol block %u of %u bytes, %u tags\n",
+        proto->size, proto->budget, proto->ntags);
+
+    end = (uint8_t *)proto + proto->size;
+    tag = l5_tag_first(proto);
+    for (; tag != NULL; tag = l5_tag_next(tag)) {
+        if ((uint8_t *)tag + tag->size > end) {
+            fprintf(stderr, "host: tag %#x runs past the block\n",
+                tag->type);
+            return -1;
+        }
+
+        fprintf(stderr, "  tag %#04x %6u bytes\n", tag->type, tag->size);
+    }
+
+    return 0;
+}
+
+void
+host_handoff(struct cpu_handoff *hp)
+{
+    struct host_cpu_stat cpu;
+    int error = 0;
+
+    alarm(0);
+    fflush(stdout);
+    host_cpu_stat(&cpu);
+
+    fprintf(stderr, "host: handoff, cr3 %#lx, PAT %#lx, %zu invlpg\n",
+        (unsigned long)hp->cr3, (unsigned long)cpu.pat, cpu.ninvlpg);
+    error |= check_mapped(hp->cr3, "entry", hp->entry);
+    error |= check_mapped(hp->cr3, "stack", hp->stack - 8);
+
+    /* On the host the loader image sits above 4 GiB */
+    if (hp->gdtr.base < HOST_FB_BASE) {
+        error |= check_mapped(hp->cr3, "gdt", hp->gdtr.base);
+    }
+    error |= check_mapped(hp->cr3, "proto", hp->arg);
+    error |= check_kernel(hp->cr3);
+    error |= check_proto((struct l5_proto *)hp->arg);
+
+    host_efi_stat();
+    exit(error ? 1 : 0);
+}
+
+int
+main(int argc, char **argv)
+{
+    struct host_fw fw = {
+        .ram_size = HOST_RAM_DEFAULT,
+        .desc_size = 48,
+        .churn = 0,
+        .fb_width = 0,
+        .fb_height = 0
+    };
+    EFI_SYSTEM_TABLE *systab;
+    efi_handle_t image;
+    unsigned int timeout = HOST_TIMEOUT;
+    int c;
+
+    while ((c = getopt(argc, argv, "m:d:c:g:t:")) != -1) {
+        switch (c) {
+        case 'm':
+            fw.ram_size = strtoull(optarg, NULL, 0) << 20;
+            break;
+        case 'd':
+            fw.desc_size = strtoul(optarg, NULL, 0);
+            break;
+        case 'c':
+            fw.churn = strtoul(optarg, NULL, 0);
+            break;
+        case 'g':
+            if (sscanf(optarg, "%ux%u", &fw.fb_width, &fw.fb_height) != 2) {
+                usage();
+            }
+            break;
+        case 't':
+            timeout = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            usage();
+        }
+    }
+
+    if (optind != argc - 1) {
+        usage();
+    }
+
+    /* Descriptors only ever grow, in steps of 8 */
+    if (fw.desc_size < sizeof(EFI_MEMORY_DESCRIPTOR) ||
+        ISSET(fw.desc_size, 7)) {
+        fprintf(stderr, "host: bad descriptor size %lu\n",
+            (unsigned long)fw.desc_size);
+        return 2;
+    }
+
+    if (fw.ram_size < (16ULL << 20) ||
+        HOST_RAM_BASE + fw.ram_size > HOST_FB_BASE) {
+        fprintf(stderr, "host: memory must be 16 MiB to 3 GiB\n");
+        return 2;
+    }
+
+    if (fw.fb_width != 0 && (fw.fb_width < 320 || fw.fb_height < 200 ||
+        fw.fb_width > 7680 || fw.fb_height > 4320)) {
+        fprintf(stderr, "host: bad mode %ux%u\n", fw.fb_width,
+            fw.fb_height);
+        return 2;
+    }
+
+    fw.root = argv[optind];
+    root = fw.root;
+    systab = host_efi_init(&fw, &image);
+    if (systab == NULL) {
+        return 1;
+    }
+
+    signal(SIGALRM, watchdog);
+    alarm(timeout);
+    efi_main(image, systab);
+
+    fprintf(stderr, "host: efi_main returned\n");
+    return 1;
+}
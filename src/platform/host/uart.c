@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and L5 engineers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <unistd.h>
+#include <cdefs.h>
+#include <machine/uart.h>
+
+/*
+ * Any port will do, everything written goes to
+ * stderr so that the console and trace streams
+ * can be captured apart from the firmware console.
+ */
+
+static int uart_ok = 0;
+
+int
+uart_init(const char *port, uint32_t baud)
+{
+    if (port == NULL) {
+        return -1;
+    }
+
+    uart_ok = 1;
+    return 0;
+}
+
+void
+uart_puts(const uint16_t *s)
+{
+    char buf[256];
+    size_t len = 0;
+
+    if (!uart_ok) {
+        return;
+    }
+
+    for (; *s != 0; ++s) {
+        if (*s == '\r') {
+            continue;
+        }
+
+        buf[len++] = (*s < 0x80) ? *s : '?';
+        if (len == sizeof(buf)) {
+            uart_write(buf, len);
+            len = 0;
+        }
+    }
+
+    uart_write(buf, len);
+}
+
+void
+uart_write(const char *s, size_t len)
+{
+    ssize_t n;
+
+    if (!uart_ok) {
+        return;
+    }
+
+    while (len > 0 && (n = write(STDERR_FILENO, s, len)) > 0) {
+        s += n;
+        len -= n;
+    }
+}
+
+int
+uart_active(void)
+{
+    return uart_ok;
+}
@@ -0,0 +1,55 @@
+#!/usr/bin/env python3
+#
+# Turn the "@trace" lines L5 writes to the serial port with
+# trace=stream into Chrome trace JSON (chrome://tracing or
+# ui.perfetto.dev). Everything else in the capture is skipped.
+#
+# usage: trace2json.py serial.log > trace.json
+#
+
+import json
+import sys
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit("usage: trace2json.py <serial log>")
+
+    hz = None
+    base = None
+    events = []
+
+    with open(sys.argv[1], errors="replace") as f:
+        for line in f:
+            fields = line.split()
+            if not fields:
+                continue
+
+            if fields[0] == "@trace-hz" and len(fields) == 2:
+                hz = int(fields[1])
+            elif fields[0] == "@trace" and len(fields) == 5:
+                name, start, cycles, nbytes = fields[1], *map(int, fields[2:])
+                if base is None:
+                    base = start
+                events.append((name, start - base, cycles, nbytes))
+
+    if hz is None or hz == 0:
+        sys.exit("no @trace-hz line, was trace=stream set?")
+
+    us = 1e6 / hz
+    out = [{
+        "name": name,
+        "cat": "efi",
+        "ph": "X",
+        "ts": start * us,
+        "dur": cycles * us,
+        "pid": 0,
+        "tid": 0,
+        "args": {"bytes": nbytes, "cycles": cycles},
+    } for name, start, cycles, nbytes in events]
+
+    json.dump({"traceEvents": out, "displayTimeUnit": "ns"}, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()